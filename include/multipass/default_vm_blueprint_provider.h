@@ -30,6 +30,7 @@
 
 #include <chrono>
 #include <map>
+#include <mutex>
 
 namespace multipass
 {
@@ -66,6 +67,9 @@ private:
     std::map<std::string, YAML::Node> blueprint_map;
     bool needs_update{true};
     const QString arch;
+    // Public calls may come from several threads at once and can all end up refreshing the Blueprints. Recursive, as
+    // all_blueprints() goes through info_for()
+    std::recursive_mutex blueprints_mutex;
 };
 } // namespace multipass
 #endif // MULTIPASS_DEFAULT_VM_BLUEPRINT_PROVIDER_H
@@ -20,8 +20,14 @@
 
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
+#include <QString>
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <vector>
+
+class QLocalSocket;
 
 namespace multipass
 {
@@ -33,10 +39,27 @@ public:
     using UPtr = std::unique_ptr<NetworkAccessManager>;
 
     NetworkAccessManager(QObject* parent = nullptr);
+    ~NetworkAccessManager() override;
+
+    // Managers can only be used from the thread they live in; this makes one like this one for the calling thread
+    virtual UPtr make_for_current_thread() const;
 
 protected:
     QNetworkReply* createRequest(Operation op, const QNetworkRequest& orig_request,
                                  QIODevice* outgoingData = nullptr) override;
+
+private:
+    struct IdleSocket
+    {
+        std::unique_ptr<QLocalSocket> socket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    std::unique_ptr<QLocalSocket> take_idle_socket(const QString& socket_path);
+    void release_socket(const QString& socket_path, std::unique_ptr<QLocalSocket> socket);
+
+    // Connections to local sockets that the server kept open after the last reply, ready for the next request
+    std::map<QString, std::vector<IdleSocket>> idle_sockets;
 };
 } // namespace multipass
 
@@ -24,7 +24,7 @@
 #include "vm_image_info.h"
 
 #include <QByteArray>
-#include <QMap>
+#include <QHash>
 #include <QString>
 
 #include <memory>
@@ -39,9 +39,14 @@ struct SimpleStreamsManifest
     static std::unique_ptr<SimpleStreamsManifest>
     fromJson(const QByteArray& json, const std::optional<QByteArray>& json_from_mirror, const QString& host_url);
 
+    // Compact, versioned form of an already parsed manifest, with repeated strings stored once
+    static std::unique_ptr<SimpleStreamsManifest> fromBinary(const QByteArray& data);
+    QByteArray toBinary() const;
+
     const QString updated_at;
     const std::vector<VMImageInfo> products;
-    const QMap<QString, const VMImageInfo*> image_records;
+    const QHash<QString, const VMImageInfo*> image_records; // keyed by full hash and by alias
+    const std::vector<const VMImageInfo*> products_by_id;   // sorted by id, for hash prefix lookups
 };
 } // namespace multipass
 #endif // MULTIPASS_SIMPLE_STREAMS_MANIFEST_H
@@ -25,6 +25,10 @@
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <QFlags>
 
@@ -37,6 +41,15 @@ using SFTPSessionUPtr = std::unique_ptr<sftp_session_struct, std::function<void(
 
 SFTPSessionUPtr make_sftp_session(ssh_session session);
 
+struct SFTPTransferOptions
+{
+    // Number of reads kept in flight while pulling a file
+    unsigned window{16};
+    // Number of connections moving separate files, or parts of a large file, at once. Extra connections are only
+    // opened by clients that know how to log in, i.e. those constructed from host and credentials
+    unsigned streams{4};
+};
+
 class SFTPClient
 {
 public:
@@ -44,12 +57,15 @@ public:
     {
         Recursive = 1,
         MakeParent = 2,
+        Sync = 4,
+        Delete = 8,
     };
     Q_DECLARE_FLAGS(Flags, Flag)
 
     SFTPClient() = default;
-    SFTPClient(const std::string& host, int port, const std::string& username, const std::string& priv_key_blob);
-    SFTPClient(SSHSessionUPtr ssh_session);
+    SFTPClient(const std::string& host, int port, const std::string& username, const std::string& priv_key_blob,
+               const SFTPTransferOptions& options = {});
+    SFTPClient(SSHSessionUPtr ssh_session, const SFTPTransferOptions& options = {});
 
     virtual bool is_remote_dir(const fs::path& path);
     virtual bool push(const fs::path& source_path, const fs::path& target_path, Flags flags = {});
@@ -60,15 +76,34 @@ public:
     virtual ~SFTPClient() = default;
 
 private:
+    using SessionFactory = std::function<SSHSessionUPtr()>;
+    using FileTransfer = void (SFTPClient::*)(const fs::path&, const fs::path&);
+    using FilePairs = std::vector<std::pair<fs::path, fs::path>>;
+
+    SFTPClient(SSHSessionUPtr ssh_session, SessionFactory make_session, const SFTPTransferOptions& options);
+
     void push_file(const fs::path& source_path, const fs::path& target_path);
     void pull_file(const fs::path& source_path, const fs::path& target_path);
-    bool push_dir(const fs::path& source_path, const fs::path& target_path);
+    void sync_file(const fs::path& source_path, const fs::path& target_path);
+    bool push_dir(const fs::path& source_path, const fs::path& target_path, Flags flags);
     bool pull_dir(const fs::path& source_path, const fs::path& target_path);
+    bool transfer_files(const FilePairs& files, FileTransfer transfer);
+    bool in_parallel(std::size_t num_tasks, const std::function<void(SFTPClient&, std::size_t)>& task);
+    void push_in_parts(std::istream& source, const fs::path& source_path, const fs::path& target_path);
+    void push_part(const fs::path& source_path, const fs::path& target_path, uint64_t offset, uint64_t length);
+    std::optional<std::vector<std::string>> remote_block_digests(const fs::path& path);
+    void push_changed_blocks(const fs::path& source_path, const fs::path& target_path,
+                             const std::vector<std::string>& remote_digests);
+    bool delete_extraneous(const fs::path& target_path, const std::vector<std::string>& kept_paths);
     void do_push_file(std::istream& source, const fs::path& target_path);
     void do_pull_file(const fs::path& source_path, std::ostream& target);
 
     SSHSessionUPtr ssh_session;
     SFTPSessionUPtr sftp;
+    SessionFactory make_session;
+    SFTPTransferOptions options;
+    // Off while this client's connections are each moving whole files, so they are not spread any thinner
+    bool split_large_files{true};
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(SFTPClient::Flags)
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_SSH_SESSION_POOL_H
+#define MULTIPASS_SSH_SESSION_POOL_H
+
+#include <multipass/exceptions/ssh_exception.h>
+#include <multipass/ssh/ssh_session.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace multipass
+{
+class SSHKeyProvider;
+
+// Keeps authenticated sessions to instances around, so that querying an instance does not need a new connection and
+// handshake every time. A session is only used by one thread at a time, through a lease, and every command runs in a
+// channel of its own over it. Sessions that sit idle for too long are closed in the background.
+class SSHSessionPool
+{
+public:
+    class Lease
+    {
+    public:
+        Lease(Lease&& other);
+        ~Lease();
+
+        SSHSession& operator*() const;
+        SSHSession* operator->() const;
+
+        bool reused() const;
+        void discard(); // don't hand the session back, e.g. because it failed
+
+    private:
+        friend class SSHSessionPool;
+        Lease(SSHSessionPool* pool, const std::string& key, std::unique_ptr<SSHSession> session, bool reused);
+
+        SSHSessionPool* pool;
+        std::string key;
+        std::unique_ptr<SSHSession> session;
+        bool was_reused;
+    };
+
+    explicit SSHSessionPool(const SSHKeyProvider& key_provider,
+                            std::chrono::milliseconds max_idle = std::chrono::minutes(5));
+    ~SSHSessionPool();
+
+    Lease acquire(const std::string& host, int port, const std::string& username);
+
+    // Runs action with a session from the pool. If a reused session fails, it may well have been closed on the other
+    // end while idle (e.g. the instance restarted), so the action is tried again over a new connection.
+    template <typename Action>
+    auto run(const std::string& host, int port, const std::string& username, Action&& action);
+
+private:
+    struct IdleSession
+    {
+        std::unique_ptr<SSHSession> session;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    void release(const std::string& key, std::unique_ptr<SSHSession> session);
+    void drop_idle(const std::string& key);
+    std::vector<std::unique_ptr<SSHSession>> prune_locked();
+    void close_idle_sessions();
+
+    const SSHKeyProvider& key_provider;
+    const std::chrono::milliseconds max_idle;
+    std::mutex mutex;
+    std::condition_variable idle_changed;
+    bool stopping{false};
+    std::unordered_map<std::string, std::vector<IdleSession>> idle_sessions;
+    std::thread closer;
+};
+} // namespace multipass
+
+template <typename Action>
+auto multipass::SSHSessionPool::run(const std::string& host, int port, const std::string& username, Action&& action)
+{
+    {
+        auto lease = acquire(host, port, username);
+        try
+        {
+            return action(*lease);
+        }
+        catch (const SSHException&)
+        {
+            lease.discard();
+            if (!lease.reused())
+                throw;
+
+            drop_idle(lease.key);
+        }
+    }
+
+    return action(*acquire(host, port, username));
+}
+#endif // MULTIPASS_SSH_SESSION_POOL_H
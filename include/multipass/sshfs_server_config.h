@@ -26,6 +26,18 @@
 namespace multipass
 {
 
+struct SftpServerOptions
+{
+    // Number of threads servicing requests, 0 means requests are handled one at a time on the reading thread
+    int worker_threads{0};
+    // Maximum number of attributes and directory listings kept around, 0 disables the cache
+    std::size_t attr_cache_entries{0};
+    // Maximum number of entries in each readdir reply, 0 means as many as fit in one message
+    std::size_t readdir_max_entries{0};
+    // Size up to which adjacent writes on a handle are buffered before hitting the file, 0 writes straight through
+    std::size_t write_behind_bytes{0};
+};
+
 struct SSHFSServerConfig
 {
     std::string host;
@@ -29,6 +29,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
 
 #define MP_NETMGRFACTORY multipass::NetworkManagerFactory::instance()
 
@@ -49,9 +50,14 @@ class URLDownloader : private DisabledCopyMove
 public:
     URLDownloader(std::chrono::milliseconds timeout);
     URLDownloader(const Path& cache_dir, std::chrono::milliseconds timeout);
+    // Receives downloaded data as it arrives; throwing from it stops the download and the exception is passed on
+    using DataSink = std::function<void(const QByteArray& data)>;
+
     virtual ~URLDownloader() = default;
     virtual void download_to(const QUrl& url, const QString& file_name, int64_t size, const int download_type,
                              const ProgressMonitor& monitor);
+    virtual void stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                           const ProgressMonitor& monitor);
     virtual QByteArray download(const QUrl& url);
     virtual QDateTime last_modified(const QUrl& url);
     virtual void abort_all_downloads();
@@ -127,6 +127,9 @@ QString make_uuid();
 template <typename OnTimeoutCallable, typename TryAction, typename... Args>
 void try_action_for(OnTimeoutCallable&& on_timeout, std::chrono::milliseconds timeout, TryAction&& try_action,
                     Args&&... args);
+template <typename OnTimeoutCallable, typename TryAction, typename... Args>
+void try_action_every(std::chrono::milliseconds interval, OnTimeoutCallable&& on_timeout,
+                      std::chrono::milliseconds timeout, TryAction&& try_action, Args&&... args);
 
 } // namespace utils
 
@@ -148,6 +151,7 @@ public:
     // virtual machine helpers
     virtual void wait_for_cloud_init(VirtualMachine* virtual_machine, std::chrono::milliseconds timeout,
                                      const SSHKeyProvider& key_provider) const;
+    virtual bool is_ssh_answering(const std::string& hostname, int port, std::chrono::milliseconds timeout) const;
 
     // system info helpers
     virtual std::string get_kernel_version() const;
@@ -161,9 +165,17 @@ template <typename OnTimeoutCallable, typename TryAction, typename... Args>
 void multipass::utils::try_action_for(OnTimeoutCallable&& on_timeout, std::chrono::milliseconds timeout,
                                       TryAction&& try_action, Args&&... args)
 {
+    using namespace std::literals::chrono_literals;
+
+    try_action_every(1s, std::forward<OnTimeoutCallable>(on_timeout), timeout, std::forward<TryAction>(try_action),
+                     std::forward<Args>(args)...);
+}
 
+template <typename OnTimeoutCallable, typename TryAction, typename... Args>
+void multipass::utils::try_action_every(std::chrono::milliseconds interval, OnTimeoutCallable&& on_timeout,
+                                        std::chrono::milliseconds timeout, TryAction&& try_action, Args&&... args)
+{
     static_assert(std::is_same<decltype(try_action(std::forward<Args>(args)...)), TimeoutAction>::value, "");
-    using namespace std::literals::chrono_literals;
 
     auto deadline = std::chrono::steady_clock::now() + timeout;
     while (std::chrono::steady_clock::now() < deadline)
@@ -171,8 +183,8 @@ void multipass::utils::try_action_for(OnTimeoutCallable&& on_timeout, std::chron
         if (try_action(std::forward<Args>(args)...) == TimeoutAction::done)
             return;
 
-        // The < 1s is used for testing so unit tests don't have to sleep to 1 second
-        std::this_thread::sleep_for(timeout < 1s ? timeout : 1s);
+        // The < interval is used for testing so unit tests don't have to sleep for a whole interval
+        std::this_thread::sleep_for(timeout < interval ? timeout : interval);
     }
     on_timeout();
 }
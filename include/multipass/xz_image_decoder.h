@@ -21,7 +21,9 @@
 #include <multipass/path.h>
 #include <multipass/progress_monitor.h>
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <QFile>
 
@@ -38,9 +40,45 @@ public:
 
     using XzDecoderUPtr = std::unique_ptr<xz_dec, decltype(xz_dec_end)*>;
 
+    struct Block
+    {
+        qint64 offset;
+        qint64 size; // including padding
+        qint64 unpadded_size;
+        qint64 decoded_offset;
+        qint64 decoded_size;
+    };
+
+    // The blocks listed in the file's index, which can be decoded independently. Empty if the index is unusable
+    std::vector<Block> blocks();
+
 private:
+    std::vector<Block> read_blocks();
+    void decode_blocks_to(const Path& decoded_file_path, const std::vector<Block>& blocks,
+                          const ProgressMonitor& monitor);
+    void decode_stream_to(const Path& decoded_file_path, const ProgressMonitor& monitor);
+
     QFile xz_file;
-    XzDecoderUPtr xz_decoder;
+    QByteArray stream_header;
+};
+
+// Decodes xz data as it is handed in, e.g. as it arrives from the network, writing the result to decoded_file_path
+class XzStreamDecoder
+{
+public:
+    explicit XzStreamDecoder(const Path& decoded_file_path);
+
+    // Returns whether the end of the xz stream was reached; anything past it is ignored
+    bool decode(const char* data, std::size_t size);
+    // Throws if the data handed in so far did not make up a whole xz stream
+    void finish();
+
+private:
+    QFile decoded_file;
+    XzImageDecoder::XzDecoderUPtr xz_decoder;
+    std::vector<unsigned char> write_data;
+    qint64 decoded_size{0};
+    bool stream_ended{false};
 };
 } // namespace multipass
 #endif // MULTIPASS_XZ_IMAGE_DECODER_H
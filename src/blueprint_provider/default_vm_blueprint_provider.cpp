@@ -106,6 +106,7 @@ mp::Query mp::DefaultVMBlueprintProvider::fetch_blueprint_for(const std::string&
                                                               VirtualMachineDescription& vm_desc,
                                                               ClientLaunchData& client_launch_data)
 {
+    std::lock_guard<std::recursive_mutex> lock{blueprints_mutex};
     update_blueprints();
 
     Query query{"", "default", false, "", Query::Type::Alias};
@@ -265,6 +266,7 @@ mp::Query mp::DefaultVMBlueprintProvider::fetch_blueprint_for(const std::string&
 
 mp::VMImageInfo mp::DefaultVMBlueprintProvider::info_for(const std::string& blueprint_name)
 {
+    std::lock_guard<std::recursive_mutex> lock{blueprints_mutex};
     update_blueprints();
 
     static constexpr auto missing_key_template{"The \'{}\' key is required for the {} Blueprint"};
@@ -331,6 +333,7 @@ mp::VMImageInfo mp::DefaultVMBlueprintProvider::info_for(const std::string& blue
 
 std::vector<mp::VMImageInfo> mp::DefaultVMBlueprintProvider::all_blueprints()
 {
+    std::lock_guard<std::recursive_mutex> lock{blueprints_mutex};
     update_blueprints();
 
     bool will_need_update{false};
@@ -364,6 +367,7 @@ std::vector<mp::VMImageInfo> mp::DefaultVMBlueprintProvider::all_blueprints()
 
 std::string mp::DefaultVMBlueprintProvider::name_from_blueprint(const std::string& blueprint_name)
 {
+    std::lock_guard<std::recursive_mutex> lock{blueprints_mutex};
     if (blueprint_map.count(blueprint_name) == 1)
         return blueprint_name;
 
@@ -372,6 +376,8 @@ std::string mp::DefaultVMBlueprintProvider::name_from_blueprint(const std::strin
 
 int mp::DefaultVMBlueprintProvider::blueprint_timeout(const std::string& blueprint_name)
 {
+    std::lock_guard<std::recursive_mutex> lock{blueprints_mutex};
+
     auto timeout_seconds{0};
 
     try
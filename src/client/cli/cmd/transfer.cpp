@@ -127,12 +127,23 @@ mp::ParseCode cmd::Transfer::parse_args(mp::ArgParser* parser)
                                   "<destination>");
     parser->addOption({{"r", "recursive"}, "Recursively copy entire directories"});
     parser->addOption({{"p", "parents"}, "Make parent directories as needed"});
+    parser->addOption({"sync", "Only send files, and parts of files, that differ from those already in the instance"});
+    parser->addOption({"delete", "Delete files in the instance that are not in the source directories (requires "
+                                 "--sync)"});
 
     if (auto status = parser->commandParse(this); status != ParseCode::Ok)
         return status;
 
     flags.setFlag(SFTPClient::Flag::Recursive, parser->isSet("r"));
     flags.setFlag(SFTPClient::Flag::MakeParent, parser->isSet("p"));
+    flags.setFlag(SFTPClient::Flag::Sync, parser->isSet("sync"));
+    flags.setFlag(SFTPClient::Flag::Delete, parser->isSet("delete"));
+
+    if (parser->isSet("delete") && !parser->isSet("sync"))
+    {
+        term->cerr() << "Option --delete requires --sync\n";
+        return ParseCode::CommandLineError;
+    }
 
     auto positionalArgs = parser->positionalArguments();
     if (positionalArgs.size() < 2)
@@ -149,10 +160,18 @@ mp::ParseCode cmd::Transfer::parse_args(mp::ArgParser* parser)
     const auto full_target = positionalArgs.takeLast();
     const auto& full_sources = positionalArgs;
 
-    if (const auto ret_opt = parse_streaming(full_sources, full_target, split_sources, split_target); ret_opt)
-        return ret_opt.value();
+    const auto ret_opt = parse_streaming(full_sources, full_target, split_sources, split_target);
+    if (const auto ret = ret_opt ? ret_opt.value() : parse_non_streaming(split_sources, split_target);
+        ret != ParseCode::Ok)
+        return ret;
 
-    return parse_non_streaming(split_sources, split_target);
+    if (parser->isSet("sync") && !std::holds_alternative<LocalSourcesInstanceTarget>(arguments))
+    {
+        term->cerr() << "Option --sync is only supported when copying from the host into an instance\n";
+        return ParseCode::CommandLineError;
+    }
+
+    return ParseCode::Ok;
 }
 
 std::vector<std::pair<std::string, fs::path>> cmd::Transfer::args_to_instance_and_path(const QStringList& args)
@@ -25,6 +25,8 @@
 #include <multipass/exceptions/unsupported_alias_exception.h>
 #include <multipass/exceptions/unsupported_remote_exception.h>
 
+#include <QtConcurrent/QtConcurrent>
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 
@@ -41,6 +43,7 @@ mp::CommonVMImageHost::CommonVMImageHost(std::chrono::seconds manifest_time_to_l
     QObject::connect(&manifest_single_shot, &QTimer::timeout, [this]() {
         try
         {
+            std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
             update_manifests();
         }
         catch (const std::exception& e)
@@ -55,6 +58,7 @@ mp::CommonVMImageHost::CommonVMImageHost(std::chrono::seconds manifest_time_to_l
 
 void mp::CommonVMImageHost::for_each_entry_do(const Action& action)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
     update_manifests();
 
     for_each_entry_do_impl(action);
@@ -62,6 +66,7 @@ void mp::CommonVMImageHost::for_each_entry_do(const Action& action)
 
 auto mp::CommonVMImageHost::info_for_full_hash(const std::string& full_hash) -> VMImageInfo
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
     update_manifests();
 
     return info_for_full_hash_impl(full_hash);
@@ -72,15 +77,38 @@ void mp::CommonVMImageHost::update_manifests()
     const auto now = std::chrono::steady_clock::now();
     if ((now - last_update) > manifest_time_to_live || need_extra_update)
     {
-        need_extra_update = false;
-
-        clear();
-        fetch_manifests();
-
-        last_update = now;
+        // Only block the caller when there is nothing to serve yet; otherwise keep serving what we have while a
+        // refresh runs in the background
+        if (!has_manifests())
+        {
+            need_extra_update = false;
+            fetch_manifests();
+            last_update = now;
+        }
+        else if (!manifest_refresh.isRunning())
+        {
+            need_extra_update = false;
+            last_update = now;
+            manifest_refresh = QtConcurrent::run([this] {
+                try
+                {
+                    fetch_manifests();
+                }
+                catch (const std::exception& e)
+                {
+                    need_extra_update = true;
+                    mpl::log(mpl::Level::error, category, e.what());
+                }
+            });
+        }
     }
 }
 
+void mp::CommonVMImageHost::wait_for_manifest_refresh()
+{
+    manifest_refresh.waitForFinished();
+}
+
 void mp::CommonVMImageHost::on_manifest_empty(const std::string& details)
 {
     mpl::log(mpl::Level::info, category, details);
@@ -20,10 +20,13 @@
 
 #include "multipass/vm_image_host.h"
 
+#include <QFuture>
 #include <QStringList>
 #include <QTimer>
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
 
 namespace multipass
 {
@@ -37,6 +40,7 @@ public:
 
 protected:
     void update_manifests();
+    void wait_for_manifest_refresh();
     void on_manifest_update_failure(const std::string& details);
     void on_manifest_empty(const std::string& details);
     void check_remote_is_supported(const std::string& remote_name) const;
@@ -45,13 +49,23 @@ protected:
 
     virtual void for_each_entry_do_impl(const Action& action) = 0;
     virtual VMImageInfo info_for_full_hash_impl(const std::string& full_hash) = 0;
-    virtual void clear() = 0;
+    virtual bool has_manifests() const = 0;
+
+    // Downloads and parses, then swaps the results in under manifest_mutex. Background refreshes call this without
+    // holding the mutex, so that readers carry on meanwhile; the first fetch, when there is nothing to serve yet, is
+    // made inline by a caller that already holds it. Remotes that fail to update keep the manifest they had.
     virtual void fetch_manifests() = 0;
 
+    // Held for the whole of each public call, so that manifests are not replaced while they are being read. Public
+    // calls can nest, hence recursive.
+    std::recursive_mutex manifest_mutex;
+
+    const std::chrono::seconds manifest_time_to_live;
+
 private:
-    std::chrono::seconds manifest_time_to_live;
     std::chrono::steady_clock::time_point last_update;
-    bool need_extra_update = true;
+    std::atomic_bool need_extra_update{true};
+    QFuture<void> manifest_refresh;
     QTimer manifest_single_shot;
 };
 
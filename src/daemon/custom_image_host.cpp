@@ -212,8 +212,15 @@ mp::CustomVMImageHost::CustomVMImageHost(const QString& arch, URLDownloader* dow
 {
 }
 
+mp::CustomVMImageHost::~CustomVMImageHost()
+{
+    wait_for_manifest_refresh();
+}
+
 std::optional<mp::VMImageInfo> mp::CustomVMImageHost::info_for(const Query& query)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     check_alias_is_supported(query.release, query.remote_name);
 
     auto custom_manifest = manifest_from(query.remote_name);
@@ -228,6 +235,8 @@ std::optional<mp::VMImageInfo> mp::CustomVMImageHost::info_for(const Query& quer
 
 std::vector<std::pair<std::string, mp::VMImageInfo>> mp::CustomVMImageHost::all_info_for(const Query& query)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     std::vector<std::pair<std::string, mp::VMImageInfo>> images;
 
     auto image = info_for(query);
@@ -245,6 +254,8 @@ mp::VMImageInfo mp::CustomVMImageHost::info_for_full_hash_impl(const std::string
 std::vector<mp::VMImageInfo> mp::CustomVMImageHost::all_images_for(const std::string& remote_name,
                                                                    const bool allow_unsupported)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     std::vector<mp::VMImageInfo> images;
     auto custom_manifest = manifest_from(remote_name);
 
@@ -276,6 +287,8 @@ std::vector<std::string> mp::CustomVMImageHost::supported_remotes()
 
 void mp::CustomVMImageHost::fetch_manifests()
 {
+    std::unordered_map<std::string, std::unique_ptr<CustomManifest>> fetched;
+
     for (const auto& spec : {std::make_pair(no_remote, multipass_image_info[arch]),
                              std::make_pair(snapcraft_remote, snapcraft_image_info[arch])})
     {
@@ -283,7 +296,7 @@ void mp::CustomVMImageHost::fetch_manifests()
         {
             check_remote_is_supported(spec.first);
 
-            custom_image_info.emplace(spec.first, full_image_info_for(spec.second, url_downloader));
+            fetched.emplace(spec.first, full_image_info_for(spec.second, url_downloader));
         }
         catch (mp::DownloadException& e)
         {
@@ -294,11 +307,17 @@ void mp::CustomVMImageHost::fetch_manifests()
             continue;
         }
     }
+
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
+    // Remotes that failed to update keep their previous manifest
+    for (auto& [remote_name, manifest] : fetched)
+        custom_image_info[remote_name] = std::move(manifest);
 }
 
-void mp::CustomVMImageHost::clear()
+bool mp::CustomVMImageHost::has_manifests() const
 {
-    custom_image_info.clear();
+    return !custom_image_info.empty();
 }
 
 mp::CustomManifest* mp::CustomVMImageHost::manifest_from(const std::string& remote_name)
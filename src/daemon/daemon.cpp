@@ -17,6 +17,7 @@
 
 #include "daemon.h"
 #include "base_cloud_init_config.h"
+#include "instance_queries.h"
 #include "instance_settings_handler.h"
 
 #include <multipass/alias_definition.h>
@@ -85,6 +86,9 @@ constexpr auto category = "daemon";
 constexpr auto instance_db_name = "multipassd-vm-instances.json";
 constexpr auto reboot_cmd = "sudo reboot";
 constexpr auto stop_ssh_cmd = "sudo systemctl stop ssh";
+constexpr auto max_instance_queries = 16;
+constexpr auto instance_query_timeout = 5s;
+constexpr auto max_instances_per_launch = 32;
 const std::string sshfs_error_template = "Error enabling mount support in '{}'"
                                          "\n\nPlease install the 'multipass-sshfs' snap manually inside the instance.";
 
@@ -220,6 +224,111 @@ auto name_from(const std::string& requested_name, const std::string& blueprint_n
     }
 }
 
+template <typename T>
+std::vector<std::string> names_from(const mp::LaunchRequest* request, const std::string& blueprint_name,
+                                    mp::NameGenerator& name_gen, const T& currently_used_names)
+{
+    if (request->instance_names_size() > 0)
+    {
+        if (!request->instance_name().empty() || request->num_instances() > 1)
+            throw std::runtime_error("instance names cannot be combined with an instance name or count");
+
+        return {request->instance_names().begin(), request->instance_names().end()};
+    }
+
+    auto name = name_from(request->instance_name(), blueprint_name, name_gen, currently_used_names);
+    if (request->num_instances() <= 1)
+        return {name};
+
+    std::vector<std::string> names;
+    if (!request->instance_name().empty() || !blueprint_name.empty())
+    {
+        for (int i = 1; i <= request->num_instances(); ++i)
+            names.push_back(fmt::format("{}-{}", name, i));
+
+        return names;
+    }
+
+    std::unordered_set<std::string> used_names{name};
+    for (const auto& entry : currently_used_names)
+        used_names.insert(entry.first);
+
+    names.push_back(name);
+    constexpr int num_retries = 100;
+    for (int i = 0; i < num_retries && names.size() < static_cast<size_t>(request->num_instances()); i++)
+    {
+        auto next_name = name_gen.make_name();
+        if (used_names.insert(next_name).second)
+            names.push_back(next_name);
+    }
+
+    if (names.size() < static_cast<size_t>(request->num_instances()))
+        throw std::runtime_error("unable to generate unique names");
+
+    return names;
+}
+
+// The aliases a blueprint defines each name a single instance, so a batch launched from it would have them clash
+bool blueprint_defines_aliases(mp::VMBlueprintProvider& blueprint_provider, const std::string& blueprint_name)
+{
+    mp::VirtualMachineDescription vm_desc{};
+    mp::ClientLaunchData client_launch_data;
+
+    try
+    {
+        blueprint_provider.fetch_blueprint_for(blueprint_name, vm_desc, client_launch_data);
+    }
+    catch (const std::exception&)
+    {
+        return false; // Not a blueprint, or one the launch itself will report problems with
+    }
+
+    return !client_launch_data.aliases_to_be_created.empty();
+}
+
+// Lets the instances of a batch launch share the client's stream: writes are serialized and, when the writer is for a
+// single instance, the replies are tagged with its name.
+class BatchReplyWriter : public grpc::ServerReaderWriterInterface<mp::LaunchReply, mp::LaunchRequest>
+{
+public:
+    BatchReplyWriter(grpc::ServerReaderWriterInterface<mp::LaunchReply, mp::LaunchRequest>* server, std::mutex& mutex,
+                     const std::string& instance_name = {})
+        : server{server}, mutex{mutex}, instance_name{instance_name}
+    {
+    }
+
+    void SendInitialMetadata() override
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        server->SendInitialMetadata();
+    }
+
+    bool Write(const mp::LaunchReply& msg, grpc::WriteOptions options) override
+    {
+        auto reply = msg;
+        if (!instance_name.empty())
+            reply.set_instance_name(instance_name);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        return server->Write(reply, options);
+    }
+
+    bool NextMessageSize(uint32_t* sz) override
+    {
+        return server->NextMessageSize(sz);
+    }
+
+    bool Read(mp::LaunchRequest* msg) override
+    {
+        return server->Read(msg);
+    }
+
+private:
+    grpc::ServerReaderWriterInterface<mp::LaunchReply, mp::LaunchRequest>* server;
+    std::mutex& mutex;
+    const std::string instance_name;
+};
+
 std::vector<mp::NetworkInterface> read_extra_interfaces(const QJsonObject& record)
 {
     // Read the extra networks interfaces, if any.
@@ -521,7 +630,9 @@ auto validate_create_arguments(const mp::LaunchRequest* request, const mp::Daemo
         }
     }
 
-    if (!instance_name.empty() && !mp::utils::valid_hostname(instance_name))
+    if ((!instance_name.empty() && !mp::utils::valid_hostname(instance_name)) ||
+        std::any_of(request->instance_names().begin(), request->instance_names().end(),
+                    [](const auto& name) { return !mp::utils::valid_hostname(name); }))
         option_errors.add_error_codes(mp::LaunchError::INVALID_HOSTNAME);
 
     std::vector<std::string> nets_need_bridging;
@@ -561,12 +672,17 @@ auto grpc_status_for(fmt::memory_buffer& errors)
 
 auto connect_rpc(mp::DaemonRpc& rpc, mp::Daemon& daemon)
 {
+    // Read-only RPCs run directly on the gRPC thread that received them, so that they neither wait for nor hold up
+    // the daemon's thread. The rest are queued to it, one at a time. That includes networks, whose health check can
+    // reset the backend's connection to its hypervisor.
+    QObject::connect(&rpc, &mp::DaemonRpc::on_find, &daemon, &mp::Daemon::find, Qt::DirectConnection);
+    QObject::connect(&rpc, &mp::DaemonRpc::on_info, &daemon, &mp::Daemon::info, Qt::DirectConnection);
+    QObject::connect(&rpc, &mp::DaemonRpc::on_list, &daemon, &mp::Daemon::list, Qt::DirectConnection);
+    QObject::connect(&rpc, &mp::DaemonRpc::on_version, &daemon, &mp::Daemon::version, Qt::DirectConnection);
+
     QObject::connect(&rpc, &mp::DaemonRpc::on_create, &daemon, &mp::Daemon::create);
     QObject::connect(&rpc, &mp::DaemonRpc::on_launch, &daemon, &mp::Daemon::launch);
     QObject::connect(&rpc, &mp::DaemonRpc::on_purge, &daemon, &mp::Daemon::purge);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_find, &daemon, &mp::Daemon::find);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_info, &daemon, &mp::Daemon::info);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_list, &daemon, &mp::Daemon::list);
     QObject::connect(&rpc, &mp::DaemonRpc::on_networks, &daemon, &mp::Daemon::networks);
     QObject::connect(&rpc, &mp::DaemonRpc::on_mount, &daemon, &mp::Daemon::mount);
     QObject::connect(&rpc, &mp::DaemonRpc::on_recover, &daemon, &mp::Daemon::recover);
@@ -577,7 +693,6 @@ auto connect_rpc(mp::DaemonRpc& rpc, mp::Daemon& daemon)
     QObject::connect(&rpc, &mp::DaemonRpc::on_restart, &daemon, &mp::Daemon::restart);
     QObject::connect(&rpc, &mp::DaemonRpc::on_delete, &daemon, &mp::Daemon::delet);
     QObject::connect(&rpc, &mp::DaemonRpc::on_umount, &daemon, &mp::Daemon::umount);
-    QObject::connect(&rpc, &mp::DaemonRpc::on_version, &daemon, &mp::Daemon::version);
     QObject::connect(&rpc, &mp::DaemonRpc::on_get, &daemon, &mp::Daemon::get);
     QObject::connect(&rpc, &mp::DaemonRpc::on_set, &daemon, &mp::Daemon::set);
     QObject::connect(&rpc, &mp::DaemonRpc::on_keys, &daemon, &mp::Daemon::keys);
@@ -861,10 +976,21 @@ register_instance_mod(std::unordered_map<std::string, mp::VMSpecs>& vm_instance_
         vm_instance_specs, vm_instances, deleted_instances, preparing_instances, std::move(instance_persister)));
 }
 
+// Waits for earlier queries on the same instance to be done, giving up along with the query itself
+bool take_turn_querying(std::unique_lock<std::timed_mutex>& vm_query_lock, const std::function<bool()>& publish)
+{
+    while (!vm_query_lock.try_lock_for(100ms))
+        if (!publish())
+            return false;
+
+    return publish();
+}
+
 } // namespace
 
 mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
     : config{std::move(the_config)},
+      ssh_session_pool{*config->ssh_key_provider},
       vm_instance_specs{load_db(
           mp::utils::backend_directory_path(config->data_directory, config->factory->get_backend_directory_name()),
           mp::utils::backend_directory_path(config->cache_directory, config->factory->get_backend_directory_name()))},
@@ -873,6 +999,7 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
                                                  preparing_instances, [this] { persist_instances(); })}
 {
     connect_rpc(daemon_rpc, *this);
+    instance_query_pool.setMaxThreadCount(max_instance_queries);
     std::vector<std::string> invalid_specs;
 
     try
@@ -884,6 +1011,9 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
         mpl::log(mpl::Level::warning, category, fmt::format("Hypervisor health check failed: {}", e.what()));
     }
 
+    // Read-only RPCs wait for the instances to be loaded. These are only being set up, not started, so none of them
+    // reports a state change back while this is held.
+    std::unique_lock<decltype(instances_mutex)> loading_lock{instances_mutex};
     for (auto& entry : vm_instance_specs)
     {
         const auto& name = entry.first;
@@ -968,6 +1098,7 @@ mp::Daemon::Daemon(std::unique_ptr<const DaemonConfig> the_config)
         mpl::log(mpl::Level::warning, category, fmt::format("Removing invalid instance: {}", bad_spec));
         vm_instance_specs.erase(bad_spec);
     }
+    loading_lock.unlock();
 
     if (!invalid_specs.empty())
         persist_instances();
@@ -1052,7 +1183,7 @@ catch (const mp::StartException& e)
     auto name = e.name();
 
     release_resources(name);
-    vm_instances.erase(name);
+    auto instance = take_instance(vm_instances, name);
     persist_instances();
 
     status_promise->set_value(grpc::Status(grpc::StatusCode::ABORTED, e.what(), ""));
@@ -1074,7 +1205,11 @@ try // clang-format on
         response.add_purged_instances(del.first);
     }
 
-    deleted_instances.clear();
+    decltype(deleted_instances) purged_instances;
+    {
+        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+        purged_instances.swap(deleted_instances);
+    }
     persist_instances();
 
     server->Write(response);
@@ -1198,7 +1333,9 @@ try // clang-format on
     fmt::memory_buffer errors;
     bool have_mounts = false;
     std::vector<decltype(vm_instances)::key_type> instances_for_info;
+    std::vector<InfoQuery> queries;
 
+    std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
     if (request->instance_names().instance_name().empty())
     {
         for (auto& pair : vm_instances)
@@ -1225,39 +1362,26 @@ try // clang-format on
             deleted = true;
         }
 
-        auto info = response.add_info();
-        auto& vm = it->second;
-        auto present_state = vm->current_state();
+        auto& query = queries.emplace_back();
+        query.vm = it->second;
+        query.vm_query_mutex = vm_query_mutex_for(name);
+        query.deleted = deleted;
+        query.runtime_information = !request->no_runtime_information();
+
+        auto info = &query.info;
         info->set_name(name);
         if (deleted)
         {
             info->mutable_instance_status()->set_status(mp::InstanceStatus::DELETED);
         }
-        else
-        {
-            info->mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
-        }
 
         auto vm_image = fetch_image_for(name, config->factory->fetch_type(), *config->vault);
-        auto original_release = vm_image.original_release;
-
-        if (!vm_image.id.empty() && original_release.empty())
-        {
-            try
-            {
-                auto vm_image_info = config->image_hosts.back()->info_for_full_hash(vm_image.id);
-                original_release = vm_image_info.release_title.toStdString();
-            }
-            catch (const std::exception& e)
-            {
-                mpl::log(mpl::Level::warning, category, fmt::format("Cannot fetch image information: {}", e.what()));
-            }
-        }
-
-        info->set_image_release(original_release);
+        info->set_image_release(vm_image.original_release);
         info->set_id(vm_image.id);
 
-        auto vm_specs = vm_instance_specs[name];
+        auto spec_it = vm_instance_specs.find(name);
+        const auto vm_specs = spec_it != vm_instance_specs.end() ? spec_it->second : VMSpecs{};
+        query.ssh_username = vm_specs.ssh_username;
 
         auto mount_info = info->mutable_mount_info();
 
@@ -1293,36 +1417,24 @@ try // clang-format on
                 }
             }
         }
+    }
+    lock.unlock();
 
-        if (!request->no_runtime_information() && mp::utils::is_running(present_state))
-        {
-            mp::SSHSession session{vm->ssh_hostname(), vm->ssh_port(), vm_specs.ssh_username,
-                                   *config->ssh_key_provider};
-
-            info->set_load(mpu::run_in_ssh_session(session, "cat /proc/loadavg | cut -d ' ' -f1-3"));
-            info->set_memory_usage(mpu::run_in_ssh_session(session, "free -b | grep 'Mem:' | awk '{printf $3}'"));
-            info->set_memory_total(mpu::run_in_ssh_session(session, "free -b | grep 'Mem:' | awk '{printf $2}'"));
-            info->set_disk_usage(mpu::run_in_ssh_session(
-                session, "df --output=used `awk '$2 == \"/\" { print $1 }' /proc/mounts` -B1 | sed 1d"));
-            info->set_disk_total(mpu::run_in_ssh_session(
-                session, "df --output=size `awk '$2 == \"/\" { print $1 }' /proc/mounts` -B1 | sed 1d"));
-            info->set_cpu_count(mpu::run_in_ssh_session(session, "nproc"));
-
-            std::string management_ip = vm->management_ipv4();
-            auto all_ipv4 = vm->get_all_ipv4(*config->ssh_key_provider);
+    auto results = query_instances(
+        instance_query_pool, std::move(queries),
+        [this](InfoQuery& query, const std::function<bool()>& publish) { query_info(query, publish); },
+        instance_query_timeout);
 
-            if (is_ipv4_valid(management_ip))
-                info->add_ipv4(management_ip);
-            else if (all_ipv4.empty())
-                info->add_ipv4("N/A");
+    for (auto& result : results)
+    {
+        if (!result.error.empty())
+            throw std::runtime_error(result.error);
 
-            for (const auto& extra_ipv4 : all_ipv4)
-                if (extra_ipv4 != management_ip)
-                    info->add_ipv4(extra_ipv4);
+        if (!result.finished)
+            mpl::log(mpl::Level::warning, category,
+                     fmt::format("Timed out gathering information about \"{}\"", result.entry.info.name()));
 
-            auto current_release = mpu::run_in_ssh_session(session, "lsb_release -ds");
-            info->set_current_release(!current_release.empty() ? current_release : original_release);
-        }
+        response.add_info()->Swap(&result.entry.info);
     }
 
     if (have_mounts && !MP_SETTINGS.get_as<bool>(mp::mounts_key))
@@ -1339,6 +1451,52 @@ catch (const std::exception& e)
     status_promise->set_value(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, e.what(), ""));
 }
 
+void mp::Daemon::query_info(InfoQuery& query, const std::function<bool()>& publish)
+{
+    auto& vm = query.vm;
+    auto& info = query.info;
+    const auto original_release = info.image_release();
+
+    if (query.deleted)
+        return;
+
+    std::unique_lock<std::timed_mutex> vm_query_lock{*query.vm_query_mutex, std::defer_lock};
+    if (!take_turn_querying(vm_query_lock, publish))
+        return;
+
+    auto present_state = vm->current_state();
+    info.mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
+    if (!publish() || !query.runtime_information || !mp::utils::is_running(present_state))
+        return;
+
+    auto metrics = instance_metrics.get(info.name(), [this, &vm, &query] {
+        return ssh_session_pool.run(vm->ssh_hostname(), vm->ssh_port(), query.ssh_username,
+                                    [](mp::SSHSession& session) { return mp::collect_instance_metrics(session); });
+    });
+
+    info.set_load(metrics.load);
+    info.set_memory_usage(metrics.memory_usage);
+    info.set_memory_total(metrics.memory_total);
+    info.set_disk_usage(metrics.disk_usage);
+    info.set_disk_total(metrics.disk_total);
+    info.set_cpu_count(metrics.cpu_count);
+    info.set_current_release(!metrics.current_release.empty() ? metrics.current_release : original_release);
+    if (!publish())
+        return;
+
+    std::string management_ip = vm->management_ipv4();
+    auto all_ipv4 = vm->get_all_ipv4(ssh_session_pool);
+
+    if (is_ipv4_valid(management_ip))
+        info.add_ipv4(management_ip);
+    else if (all_ipv4.empty())
+        info.add_ipv4("N/A");
+
+    for (const auto& extra_ipv4 : all_ipv4)
+        if (extra_ipv4 != management_ip)
+            info.add_ipv4(extra_ipv4);
+}
+
 void mp::Daemon::list(const ListRequest* request, grpc::ServerReaderWriterInterface<ListReply, ListRequest>* server,
                       std::promise<grpc::Status>* status_promise) // clang-format off
 try // clang-format on
@@ -1348,53 +1506,45 @@ try // clang-format on
     ListReply response;
     config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
 
+    std::vector<ListQuery> queries;
+    std::vector<std::string> deleted_names;
+
+    std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
     for (const auto& instance : vm_instances)
     {
         const auto& name = instance.first;
-        const auto& vm = instance.second;
-        auto present_state = vm->current_state();
-        auto entry = response.add_instances();
-        entry->set_name(name);
-        entry->mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
-
-        // FIXME: Set the release to the cached current version when supported
-        auto vm_image = fetch_image_for(name, config->factory->fetch_type(), *config->vault);
-        auto current_release = vm_image.original_release;
+        auto& query = queries.emplace_back();
+        query.vm = instance.second;
+        query.vm_query_mutex = vm_query_mutex_for(name);
+        query.request_ipv4 = request->request_ipv4();
+        query.image = fetch_image_for(name, config->factory->fetch_type(), *config->vault);
+        query.entry.set_name(name);
+        query.entry.set_current_release(query.image.original_release);
+    }
 
-        if (!vm_image.id.empty() && current_release.empty())
-        {
-            try
-            {
-                auto vm_image_info = config->image_hosts.back()->info_for_full_hash(vm_image.id);
-                current_release = vm_image_info.release_title.toStdString();
-            }
-            catch (const std::exception& e)
-            {
-                mpl::log(mpl::Level::warning, category, fmt::format("Cannot fetch image information: {}", e.what()));
-            }
-        }
+    for (const auto& instance : deleted_instances)
+        deleted_names.push_back(instance.first);
+    lock.unlock();
 
-        entry->set_current_release(current_release);
+    auto results = query_instances(
+        instance_query_pool, std::move(queries),
+        [this](ListQuery& query, const std::function<bool()>& publish) { query_list(query, publish); },
+        instance_query_timeout);
 
-        if (request->request_ipv4() && mp::utils::is_running(present_state))
-        {
-            std::string management_ip = vm->management_ipv4();
-            auto all_ipv4 = vm->get_all_ipv4(*config->ssh_key_provider);
+    for (auto& result : results)
+    {
+        if (!result.error.empty())
+            throw std::runtime_error(result.error);
 
-            if (is_ipv4_valid(management_ip))
-                entry->add_ipv4(management_ip);
-            else if (all_ipv4.empty())
-                entry->add_ipv4("N/A");
+        if (!result.finished)
+            mpl::log(mpl::Level::warning, category,
+                     fmt::format("Timed out listing \"{}\"", result.entry.entry.name()));
 
-            for (const auto& extra_ipv4 : all_ipv4)
-                if (extra_ipv4 != management_ip)
-                    entry->add_ipv4(extra_ipv4);
-        }
+        response.add_instances()->Swap(&result.entry.entry);
     }
 
-    for (const auto& instance : deleted_instances)
+    for (const auto& name : deleted_names)
     {
-        const auto& name = instance.first;
         auto entry = response.add_instances();
         entry->set_name(name);
         entry->mutable_instance_status()->set_status(mp::InstanceStatus::DELETED);
@@ -1408,6 +1558,36 @@ catch (const std::exception& e)
     status_promise->set_value(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, e.what(), ""));
 }
 
+void mp::Daemon::query_list(ListQuery& query, const std::function<bool()>& publish)
+{
+    auto& vm = query.vm;
+    auto& entry = query.entry;
+
+    std::unique_lock<std::timed_mutex> vm_query_lock{*query.vm_query_mutex, std::defer_lock};
+    if (!take_turn_querying(vm_query_lock, publish))
+        return;
+
+    auto present_state = vm->current_state();
+    entry.mutable_instance_status()->set_status(grpc_instance_status_for(present_state));
+    if (!publish())
+        return;
+
+    if (query.request_ipv4 && mp::utils::is_running(present_state))
+    {
+        std::string management_ip = vm->management_ipv4();
+        auto all_ipv4 = vm->get_all_ipv4(ssh_session_pool);
+
+        if (is_ipv4_valid(management_ip))
+            entry.add_ipv4(management_ip);
+        else if (all_ipv4.empty())
+            entry.add_ipv4("N/A");
+
+        for (const auto& extra_ipv4 : all_ipv4)
+            if (extra_ipv4 != management_ip)
+                entry.add_ipv4(extra_ipv4);
+    }
+}
+
 void mp::Daemon::networks(const NetworksRequest* request,
                           grpc::ServerReaderWriterInterface<NetworksReply, NetworksRequest>* server,
                           std::promise<grpc::Status>* status_promise) // clang-format off
@@ -1418,7 +1598,13 @@ try // clang-format on
     NetworksReply response;
     config->update_prompt->populate_if_time_to_show(response.mutable_update_info());
 
-    if (!instances_running(vm_instances))
+    decltype(vm_instances) instances;
+    {
+        std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
+        instances = vm_instances;
+    }
+
+    if (!instances_running(instances))
         config->factory->hypervisor_health_check();
 
     const auto& iface_list = config->factory->networks();
@@ -1555,6 +1741,7 @@ try // clang-format on
             continue;
         }
 
+        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
         vm_specs.mounts[target_path] = mount;
     }
 
@@ -1587,6 +1774,8 @@ try // clang-format on
             if (it != std::end(deleted_instances))
             {
                 assert(vm_instance_specs[name].deleted);
+
+                std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
                 vm_instance_specs[name].deleted = false;
                 vm_instances[name] = std::move(it->second);
                 deleted_instances.erase(it);
@@ -1906,6 +2095,7 @@ try // clang-format on
 
             instance->shutdown();
 
+            auto deleted_instance = take_instance(vm_instances, name);
             if (purge)
             {
                 release_resources(name);
@@ -1913,11 +2103,10 @@ try // clang-format on
             }
             else
             {
-                deleted_instances[name] = std::move(instance);
+                std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+                deleted_instances[name] = std::move(deleted_instance);
                 vm_instance_specs[name].deleted = true;
             }
-
-            vm_instances.erase(name);
         }
 
         if (purge)
@@ -1926,7 +2115,7 @@ try // clang-format on
             {
                 assert(vm_instance_specs[name].deleted);
                 release_resources(name);
-                deleted_instances.erase(name);
+                take_instance(deleted_instances, name);
                 response.add_purged_instances(name);
             }
         }
@@ -1972,6 +2161,7 @@ try // clang-format on
                 mount_handler.second->stop_all_mounts_for_instance(name);
             }
 
+            std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
             mounts.clear();
         }
         else
@@ -1996,6 +2186,7 @@ try // clang-format on
                 throw std::runtime_error("Cannot unmount: Invalid mount type stored in the database.");
             }
 
+            std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
             mounts.erase(target_path);
         }
     }
@@ -2163,20 +2354,30 @@ void mp::Daemon::on_restart(const std::string& name)
 
 void mp::Daemon::persist_state_for(const std::string& name, const VirtualMachine::State& state)
 {
-    vm_instance_specs[name].state = state;
+    {
+        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+        vm_instance_specs[name].state = state;
+    }
+
     persist_instances();
 }
 
 void mp::Daemon::update_metadata_for(const std::string& name, const QJsonObject& metadata)
 {
-    vm_instance_specs[name].metadata = metadata;
+    {
+        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+        vm_instance_specs[name].metadata = metadata;
+    }
 
     persist_instances();
 }
 
 QJsonObject mp::Daemon::retrieve_metadata_for(const std::string& name)
 {
-    return vm_instance_specs[name].metadata;
+    std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
+
+    auto it = vm_instance_specs.find(name);
+    return it != vm_instance_specs.end() ? it->second.metadata : QJsonObject{};
 }
 
 QJsonArray to_json_array(const std::vector<mp::NetworkInterface>& extra_interfaces)
@@ -2253,10 +2454,13 @@ void mp::Daemon::persist_instances()
         return json;
     };
     QJsonObject instance_records_json;
-    for (const auto& record : vm_instance_specs)
     {
-        auto key = QString::fromStdString(record.first);
-        instance_records_json.insert(key, vm_spec_to_json(record.second));
+        std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
+        for (const auto& record : vm_instance_specs)
+        {
+            auto key = QString::fromStdString(record.first);
+            instance_records_json.insert(key, vm_spec_to_json(record.second));
+        }
     }
     QDir data_dir{
         mp::utils::backend_directory_path(config->data_directory, config->factory->get_backend_directory_name())};
@@ -2271,13 +2475,42 @@ void mp::Daemon::release_resources(const std::string& instance)
     auto spec_it = vm_instance_specs.find(instance);
     if (spec_it != cend(vm_instance_specs))
     {
+        std::lock_guard<decltype(mac_mutex)> lock{mac_mutex};
         for (const auto& mac : mac_set_from(spec_it->second))
             allocated_mac_addrs.erase(mac);
 
+        std::lock_guard<decltype(instances_mutex)> instances_lock{instances_mutex};
         vm_instance_specs.erase(spec_it);
     }
 }
 
+// Hands the instance back rather than dropping it under the lock, as destroying it may persist its state
+mp::VirtualMachine::ShPtr mp::Daemon::take_instance(std::unordered_map<std::string, VirtualMachine::ShPtr>& instances,
+                                                    const std::string& name)
+{
+    std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+
+    auto it = instances.find(name);
+    if (it == instances.end())
+        return nullptr;
+
+    auto instance = std::move(it->second);
+    instances.erase(it);
+
+    return instance;
+}
+
+std::shared_ptr<std::timed_mutex> mp::Daemon::vm_query_mutex_for(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock{vm_query_mutexes_mutex};
+
+    auto& vm_query_mutex = vm_query_mutexes[name];
+    if (!vm_query_mutex)
+        vm_query_mutex = std::make_shared<std::timed_mutex>();
+
+    return vm_query_mutex;
+}
+
 std::string mp::Daemon::check_instance_operational(const std::string& instance_name) const
 {
     if (vm_instances.find(instance_name) == std::cend(vm_instances))
@@ -2328,263 +2561,397 @@ void mp::Daemon::create_vm(const CreateRequest* request,
             grpc::Status{grpc::StatusCode::FAILED_PRECONDITION, "Missing bridges", create_error.SerializeAsString()});
     }
 
+    if (std::max(request->num_instances(), request->instance_names_size()) > max_instances_per_launch)
+        return status_promise->set_value(
+            grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                         fmt::format("cannot launch more than {} instances at once", max_instances_per_launch)));
+
     // TODO: We should only need to query the Blueprint Provider once for all info, so this (and timeout below) will
     //       need a refactoring to do so.
-    auto name = name_from(checked_args.instance_name, config->blueprint_provider->name_from_blueprint(request->image()),
-                          *config->name_generator, vm_instances);
+    auto names = names_from(request, config->blueprint_provider->name_from_blueprint(request->image()),
+                            *config->name_generator, vm_instances);
 
-    if (vm_instances.find(name) != vm_instances.end() || deleted_instances.find(name) != deleted_instances.end())
+    std::unordered_set<std::string> requested_names;
+    for (const auto& name : names)
     {
-        CreateError create_error;
-        create_error.add_error_codes(CreateError::INSTANCE_EXISTS);
+        if (vm_instances.find(name) != vm_instances.end() || deleted_instances.find(name) != deleted_instances.end() ||
+            !requested_names.insert(name).second)
+        {
+            CreateError create_error;
+            create_error.add_error_codes(CreateError::INSTANCE_EXISTS);
+
+            return status_promise->set_value(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                                          fmt::format("instance \"{}\" already exists", name),
+                                                          create_error.SerializeAsString()));
+        }
 
-        return status_promise->set_value(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                                                      fmt::format("instance \"{}\" already exists", name),
-                                                      create_error.SerializeAsString()));
+        if (preparing_instances.find(name) != preparing_instances.end())
+        {
+            CreateError create_error;
+            create_error.add_error_codes(CreateError::INSTANCE_EXISTS);
+
+            return status_promise->set_value(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                                          fmt::format("instance \"{}\" is being prepared", name),
+                                                          create_error.SerializeAsString()));
+        }
     }
 
-    if (preparing_instances.find(name) != preparing_instances.end())
+    const auto batch = names.size() > 1;
+    if (batch && std::any_of(checked_args.extra_interfaces.cbegin(), checked_args.extra_interfaces.cend(),
+                             [](const auto& iface) { return !iface.mac_address.empty(); }))
     {
         CreateError create_error;
-        create_error.add_error_codes(CreateError::INSTANCE_EXISTS);
+        create_error.add_error_codes(CreateError::INVALID_NETWORK);
 
-        return status_promise->set_value(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                                                      fmt::format("instance \"{}\" is being prepared", name),
-                                                      create_error.SerializeAsString()));
+        return status_promise->set_value(
+            grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                         "MAC addresses cannot be requested when launching more than one instance",
+                         create_error.SerializeAsString()));
     }
 
+    if (batch && blueprint_defines_aliases(*config->blueprint_provider, request->image()))
+        return status_promise->set_value(
+            grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                         fmt::format("blueprint \"{}\" defines aliases, so only one instance can be launched from it "
+                                     "at once",
+                                     request->image())));
+
     if (!instances_running(vm_instances))
         config->factory->hypervisor_health_check();
 
     // TODO: We should only need to query the Blueprint Provider once for all info, so this (and name above) will
     //       need a refactoring to do so.
-    auto timeout = timeout_for(request->timeout(), config->blueprint_provider->blueprint_timeout(name));
-
-    preparing_instances.insert(name);
+    auto timeout = timeout_for(request->timeout(),
+                               config->blueprint_provider->blueprint_timeout(batch ? request->image() : names.front()));
+
+    // The instances of a batch are prepared in a pool of their own, which limits how many disks and cloud-init ISOs are
+    // built at once. The image itself is only fetched and prepared once, since the vault shares fetches in progress.
+    // Replies go through writers that serialize them and tag them with the instance they are about.
+    struct Launch
+    {
+        grpc::ServerReaderWriterInterface<CreateReply, CreateRequest>* writer_for(const std::string& name) const
+        {
+            auto it = instance_writers.find(name);
+            return it != instance_writers.end() ? it->second.get() : server;
+        }
+
+        grpc::ServerReaderWriterInterface<CreateReply, CreateRequest>* server;
+        std::mutex write_mutex;
+        std::unique_ptr<BatchReplyWriter> batch_writer;
+        std::unordered_map<std::string, std::unique_ptr<BatchReplyWriter>> instance_writers;
+        std::unique_ptr<mpl::ClientLogger<CreateReply, CreateRequest>> logger;
+        std::unique_ptr<QThreadPool> pool;
+        std::size_t pending;
+        std::vector<std::string> created;
+        std::unordered_map<std::string, ClientLaunchData> client_launch_data;
+        fmt::memory_buffer errors;
+    };
 
-    auto prepare_future_watcher = new QFutureWatcher<VMFullDescription>();
     auto log_level = mpl::level_from(request->verbosity_level());
+    auto launch = std::make_shared<Launch>();
+    launch->server = server;
+    launch->pending = names.size();
+
+    if (batch)
+    {
+        launch->batch_writer = std::make_unique<BatchReplyWriter>(server, launch->write_mutex);
+        launch->server = launch->batch_writer.get();
+        for (const auto& name : names)
+            launch->instance_writers[name] = std::make_unique<BatchReplyWriter>(server, launch->write_mutex, name);
 
-    QObject::connect(
-        prepare_future_watcher, &QFutureWatcher<VMFullDescription>::finished,
-        [this, server, status_promise, name, timeout, start, prepare_future_watcher, log_level] {
-            mpl::ClientLogger<CreateReply, CreateRequest> logger{log_level, *config->logger, server};
+        // A single logger for the whole batch, so that log lines reach the client once
+        launch->logger =
+            std::make_unique<mpl::ClientLogger<CreateReply, CreateRequest>>(log_level, *config->logger, launch->server);
 
-            try
+        launch->pool = std::make_unique<QThreadPool>();
+        launch->pool->setMaxThreadCount(request->max_parallel() > 0 ? request->max_parallel()
+                                                                    : QThread::idealThreadCount());
+    }
+
+    auto log_server = batch ? nullptr : server;
+
+    auto finish_launch = [this, launch, status_promise, start, timeout] {
+        if (!start || launch->created.empty())
+        {
+            auto error_string = fmt::to_string(launch->errors);
+            if (error_string.empty())
+                return status_promise->set_value(grpc::Status::OK);
+
+            error_string.pop_back(); // grpc adds a newline of its own
+            return status_promise->set_value(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, error_string, ""));
+        }
+
+        {
+            std::lock_guard<decltype(start_mutex)> lock{start_mutex};
+            for (const auto& name : launch->created)
+                async_running_futures[name] = QtConcurrent::run(
+                    this, &Daemon::async_wait_for_ssh_and_start_mounts_for<LaunchReply, LaunchRequest>, name, timeout,
+                    launch->writer_for(name));
+        }
+
+        auto future_watcher = create_future_watcher([this, launch] {
+            for (const auto& name : launch->created)
             {
-                auto vm_desc_pair = prepare_future_watcher->future().result();
-                auto vm_desc = vm_desc_pair.first;
-                auto& vm_client_data = vm_desc_pair.second;
-                auto& vm_aliases = vm_client_data.aliases_to_be_created;
-                auto& vm_workspaces = vm_client_data.workspaces_to_be_created;
-
-                vm_instance_specs[name] = {vm_desc.num_cores,
-                                           vm_desc.mem_size,
-                                           vm_desc.disk_space,
-                                           vm_desc.default_mac_address,
-                                           vm_desc.extra_interfaces,
-                                           config->ssh_username,
-                                           VirtualMachine::State::off,
-                                           {},
-                                           false,
-                                           QJsonObject()};
-                vm_instances[name] = config->factory->create_virtual_machine(vm_desc, *this);
-                preparing_instances.erase(name);
-
-                persist_instances();
-
-                if (start)
+                LaunchReply reply;
+                reply.set_vm_instance_name(name);
+                if (name == launch->created.back())
+                    config->update_prompt->populate_if_time_to_show(reply.mutable_update_info());
+
+                // Attach the aliases to be created by the CLI to the last message.
+                for (const auto& blueprint_alias : launch->client_launch_data[name].aliases_to_be_created)
                 {
-                    LaunchReply reply;
-                    reply.set_create_message("Starting " + name);
-                    server->Write(reply);
+                    mpl::log(mpl::Level::debug, category,
+                             fmt::format("Adding alias '{}' to RPC reply", blueprint_alias.first));
+                    auto alias = reply.add_aliases_to_be_created();
+                    alias->set_name(blueprint_alias.first);
+                    alias->set_instance(blueprint_alias.second.instance);
+                    alias->set_command(blueprint_alias.second.command);
+                    alias->set_working_directory(blueprint_alias.second.working_directory);
+                }
 
-                    init_mounts(name);
+                // Now attach the workspaces.
+                for (const auto& blueprint_workspace : launch->client_launch_data[name].workspaces_to_be_created)
+                {
+                    mpl::log(mpl::Level::debug, category,
+                             fmt::format("Adding workspace '{}' to RPC reply", blueprint_workspace));
+                    reply.add_workspaces_to_be_created(blueprint_workspace);
+                }
 
-                    vm_instances[name]->start();
+                launch->writer_for(name)->Write(reply);
+            }
+        });
+        future_watcher->setFuture(QtConcurrent::run(this,
+                                                    &Daemon::async_wait_for_ready_all<LaunchReply, LaunchRequest>,
+                                                    launch->server, launch->created, timeout, status_promise,
+                                                    fmt::to_string(launch->errors)));
+    };
 
-                    auto future_watcher = create_future_watcher([this, server, name, vm_aliases, vm_workspaces] {
+    for (const auto& name : names)
+    {
+        preparing_instances.insert(name);
+
+        auto reply_server = launch->writer_for(name);
+        auto prepare_future_watcher = new QFutureWatcher<VMFullDescription>();
+
+        QObject::connect(
+            prepare_future_watcher, &QFutureWatcher<VMFullDescription>::finished,
+            [this, launch, finish_launch, reply_server, log_server, name, start, prepare_future_watcher, log_level] {
+                mpl::ClientLogger<CreateReply, CreateRequest> logger{log_level, *config->logger, log_server};
+
+                try
+                {
+                    auto vm_desc_pair = prepare_future_watcher->future().result();
+                    auto vm_desc = vm_desc_pair.first;
+                    launch->client_launch_data[name] = vm_desc_pair.second;
+
+                    {
+                        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+                        vm_instance_specs[name] = {vm_desc.num_cores,
+                                                   vm_desc.mem_size,
+                                                   vm_desc.disk_space,
+                                                   vm_desc.default_mac_address,
+                                                   vm_desc.extra_interfaces,
+                                                   config->ssh_username,
+                                                   VirtualMachine::State::off,
+                                                   {},
+                                                   false,
+                                                   QJsonObject()};
+                    }
+
+                    auto vm = config->factory->create_virtual_machine(vm_desc, *this);
+                    {
+                        std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+                        vm_instances[name] = std::move(vm);
+                    }
+                    preparing_instances.erase(name);
+
+                    persist_instances();
+
+                    if (start)
+                    {
                         LaunchReply reply;
-                        reply.set_vm_instance_name(name);
-                        config->update_prompt->populate_if_time_to_show(reply.mutable_update_info());
+                        reply.set_create_message("Starting " + name);
+                        reply_server->Write(reply);
 
-                        // Attach the aliases to be created by the CLI to the last message.
-                        for (const auto& blueprint_alias : vm_aliases)
-                        {
-                            mpl::log(mpl::Level::debug, category,
-                                     fmt::format("Adding alias '{}' to RPC reply", blueprint_alias.first));
-                            auto alias = reply.add_aliases_to_be_created();
-                            alias->set_name(blueprint_alias.first);
-                            alias->set_instance(blueprint_alias.second.instance);
-                            alias->set_command(blueprint_alias.second.command);
-                            alias->set_working_directory(blueprint_alias.second.working_directory);
-                        }
+                        init_mounts(name);
 
-                        // Now attach the workspaces.
-                        for (const auto& blueprint_workspace : vm_workspaces)
-                        {
-                            mpl::log(mpl::Level::debug, category,
-                                     fmt::format("Adding workspace '{}' to RPC reply", blueprint_workspace));
-                            reply.add_workspaces_to_be_created(blueprint_workspace);
-                        }
+                        vm_instances[name]->start();
+                    }
 
-                        server->Write(reply);
-                    });
-                    future_watcher->setFuture(
-                        QtConcurrent::run(this, &Daemon::async_wait_for_ready_all<LaunchReply, LaunchRequest>, server,
-                                          std::vector<std::string>{name}, timeout, status_promise, std::string()));
+                    launch->created.push_back(name);
                 }
-                else
+                catch (const std::exception& e)
                 {
-                    status_promise->set_value(grpc::Status::OK);
+                    preparing_instances.erase(name);
+                    release_resources(name);
+                    auto instance = take_instance(vm_instances, name);
+                    persist_instances();
+                    fmt::format_to(launch->errors, "{}\n", e.what());
                 }
-            }
-            catch (const std::exception& e)
-            {
-                preparing_instances.erase(name);
-                release_resources(name);
-                vm_instances.erase(name);
-                persist_instances();
-                status_promise->set_value(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, e.what(), ""));
-            }
 
-            delete prepare_future_watcher;
-        });
-
-    auto make_vm_description = [this, server, request, name, checked_args, log_level]() mutable -> VMFullDescription {
-        mpl::ClientLogger<CreateReply, CreateRequest> logger{log_level, *config->logger, server};
+                if (--launch->pending == 0)
+                    finish_launch();
 
-        try
-        {
-            CreateReply reply;
-            reply.set_create_message("Creating " + name);
-            server->Write(reply);
+                delete prepare_future_watcher;
+            });
 
-            Query query;
-            VirtualMachineDescription vm_desc{
-                request->num_cores(),
-                MemorySize{request->mem_size().empty() ? "0b" : request->mem_size()},
-                MemorySize{request->disk_space().empty() ? "0b" : request->disk_space()},
-                name,
-                "",
-                {},
-                config->ssh_username,
-                VMImage{},
-                "",
-                YAML::Node{},
-                YAML::Node{},
-                make_cloud_init_vendor_config(*config->ssh_key_provider, request->time_zone(), config->ssh_username,
-                                              config->factory->get_backend_version_string().toStdString()),
-                YAML::Node{}};
-
-            ClientLaunchData client_launch_data;
+        auto make_vm_description = [this, reply_server, log_server, request, name, checked_args,
+                                    log_level]() mutable -> VMFullDescription {
+            mpl::ClientLogger<CreateReply, CreateRequest> logger{log_level, *config->logger, log_server};
 
             try
             {
-                query = config->blueprint_provider->fetch_blueprint_for(request->image(), vm_desc, client_launch_data);
-                query.name = name;
+                CreateReply reply;
+                reply.set_create_message("Creating " + name);
+                reply_server->Write(reply);
+
+                Query query;
+                VirtualMachineDescription vm_desc{
+                    request->num_cores(),
+                    MemorySize{request->mem_size().empty() ? "0b" : request->mem_size()},
+                    MemorySize{request->disk_space().empty() ? "0b" : request->disk_space()},
+                    name,
+                    "",
+                    {},
+                    config->ssh_username,
+                    VMImage{},
+                    "",
+                    YAML::Node{},
+                    YAML::Node{},
+                    make_cloud_init_vendor_config(*config->ssh_key_provider, request->time_zone(),
+                                                  config->ssh_username,
+                                                  config->factory->get_backend_version_string().toStdString()),
+                    YAML::Node{}};
+
+                ClientLaunchData client_launch_data;
 
-                // Aliases and default workspace are named in function of the instance name in the Blueprint. If the
-                // user asked for a different name, it will be necessary to change the alias definitions and the
-                // workspace name to reflect it.
-                if (name != request->image())
+                try
                 {
-                    for (auto& alias_to_define : client_launch_data.aliases_to_be_created)
-                        if (alias_to_define.second.instance == request->image())
-                        {
-                            mpl::log(mpl::Level::trace, category,
-                                     fmt::format("Renaming instance on alias \"{}\" from \"{}\" to \"{}\"",
-                                                 alias_to_define.first, alias_to_define.second.instance, name));
-                            alias_to_define.second.instance = name;
-                        }
-
-                    for (auto& workspace_to_create : client_launch_data.workspaces_to_be_created)
-                        if (workspace_to_create == request->image())
-                        {
-                            mpl::log(mpl::Level::trace, category,
-                                     fmt::format("Renaming workspace \"{}\" to \"{}\"", workspace_to_create, name));
-                            workspace_to_create = name;
-                        }
+                    query =
+                        config->blueprint_provider->fetch_blueprint_for(request->image(), vm_desc, client_launch_data);
+                    query.name = name;
+
+                    // Aliases and default workspace are named in function of the instance name in the Blueprint. If
+                    // the user asked for a different name, it will be necessary to change the alias definitions and
+                    // the workspace name to reflect it.
+                    if (name != request->image())
+                    {
+                        for (auto& alias_to_define : client_launch_data.aliases_to_be_created)
+                            if (alias_to_define.second.instance == request->image())
+                            {
+                                mpl::log(mpl::Level::trace, category,
+                                         fmt::format("Renaming instance on alias \"{}\" from \"{}\" to \"{}\"",
+                                                     alias_to_define.first, alias_to_define.second.instance, name));
+                                alias_to_define.second.instance = name;
+                            }
+
+                        for (auto& workspace_to_create : client_launch_data.workspaces_to_be_created)
+                            if (workspace_to_create == request->image())
+                            {
+                                mpl::log(mpl::Level::trace, category,
+                                         fmt::format("Renaming workspace \"{}\" to \"{}\"", workspace_to_create,
+                                                     name));
+                                workspace_to_create = name;
+                            }
+                    }
+                }
+                catch (const std::out_of_range&)
+                {
+                    // Blueprint not found, move on
+                    query = query_from(request, name);
+                    vm_desc.mem_size = checked_args.mem_size;
                 }
-            }
-            catch (const std::out_of_range&)
-            {
-                // Blueprint not found, move on
-                query = query_from(request, name);
-                vm_desc.mem_size = checked_args.mem_size;
-            }
 
-            auto progress_monitor = [server](int progress_type, int percentage) {
-                CreateReply create_reply;
-                create_reply.mutable_launch_progress()->set_percent_complete(std::to_string(percentage));
-                create_reply.mutable_launch_progress()->set_type((CreateProgress::ProgressTypes)progress_type);
-                return server->Write(create_reply);
-            };
+                auto progress_monitor = [reply_server](int progress_type, int percentage) {
+                    CreateReply create_reply;
+                    create_reply.mutable_launch_progress()->set_percent_complete(std::to_string(percentage));
+                    create_reply.mutable_launch_progress()->set_type((CreateProgress::ProgressTypes)progress_type);
+                    return reply_server->Write(create_reply);
+                };
 
-            auto prepare_action = [this, server, &name](const VMImage& source_image) -> VMImage {
-                CreateReply reply;
-                reply.set_create_message("Preparing image for " + name);
-                server->Write(reply);
+                auto prepare_action = [this, reply_server, &name](const VMImage& source_image) -> VMImage {
+                    CreateReply reply;
+                    reply.set_create_message("Preparing image for " + name);
+                    reply_server->Write(reply);
 
-                return config->factory->prepare_source_image(source_image);
-            };
+                    return config->factory->prepare_source_image(source_image);
+                };
 
-            auto fetch_type = config->factory->fetch_type();
+                auto fetch_type = config->factory->fetch_type();
 
-            auto vm_image = config->vault->fetch_image(fetch_type, query, prepare_action, progress_monitor);
+                auto vm_image = config->vault->fetch_image(fetch_type, query, prepare_action, progress_monitor);
 
-            const auto image_size = config->vault->minimum_image_size_for(vm_image.id);
-            vm_desc.disk_space = compute_final_image_size(
-                image_size, vm_desc.disk_space.in_bytes() > 0 ? vm_desc.disk_space : checked_args.disk_space,
-                config->data_directory);
+                const auto image_size = config->vault->minimum_image_size_for(vm_image.id);
+                vm_desc.disk_space = compute_final_image_size(
+                    image_size, vm_desc.disk_space.in_bytes() > 0 ? vm_desc.disk_space : checked_args.disk_space,
+                    config->data_directory);
 
-            reply.set_create_message("Configuring " + name);
-            server->Write(reply);
+                reply.set_create_message("Configuring " + name);
+                reply_server->Write(reply);
 
-            config->factory->prepare_networking(checked_args.extra_interfaces);
+                config->factory->prepare_networking(checked_args.extra_interfaces);
 
-            // This set stores the MAC's which need to be in the allocated_mac_addrs if everything goes well.
-            auto new_macs = allocated_mac_addrs;
+                {
+                    // Other instances may be getting their MACs at the same time, so they are reserved right away.
+                    std::lock_guard<decltype(mac_mutex)> lock{mac_mutex};
 
-            // check for repetition of requested macs
-            for (auto& iface : checked_args.extra_interfaces)
-                if (!iface.mac_address.empty() && !new_macs.insert(iface.mac_address).second)
-                    throw std::runtime_error(fmt::format("Repeated MAC address {}", iface.mac_address));
+                    // This set stores the MAC's which need to be in the allocated_mac_addrs if everything goes well.
+                    auto new_macs = allocated_mac_addrs;
 
-            // generate missing macs in a second pass, to avoid repeating macs that the user requested
-            for (auto& iface : checked_args.extra_interfaces)
-                if (iface.mac_address.empty())
-                    iface.mac_address = generate_unused_mac_address(new_macs);
+                    // check for repetition of requested macs
+                    for (auto& iface : checked_args.extra_interfaces)
+                        if (!iface.mac_address.empty() && !new_macs.insert(iface.mac_address).second)
+                            throw std::runtime_error(fmt::format("Repeated MAC address {}", iface.mac_address));
 
-            vm_desc.default_mac_address = generate_unused_mac_address(new_macs);
-            vm_desc.extra_interfaces = checked_args.extra_interfaces;
+                    // generate missing macs in a second pass, to avoid repeating macs that the user requested
+                    for (auto& iface : checked_args.extra_interfaces)
+                        if (iface.mac_address.empty())
+                            iface.mac_address = generate_unused_mac_address(new_macs);
 
-            vm_desc.meta_data_config = make_cloud_init_meta_config(name);
-            vm_desc.user_data_config = YAML::Load(request->cloud_init_user_data());
-            prepare_user_data(vm_desc.user_data_config, vm_desc.vendor_data_config);
+                    vm_desc.default_mac_address = generate_unused_mac_address(new_macs);
+                    vm_desc.extra_interfaces = checked_args.extra_interfaces;
 
-            if (vm_desc.num_cores < std::stoi(mp::min_cpu_cores))
-                vm_desc.num_cores = std::stoi(mp::default_cpu_cores);
+                    allocated_mac_addrs = std::move(new_macs);
+                }
 
-            vm_desc.network_data_config =
-                make_cloud_init_network_config(vm_desc.default_mac_address, checked_args.extra_interfaces);
+                try
+                {
+                    vm_desc.meta_data_config = make_cloud_init_meta_config(name);
+                    vm_desc.user_data_config = YAML::Load(request->cloud_init_user_data());
+                    prepare_user_data(vm_desc.user_data_config, vm_desc.vendor_data_config);
 
-            vm_desc.image = vm_image;
-            config->factory->configure(vm_desc);
-            config->factory->prepare_instance_image(vm_image, vm_desc);
+                    if (vm_desc.num_cores < std::stoi(mp::min_cpu_cores))
+                        vm_desc.num_cores = std::stoi(mp::default_cpu_cores);
 
-            // Everything went well, add the MAC addresses used in this instance.
-            allocated_mac_addrs = std::move(new_macs);
+                    vm_desc.network_data_config =
+                        make_cloud_init_network_config(vm_desc.default_mac_address, checked_args.extra_interfaces);
 
-            return VMFullDescription{vm_desc, client_launch_data};
-        }
-        catch (const std::exception& e)
-        {
-            throw CreateImageException(e.what());
-        }
-    };
+                    vm_desc.image = vm_image;
+                    config->factory->configure(vm_desc);
+                    config->factory->prepare_instance_image(vm_image, vm_desc);
+                }
+                catch (...)
+                {
+                    // Hand back the MAC addresses reserved for this instance.
+                    std::lock_guard<decltype(mac_mutex)> lock{mac_mutex};
+                    allocated_mac_addrs.erase(vm_desc.default_mac_address);
+                    for (const auto& iface : vm_desc.extra_interfaces)
+                        allocated_mac_addrs.erase(iface.mac_address);
 
-    prepare_future_watcher->setFuture(QtConcurrent::run(make_vm_description));
+                    throw;
+                }
+
+                return VMFullDescription{vm_desc, client_launch_data};
+            }
+            catch (const std::exception& e)
+            {
+                throw CreateImageException(e.what());
+            }
+        };
+
+        prepare_future_watcher->setFuture(launch->pool ? QtConcurrent::run(launch->pool.get(), make_vm_description)
+                                                       : QtConcurrent::run(make_vm_description));
+    }
 }
 
 grpc::Status mp::Daemon::reboot_vm(VirtualMachine& vm)
@@ -2704,8 +3071,11 @@ mp::Daemon::async_wait_for_ssh_and_start_mounts_for(const std::string& name, con
     fmt::memory_buffer errors;
     try
     {
-        auto it = vm_instances.find(name);
-        auto vm = it->second;
+        VirtualMachine::ShPtr vm;
+        {
+            std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
+            vm = vm_instances.find(name)->second;
+        }
         vm->wait_until_ssh_up(timeout);
 
         if (std::is_same<Reply, LaunchReply>::value)
@@ -2724,7 +3094,13 @@ mp::Daemon::async_wait_for_ssh_and_start_mounts_for(const std::string& name, con
         {
             std::vector<std::string> invalid_mounts;
             fmt::memory_buffer warnings;
-            auto& mounts = vm_instance_specs[name].mounts;
+            decltype(VMSpecs::mounts) mounts;
+            {
+                std::shared_lock<decltype(instances_mutex)> lock{instances_mutex};
+                if (auto spec_it = vm_instance_specs.find(name); spec_it != vm_instance_specs.end())
+                    mounts = spec_it->second.mounts;
+            }
+
             for (const auto& mount_entry : mounts)
             {
                 auto& target_path = mount_entry.first;
@@ -2750,8 +3126,11 @@ mp::Daemon::async_wait_for_ssh_and_start_mounts_for(const std::string& name, con
                 }
             }
 
-            for (const auto& mount : invalid_mounts)
-                vm_instance_specs[name].mounts.erase(mount);
+            {
+                std::lock_guard<decltype(instances_mutex)> lock{instances_mutex};
+                for (const auto& mount : invalid_mounts)
+                    vm_instance_specs[name].mounts.erase(mount);
+            }
 
             if (server && warnings.size() > 0)
             {
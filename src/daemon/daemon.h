@@ -20,21 +20,27 @@
 
 #include "daemon_config.h"
 #include "daemon_rpc.h"
+#include "instance_metrics.h"
 #include "vm_specs.h"
 
 #include <multipass/delayed_shutdown_timer.h>
+#include <multipass/ssh/ssh_session_pool.h>
 #include <multipass/virtual_machine.h>
+#include <multipass/vm_image.h>
 #include <multipass/vm_status_monitor.h>
 
 #include <chrono>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include <QFutureWatcher>
+#include <QThreadPool>
 
 namespace multipass
 {
@@ -136,6 +142,8 @@ public slots:
 
 private:
     void release_resources(const std::string& instance);
+    VirtualMachine::ShPtr take_instance(std::unordered_map<std::string, VirtualMachine::ShPtr>& instances,
+                                        const std::string& name);
     std::string check_instance_operational(const std::string& instance_name) const;
     std::string check_instance_exists(const std::string& instance_name) const;
     void create_vm(const CreateRequest* request, grpc::ServerReaderWriterInterface<CreateReply, CreateRequest>* server,
@@ -146,6 +154,31 @@ private:
     grpc::Status cmd_vms(const std::vector<std::string>& tgts, std::function<grpc::Status(VirtualMachine&)> cmd);
     void init_mounts(const std::string& name);
 
+    struct InfoQuery
+    {
+        VirtualMachine::ShPtr vm;
+        std::shared_ptr<std::timed_mutex> vm_query_mutex;
+        bool deleted{false};
+        bool runtime_information{false};
+        std::string ssh_username;
+        InfoReply::Info info;
+    };
+
+    struct ListQuery
+    {
+        VirtualMachine::ShPtr vm;
+        std::shared_ptr<std::timed_mutex> vm_query_mutex;
+        bool request_ipv4{false};
+        VMImage image;
+        ListVMInstance entry;
+    };
+
+    // These run on instance_query_pool, one per instance, publishing what they gather as they go. Instances aren't safe
+    // to query from several threads at once, so queries on the same one take turns through its vm_query_mutex.
+    void query_info(InfoQuery& query, const std::function<bool()>& publish);
+    void query_list(ListQuery& query, const std::function<bool()>& publish);
+    std::shared_ptr<std::timed_mutex> vm_query_mutex_for(const std::string& name);
+
     struct AsyncOperationStatus
     {
         grpc::Status status;
@@ -164,11 +197,18 @@ private:
     QFutureWatcher<AsyncOperationStatus>* create_future_watcher(std::function<void()> const& finished_op = []() {});
 
     std::unique_ptr<const DaemonConfig> config;
+    SSHSessionPool ssh_session_pool;
+    InstanceMetricsCache instance_metrics;
+    // Read-only RPCs run off the daemon's thread, so changes to the three maps below are made holding this exclusively
+    // and reads from other threads hold it shared. Never hold it while calling into an instance: that can call back
+    // into persist_state_for, and so can dropping the last reference to one.
+    mutable std::shared_timed_mutex instances_mutex;
     std::unordered_map<std::string, VMSpecs> vm_instance_specs;
     std::unordered_map<std::string, VirtualMachine::ShPtr> vm_instances;
     std::unordered_map<std::string, VirtualMachine::ShPtr> deleted_instances;
     std::unordered_map<std::string, std::unique_ptr<DelayedShutdownTimer>> delayed_shutdown_instances;
     std::unordered_set<std::string> allocated_mac_addrs;
+    std::mutex mac_mutex;
     DaemonRpc daemon_rpc;
     QTimer source_images_maintenance_task;
     std::vector<std::unique_ptr<QFutureWatcher<AsyncOperationStatus>>> async_future_watchers;
@@ -177,6 +217,9 @@ private:
     std::unordered_set<std::string> preparing_instances;
     QFuture<void> image_update_future;
     SettingsHandler* instance_mod_handler;
+    std::mutex vm_query_mutexes_mutex;
+    std::unordered_map<std::string, std::shared_ptr<std::timed_mutex>> vm_query_mutexes;
+    QThreadPool instance_query_pool; // last, so that queries are done before anything they use goes away
 };
 } // namespace multipass
 #endif // MULTIPASS_DAEMON_H
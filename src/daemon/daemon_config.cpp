@@ -143,7 +143,7 @@ std::unique_ptr<const mp::DaemonConfig> mp::DaemonConfigBuilder::build()
                 {mp::daily_remote, UbuntuVMImageRemote{"https://cloud-images.ubuntu.com/", "daily/",
                                                        std::make_optional<QString>(mp::mirror_key)}},
                 {mp::appliance_remote, UbuntuVMImageRemote{"https://cdimage.ubuntu.com/", "ubuntu-core/appliances/"}}},
-            url_downloader.get(), manifest_ttl));
+            url_downloader.get(), manifest_ttl, mp::utils::make_dir(cache_directory, "manifests")));
     }
     if (vault == nullptr)
     {
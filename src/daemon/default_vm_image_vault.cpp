@@ -20,6 +20,7 @@
 #include <multipass/exceptions/aborted_download_exception.h>
 #include <multipass/exceptions/create_image_exception.h>
 #include <multipass/exceptions/unsupported_image_exception.h>
+#include <multipass/file_ops.h>
 #include <multipass/json_writer.h>
 #include <multipass/logging/log.h>
 #include <multipass/platform.h>
@@ -33,13 +34,16 @@
 
 #include <multipass/format.h>
 
+#include <QCryptographicHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrl>
 #include <QtConcurrent/QtConcurrent>
 
+#include <algorithm>
 #include <exception>
+#include <optional>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
@@ -239,11 +243,17 @@ mp::DefaultVMImageVault::DefaultVMImageVault(std::vector<VMImageHost*> image_hos
       prepared_image_records{load_db(cache_dir.filePath(image_db_name))},
       instance_image_records{load_db(data_dir.filePath(instance_db_name))}
 {
+    // Records written before the release was stored lack it; look those up once, without holding up whoever loads us
+    if (std::any_of(instance_image_records.cbegin(), instance_image_records.cend(), [](const auto& record) {
+            return record.second.image.original_release.empty() && !record.second.image.id.empty();
+        }))
+        release_backfill = QtConcurrent::run([this] { backfill_original_releases(); });
 }
 
 mp::DefaultVMImageVault::~DefaultVMImageVault()
 {
     url_downloader->abort_all_downloads();
+    release_backfill.waitForFinished();
 }
 
 mp::VMImage mp::DefaultVMImageVault::fetch_image(const FetchType& fetch_type, const Query& query,
@@ -440,6 +450,7 @@ mp::VMImage mp::DefaultVMImageVault::fetch_image(const FetchType& fetch_type, co
 
 void mp::DefaultVMImageVault::remove(const std::string& name)
 {
+    std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
     const auto& name_entry = instance_image_records.find(name);
     if (name_entry == instance_image_records.end())
         return;
@@ -454,6 +465,7 @@ void mp::DefaultVMImageVault::remove(const std::string& name)
 
 bool mp::DefaultVMImageVault::has_record_for(const std::string& name)
 {
+    std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
     return instance_image_records.find(name) != instance_image_records.end();
 }
 
@@ -596,25 +608,13 @@ mp::VMImage mp::DefaultVMImageVault::download_and_prepare_source_image(
 
     try
     {
-        url_downloader->download_to(info.image_location, source_image.image_path, info.size, LaunchProgress::IMAGE,
-                                    monitor);
-
-        if (info.verify)
-        {
-            monitor(LaunchProgress::VERIFY, -1);
-            mp::vault::verify_image_download(source_image.image_path, id);
-        }
+        source_image.image_path = download_image(info, source_image.image_path, monitor);
 
         if (fetch_type == FetchType::ImageKernelAndInitrd)
         {
             source_image = fetch_kernel_and_initrd(info, source_image, image_dir, monitor);
         }
 
-        if (source_image.image_path.endsWith(".xz"))
-        {
-            source_image.image_path = mp::vault::extract_image(source_image.image_path, monitor, true);
-        }
-
         auto prepared_image = prepare(source_image);
         remove_source_images(source_image, prepared_image);
 
@@ -630,6 +630,57 @@ mp::VMImage mp::DefaultVMImageVault::download_and_prepare_source_image(
     }
 }
 
+// Verifies and, if need be, decompresses the image as it comes in, so that only the final image is ever written out
+QString mp::DefaultVMImageVault::download_image(const VMImageInfo& info, const Path& image_path,
+                                                const ProgressMonitor& monitor)
+{
+    QString final_image_path{image_path};
+    const auto compressed = final_image_path.endsWith(".xz");
+    if (compressed)
+        final_image_path.remove(".xz");
+
+    mp::vault::DeleteOnException image_file{final_image_path};
+    QCryptographicHash hash{QCryptographicHash::Sha256};
+    std::optional<mp::XzStreamDecoder> decoder;
+    QFile file{final_image_path};
+
+    if (compressed)
+        decoder.emplace(final_image_path);
+    else if (!MP_FILEOPS.open(file, QIODevice::WriteOnly | QIODevice::Truncate))
+        throw std::runtime_error(fmt::format("failed to open {} for writing", final_image_path));
+
+    url_downloader->stream_to(
+        info.image_location,
+        [&](const QByteArray& data) {
+            if (info.verify)
+                hash.addData(data);
+
+            if (decoder)
+                decoder->decode(data.constData(), data.size());
+            else if (MP_FILEOPS.write(file, data) != data.size())
+                throw std::runtime_error(fmt::format("error writing image: {}", file.errorString()));
+        },
+        info.size, LaunchProgress::IMAGE, monitor);
+
+    // Both mostly happened along with the download, but clients still expect to hear about them
+    if (info.verify)
+    {
+        monitor(LaunchProgress::VERIFY, -1);
+        if (hash.result().toHex() != info.id)
+            throw std::runtime_error("Downloaded image hash does not match");
+    }
+
+    if (decoder)
+    {
+        monitor(LaunchProgress::EXTRACT, -1);
+        decoder->finish();
+    }
+    else
+        file.close();
+
+    return final_image_path;
+}
+
 QString mp::DefaultVMImageVault::extract_image_from(const std::string& instance_name, const VMImage& source_image,
                                                     const ProgressMonitor& monitor)
 {
@@ -712,6 +763,46 @@ mp::VMImageInfo mp::DefaultVMImageVault::get_kernel_query_info(const std::string
     return info_for(kernel_query);
 }
 
+void mp::DefaultVMImageVault::backfill_original_releases()
+{
+    std::vector<std::pair<std::string, std::string>> missing_releases; // instance name and image id
+    {
+        std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+        for (const auto& record : instance_image_records)
+            if (record.second.image.original_release.empty() && !record.second.image.id.empty())
+                missing_releases.emplace_back(record.first, record.second.image.id);
+    }
+
+    for (const auto& [name, id] : missing_releases)
+    {
+        std::string original_release;
+        for (const auto& image_host : image_hosts)
+        {
+            try
+            {
+                original_release = image_host->info_for_full_hash(id).release_title.toStdString();
+                if (!original_release.empty())
+                    break;
+            }
+            catch (const std::exception& e)
+            {
+                mpl::log(mpl::Level::debug, category, fmt::format("Cannot fetch image information: {}", e.what()));
+            }
+        }
+
+        if (original_release.empty())
+            continue;
+
+        std::lock_guard<decltype(fetch_mutex)> lock{fetch_mutex};
+        auto name_entry = instance_image_records.find(name);
+        if (name_entry != instance_image_records.end() && name_entry->second.image.id == id)
+        {
+            name_entry->second.image.original_release = original_release;
+            persist_instance_records();
+        }
+    }
+}
+
 namespace
 {
 template <typename T>
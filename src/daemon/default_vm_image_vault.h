@@ -62,6 +62,7 @@ private:
     VMImage download_and_prepare_source_image(const VMImageInfo& info, std::optional<VMImage>& existing_source_image,
                                               const QDir& image_dir, const FetchType& fetch_type,
                                               const PrepareAction& prepare, const ProgressMonitor& monitor);
+    QString download_image(const VMImageInfo& info, const Path& image_path, const ProgressMonitor& monitor);
     QString extract_image_from(const std::string& instance_name, const VMImage& source_image,
                                const ProgressMonitor& monitor);
     VMImage fetch_kernel_and_initrd(const VMImageInfo& info, const VMImage& source_image, const QDir& image_dir,
@@ -69,6 +70,7 @@ private:
     std::optional<QFuture<VMImage>> get_image_future(const std::string& id);
     VMImage finalize_image_records(const Query& query, const VMImage& prepared_image, const std::string& id);
     VMImageInfo get_kernel_query_info(const std::string& name);
+    void backfill_original_releases();
     void persist_image_records();
     void persist_instance_records();
 
@@ -83,6 +85,7 @@ private:
     std::unordered_map<std::string, VaultRecord> prepared_image_records;
     std::unordered_map<std::string, VaultRecord> instance_image_records;
     std::unordered_map<std::string, QFuture<VMImage>> in_progress_image_fetches;
+    QFuture<void> release_backfill;
 };
 } // namespace multipass
 #endif // MULTIPASS_DEFAULT_VM_IMAGE_VAULT_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "instance_metrics.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/ssh/ssh_session.h>
+#include <multipass/utils.h>
+
+#include <sstream>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "instance metrics";
+
+// Memory is accounted like `free` does, disk like `df` does for the root filesystem. Each metric comes out as a
+// key=value line, so a failing one does not take the others with it.
+const std::string metrics_cmd{R"((
+read -r l1 l2 l3 rest < /proc/loadavg && echo "load=$l1 $l2 $l3"
+awk '{ m[$1] = $2 * 1024 } END { printf "memory_total=%.0f\nmemory_used=%.0f\n", m["MemTotal:"],
+     m["MemTotal:"] - m["MemFree:"] - m["Buffers:"] - m["Cached:"] - m["SReclaimable:"] }' /proc/meminfo
+stat -f -c '%S %b %f' / | awk '{ printf "disk_total=%.0f\ndisk_used=%.0f\n", $1 * $2, $1 * ($2 - $3) }'
+echo "cpu_count=$(nproc)"
+. /etc/os-release && echo "release=$PRETTY_NAME"
+))"};
+} // namespace
+
+mp::InstanceMetrics mp::collect_instance_metrics(SSHSession& session)
+{
+    auto proc = session.exec(metrics_cmd);
+
+    if (auto exit_code = proc.exit_code(); exit_code != 0)
+    {
+        auto error_msg = proc.read_std_error();
+        mpl::log(mpl::Level::warning, category,
+                 fmt::format("failed to collect all metrics ({}): '{}'", exit_code, mp::utils::trim_end(error_msg)));
+    }
+
+    return parse_instance_metrics(proc.read_std_output());
+}
+
+mp::InstanceMetrics mp::parse_instance_metrics(const std::string& output)
+{
+    const std::unordered_map<std::string, std::string InstanceMetrics::*> fields{
+        {"load", &InstanceMetrics::load},
+        {"memory_used", &InstanceMetrics::memory_usage},
+        {"memory_total", &InstanceMetrics::memory_total},
+        {"disk_used", &InstanceMetrics::disk_usage},
+        {"disk_total", &InstanceMetrics::disk_total},
+        {"cpu_count", &InstanceMetrics::cpu_count},
+        {"release", &InstanceMetrics::current_release}};
+
+    InstanceMetrics metrics;
+    std::istringstream lines{output};
+    for (std::string line; std::getline(lines, line);)
+    {
+        auto separator = line.find('=');
+        if (separator == std::string::npos)
+            continue;
+
+        auto field = fields.find(line.substr(0, separator));
+        if (field != fields.end())
+        {
+            auto value = line.substr(separator + 1);
+            metrics.*(field->second) = mp::utils::trim_end(value);
+        }
+    }
+
+    return metrics;
+}
+
+mp::InstanceMetricsCache::InstanceMetricsCache(std::chrono::milliseconds ttl) : ttl{ttl}
+{
+}
+
+mp::InstanceMetrics mp::InstanceMetricsCache::get(const std::string& instance_name, const Collector& collect)
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        auto it = entries.find(instance_name);
+        if (it != entries.end() && std::chrono::steady_clock::now() - it->second.collected < ttl)
+            return it->second.metrics;
+    }
+
+    auto metrics = collect();
+
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    entries[instance_name] = {metrics, std::chrono::steady_clock::now()};
+
+    return metrics;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_INSTANCE_METRICS_H
+#define MULTIPASS_INSTANCE_METRICS_H
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace multipass
+{
+class SSHSession;
+
+struct InstanceMetrics
+{
+    std::string load;
+    std::string memory_usage;
+    std::string memory_total;
+    std::string disk_usage;
+    std::string disk_total;
+    std::string cpu_count;
+    std::string current_release;
+};
+
+// Gathers all the metrics with a single command, reading them straight from /proc and statvfs
+InstanceMetrics collect_instance_metrics(SSHSession& session);
+InstanceMetrics parse_instance_metrics(const std::string& output);
+
+// Keeps the metrics of each instance for a little while, so that queries in quick succession don't all need to reach
+// the instance
+class InstanceMetricsCache
+{
+public:
+    using Collector = std::function<InstanceMetrics()>;
+
+    explicit InstanceMetricsCache(std::chrono::milliseconds ttl = std::chrono::seconds(5));
+
+    InstanceMetrics get(const std::string& instance_name, const Collector& collect);
+
+private:
+    struct Entry
+    {
+        InstanceMetrics metrics;
+        std::chrono::steady_clock::time_point collected;
+    };
+
+    const std::chrono::milliseconds ttl;
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+};
+} // namespace multipass
+#endif // MULTIPASS_INSTANCE_METRICS_H
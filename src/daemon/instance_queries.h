@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_INSTANCE_QUERIES_H
+#define MULTIPASS_INSTANCE_QUERIES_H
+
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace multipass
+{
+template <typename Entry>
+struct InstanceQueryResult
+{
+    Entry entry;
+    bool finished;
+    std::string error;
+};
+
+// Runs query over each of entries on pool and returns what was gathered. The query works on its own copy of the entry
+// and calls publish() whenever what it has so far is worth returning. A query that does not finish within timeout of
+// starting, or that waits longer than timeout for a thread, is given up on: its result holds whatever it published
+// last, and anything it does afterwards is dropped. publish() returns false once the query has been given up on, so
+// that it can skip whatever work it has left and free its thread.
+template <typename Entry, typename Query>
+std::vector<InstanceQueryResult<Entry>> query_instances(QThreadPool& pool, std::vector<Entry> entries, Query query,
+                                                        std::chrono::milliseconds timeout)
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<InstanceQueryResult<Entry>> results;
+        std::vector<Clock::time_point> deadlines;
+        std::vector<bool> given_up;
+        std::size_t pending;
+    };
+
+    auto state = std::make_shared<State>();
+    state->deadlines.assign(entries.size(), Clock::now() + timeout);
+    state->given_up.assign(entries.size(), false);
+    state->pending = entries.size();
+    for (const auto& entry : entries)
+        state->results.push_back({entry, false, {}});
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        QtConcurrent::run(&pool, [state, i, query, timeout, entry = std::move(entries[i])]() mutable {
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                if (state->given_up[i])
+                    return;
+
+                state->deadlines[i] = Clock::now() + timeout;
+            }
+            state->cv.notify_all();
+
+            auto publish = [&state, &entry, i] {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                if (state->given_up[i])
+                    return false;
+
+                state->results[i].entry = entry;
+                return true;
+            };
+
+            std::string error;
+            try
+            {
+                query(entry, publish);
+            }
+            catch (const std::exception& e)
+            {
+                error = e.what();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                if (state->given_up[i])
+                    return;
+
+                state->results[i] = {std::move(entry), true, std::move(error)};
+                --state->pending;
+            }
+            state->cv.notify_all();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    while (state->pending)
+    {
+        auto now = Clock::now();
+        auto next_deadline = Clock::time_point::max();
+
+        for (std::size_t i = 0; i < state->results.size(); ++i)
+        {
+            if (state->results[i].finished || state->given_up[i])
+                continue;
+
+            if (state->deadlines[i] <= now)
+            {
+                state->given_up[i] = true;
+                --state->pending;
+            }
+            else
+                next_deadline = std::min(next_deadline, state->deadlines[i]);
+        }
+
+        if (state->pending)
+            state->cv.wait_until(lock, next_deadline);
+    }
+
+    return state->results;
+}
+} // namespace multipass
+#endif // MULTIPASS_INSTANCE_QUERIES_H
@@ -18,6 +18,8 @@
 #include "ubuntu_image_host.h"
 
 #include <multipass/constants.h>
+#include <multipass/file_ops.h>
+#include <multipass/logging/log.h>
 #include <multipass/platform.h>
 #include <multipass/query.h>
 #include <multipass/settings/settings.h>
@@ -29,19 +31,32 @@
 #include <multipass/exceptions/unsupported_image_exception.h>
 #include <multipass/exceptions/unsupported_remote_exception.h>
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QUrl>
 
 #include <algorithm>
 #include <unordered_set>
 
 namespace mp = multipass;
+namespace mpl = multipass::logging;
 
 namespace
 {
+constexpr auto category = "VMImageHost";
 constexpr auto index_path = "streams/v1/index.json";
 
+QString cache_file_path(const QString& cache_dir_path, const std::string& remote_name)
+{
+    return QDir{cache_dir_path}.filePath(QString::fromStdString(remote_name) + ".manifest");
+}
+
 auto download_manifest(const QString& host_url, mp::URLDownloader* url_downloader)
 {
     auto json_index = url_downloader->download({host_url + index_path});
@@ -68,6 +83,18 @@ mp::VMImageInfo with_location_fully_resolved(const QString& host_url, const mp::
             info.verify};
 }
 
+// Products whose id starts with prefix, in id order
+auto products_with_id_prefix(const mp::SimpleStreamsManifest& manifest, const QString& prefix)
+{
+    const auto& index = manifest.products_by_id;
+    auto first = std::lower_bound(index.cbegin(), index.cend(), prefix,
+                                  [](const mp::VMImageInfo* product, const QString& id) { return product->id < id; });
+    auto last = std::find_if_not(first, index.cend(),
+                                 [&prefix](const mp::VMImageInfo* product) { return product->id.startsWith(prefix); });
+
+    return std::make_pair(first, last);
+}
+
 auto key_from(const std::string& search_string)
 {
     auto key = QString::fromStdString(search_string);
@@ -78,13 +105,25 @@ auto key_from(const std::string& search_string)
 } // namespace
 
 mp::UbuntuVMImageHost::UbuntuVMImageHost(std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes,
-                                         URLDownloader* downloader, std::chrono::seconds manifest_time_to_live)
-    : CommonVMImageHost{manifest_time_to_live}, url_downloader{downloader}, remotes{std::move(remotes)}
+                                         URLDownloader* downloader, std::chrono::seconds manifest_time_to_live,
+                                         const QString& cache_dir_path)
+    : CommonVMImageHost{manifest_time_to_live},
+      url_downloader{downloader},
+      remotes{std::move(remotes)},
+      cache_dir_path{cache_dir_path}
+{
+    load_cached_manifests();
+}
+
+mp::UbuntuVMImageHost::~UbuntuVMImageHost()
 {
+    wait_for_manifest_refresh();
 }
 
 std::optional<mp::VMImageInfo> mp::UbuntuVMImageHost::info_for(const Query& query)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     auto images = all_info_for(query);
 
     if (images.size() == 0)
@@ -103,6 +142,8 @@ std::optional<mp::VMImageInfo> mp::UbuntuVMImageHost::info_for(const Query& quer
 
 std::vector<std::pair<std::string, mp::VMImageInfo>> mp::UbuntuVMImageHost::all_info_for(const Query& query)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     auto key = key_from(query.release);
     check_alias_is_supported(key.toStdString(), query.remote_name);
 
@@ -149,10 +190,12 @@ std::vector<std::pair<std::string, mp::VMImageInfo>> mp::UbuntuVMImageHost::all_
         else
         {
             std::unordered_set<std::string> found_hashes;
+            const auto [first, last] = products_with_id_prefix(*manifest, key);
 
-            for (const auto& entry : manifest->products)
+            for (auto it = first; it != last; ++it)
             {
-                if (entry.id.startsWith(key) && (entry.supported || query.allow_unsupported) &&
+                const auto& entry = **it;
+                if ((entry.supported || query.allow_unsupported) &&
                     found_hashes.find(entry.id.toStdString()) == found_hashes.end())
                 {
                     images.push_back(std::make_pair(
@@ -169,15 +212,12 @@ std::vector<std::pair<std::string, mp::VMImageInfo>> mp::UbuntuVMImageHost::all_
 
 mp::VMImageInfo mp::UbuntuVMImageHost::info_for_full_hash_impl(const std::string& full_hash)
 {
+    const auto key = QString::fromStdString(full_hash);
     for (const auto& manifest : manifests)
     {
-        for (const auto& product : manifest.second->products)
-        {
-            if (product.id.toStdString() == full_hash)
-            {
-                return with_location_fully_resolved(QString::fromStdString(remote_url_from(manifest.first)), product);
-            }
-        }
+        const auto [first, last] = products_with_id_prefix(*manifest.second, key);
+        if (first != last && (*first)->id == key)
+            return with_location_fully_resolved(QString::fromStdString(remote_url_from(manifest.first)), **first);
     }
 
     // TODO: Throw a specific exception type here so callers can be more specific about what to catch
@@ -188,6 +228,8 @@ mp::VMImageInfo mp::UbuntuVMImageHost::info_for_full_hash_impl(const std::string
 std::vector<mp::VMImageInfo> mp::UbuntuVMImageHost::all_images_for(const std::string& remote_name,
                                                                    const bool allow_unsupported)
 {
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
     std::vector<mp::VMImageInfo> images;
     auto manifest = manifest_from(remote_name);
 
@@ -234,6 +276,9 @@ std::vector<std::string> mp::UbuntuVMImageHost::supported_remotes()
 
 void mp::UbuntuVMImageHost::fetch_manifests()
 {
+    // Remotes absent from here keep whatever manifest they had; a null manifest means the remote has none to offer
+    std::unordered_map<std::string, std::pair<QByteArray, std::unique_ptr<SimpleStreamsManifest>>> fetched;
+
     for (const auto& [remote_name, remote_info] : remotes)
     {
         try
@@ -250,13 +295,31 @@ void mp::UbuntuVMImageHost::fetch_manifests()
                 manifest_bytes_from_mirror = std::make_optional(bytes);
             }
 
+            // The downloader revalidates against its disk cache, so an unchanged manifest comes back with the same
+            // bytes; there is no point in parsing it all over again
+            QCryptographicHash hash{QCryptographicHash::Sha256};
+            hash.addData(mirror_site.value_or(official_site).toUtf8());
+            hash.addData(manifest_bytes_from_official);
+            if (manifest_bytes_from_mirror)
+                hash.addData(manifest_bytes_from_mirror.value());
+            auto digest = hash.result();
+
+            {
+                std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+                auto it = manifest_digests.find(remote_name);
+                if (it != manifest_digests.end() && it->second == digest)
+                    continue;
+            }
+
             auto manifest = mp::SimpleStreamsManifest::fromJson(
                 manifest_bytes_from_official, manifest_bytes_from_mirror, mirror_site.value_or(official_site));
-            manifests.emplace_back(std::make_pair(remote_name, std::move(manifest)));
+            cache_manifest(remote_name, mirror_site.value_or(official_site), digest, *manifest);
+            fetched.emplace(remote_name, std::make_pair(std::move(digest), std::move(manifest)));
         }
         catch (mp::EmptyManifestException& /* e */)
         {
             on_manifest_empty(fmt::format("Did not find any supported products in \"{}\"", remote_name));
+            fetched.emplace(remote_name, std::make_pair(QByteArray{}, nullptr));
         }
         catch (mp::GenericManifestException& e)
         {
@@ -268,14 +331,43 @@ void mp::UbuntuVMImageHost::fetch_manifests()
         }
         catch (const mp::UnsupportedRemoteException&)
         {
-            continue;
+            fetched.emplace(remote_name, std::make_pair(QByteArray{}, nullptr));
         }
     }
+
+    std::lock_guard<decltype(manifest_mutex)> lock{manifest_mutex};
+
+    std::vector<std::pair<std::string, std::unique_ptr<SimpleStreamsManifest>>> updated_manifests;
+    for (const auto& [remote_name, _] : remotes)
+    {
+        if (auto it = fetched.find(remote_name); it != fetched.end())
+        {
+            auto& [digest, manifest] = it->second;
+            if (manifest)
+            {
+                manifest_digests[remote_name] = digest;
+                updated_manifests.emplace_back(remote_name, std::move(manifest));
+            }
+            else
+            {
+                manifest_digests.erase(remote_name);
+            }
+        }
+        else
+        {
+            auto old = std::find_if(manifests.begin(), manifests.end(),
+                                    [&name = remote_name](const auto& element) { return element.first == name; });
+            if (old != manifests.end())
+                updated_manifests.push_back(std::move(*old));
+        }
+    }
+
+    manifests = std::move(updated_manifests);
 }
 
-void mp::UbuntuVMImageHost::clear()
+bool mp::UbuntuVMImageHost::has_manifests() const
 {
-    manifests.clear();
+    return !manifests.empty();
 }
 
 mp::SimpleStreamsManifest* mp::UbuntuVMImageHost::manifest_from(const std::string& remote)
@@ -297,6 +389,69 @@ mp::SimpleStreamsManifest* mp::UbuntuVMImageHost::manifest_from(const std::strin
     return it->second.get();
 }
 
+// Serves whatever was last fetched until the first refresh completes, so that a freshly started daemon does not need
+// the network, nor to parse any JSON, to answer queries. Manifests older than the refresh interval are left out, so
+// that the first query fetches them inline rather than being answered from a stale copy
+void mp::UbuntuVMImageHost::load_cached_manifests()
+{
+    if (cache_dir_path.isEmpty())
+        return;
+
+    for (const auto& [remote_name, remote_info] : remotes)
+    {
+        QFile file{cache_file_path(cache_dir_path, remote_name)};
+        if (!MP_FILEOPS.exists(file) || !MP_FILEOPS.open(file, QIODevice::ReadOnly))
+            continue;
+
+        try
+        {
+            check_remote_is_supported(remote_name);
+
+            QDataStream stream{MP_FILEOPS.read_all(file)};
+            QString url;
+            QByteArray digest, data;
+            qint64 fetched_at{0};
+            stream >> url >> digest >> fetched_at >> data;
+
+            // A changed mirror means different image locations
+            if (stream.status() != QDataStream::Ok || url != remote_info.get_url())
+                continue;
+
+            const auto age = std::chrono::milliseconds{QDateTime::currentMSecsSinceEpoch() - fetched_at};
+            if (age.count() < 0 || age >= manifest_time_to_live)
+                continue;
+
+            manifests.emplace_back(remote_name, mp::SimpleStreamsManifest::fromBinary(data));
+            manifest_digests[remote_name] = digest;
+        }
+        catch (const mp::UnsupportedRemoteException&)
+        {
+            continue;
+        }
+        catch (const std::exception& e)
+        {
+            mpl::log(mpl::Level::debug, category,
+                     fmt::format("Ignoring cached manifest for \"{}\": {}", remote_name, e.what()));
+        }
+    }
+}
+
+void mp::UbuntuVMImageHost::cache_manifest(const std::string& remote_name, const QString& url,
+                                           const QByteArray& digest, const SimpleStreamsManifest& manifest)
+{
+    if (cache_dir_path.isEmpty())
+        return;
+
+    QByteArray contents;
+    QDataStream stream{&contents, QIODevice::WriteOnly};
+    stream << url << digest << QDateTime::currentMSecsSinceEpoch() << manifest.toBinary();
+
+    QSaveFile file{cache_file_path(cache_dir_path, remote_name)};
+    if (!MP_FILEOPS.open(file, QIODevice::WriteOnly) || MP_FILEOPS.write(file, contents) != contents.size() ||
+        !MP_FILEOPS.commit(file))
+        mpl::log(mpl::Level::warning, category, fmt::format("Could not cache manifest for \"{}\"", remote_name));
+}
+
 const mp::VMImageInfo* mp::UbuntuVMImageHost::match_alias(const QString& key,
                                                           const mp::SimpleStreamsManifest& manifest) const
 {
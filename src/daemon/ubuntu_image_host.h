@@ -21,9 +21,11 @@
 #include "common_image_host.h"
 #include "multipass/simple_streams_manifest.h"
 
+#include <QByteArray>
 #include <QString>
 
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -39,7 +41,8 @@ class UbuntuVMImageHost final : public CommonVMImageHost
 {
 public:
     UbuntuVMImageHost(std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes, URLDownloader* downloader,
-                      std::chrono::seconds manifest_time_to_live);
+                      std::chrono::seconds manifest_time_to_live, const QString& cache_dir_path = QString());
+    ~UbuntuVMImageHost() override;
 
     std::optional<VMImageInfo> info_for(const Query& query) override;
     std::vector<std::pair<std::string, VMImageInfo>> all_info_for(const Query& query) override;
@@ -50,16 +53,21 @@ protected:
     void for_each_entry_do_impl(const Action& action) override;
     VMImageInfo info_for_full_hash_impl(const std::string& full_hash) override;
     void fetch_manifests() override;
-    void clear() override;
+    bool has_manifests() const override;
 
 private:
     SimpleStreamsManifest* manifest_from(const std::string& remote);
+    void load_cached_manifests();
+    void cache_manifest(const std::string& remote_name, const QString& url, const QByteArray& digest,
+                        const SimpleStreamsManifest& manifest);
     const VMImageInfo* match_alias(const QString& key, const SimpleStreamsManifest& manifest) const;
     std::vector<std::pair<std::string, std::unique_ptr<SimpleStreamsManifest>>> manifests;
+    std::unordered_map<std::string, QByteArray> manifest_digests;
     URLDownloader* const url_downloader;
     std::vector<std::pair<std::string, UbuntuVMImageRemote>> remotes;
     std::string remote_url_from(const std::string& remote_name);
     QString index_path;
+    const QString cache_dir_path;
 };
 class UbuntuVMImageRemote
 {
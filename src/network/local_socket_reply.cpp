@@ -20,6 +20,7 @@
 #include <multipass/exceptions/http_local_socket_exception.h>
 #include <multipass/format.h>
 
+#include <utility>
 #include <vector>
 
 #include <QRegularExpression>
@@ -28,7 +29,6 @@ namespace mp = multipass;
 
 namespace
 {
-constexpr int len = 65536;
 constexpr int max_bytes = 32768;
 
 // Status code mapping based on
@@ -80,18 +80,30 @@ QNetworkReply::NetworkError statusCodeFromHttp(int httpStatusCode)
 
     return code;
 }
+
+// Only requests that can safely be sent twice are retried, and only if whatever they send can be read again
+bool can_retry(const QNetworkRequest& request, QIODevice* outgoing_data)
+{
+    const auto op = request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+    const auto idempotent = op == "GET" || op == "HEAD" || op == "PUT" || op == "DELETE" || op == "OPTIONS";
+
+    return idempotent && (!outgoing_data || !outgoing_data->isSequential());
+}
 } // namespace
 
 mp::LocalSocketReply::LocalSocketReply(LocalSocketUPtr local_socket, const QNetworkRequest& request,
-                                       QIODevice* outgoingData)
-    : QNetworkReply(), local_socket{std::move(local_socket)}, reply_data{QByteArray(len, '\0')}
+                                       QIODevice* outgoingData, const ReleaseSocket& release_socket,
+                                       const Reconnect& reconnect)
+    : QNetworkReply(),
+      local_socket{std::move(local_socket)},
+      release_socket{release_socket},
+      reconnect{can_retry(request, outgoingData) ? reconnect : nullptr},
+      request{request},
+      outgoing_data{outgoingData}
 {
     open(QIODevice::ReadOnly);
 
-    QObject::connect(this->local_socket.get(), &QLocalSocket::readyRead, this, &LocalSocketReply::read_reply);
-    QObject::connect(this->local_socket.get(), &QLocalSocket::readChannelFinished, this,
-                     &LocalSocketReply::read_finish);
-
+    connect_socket();
     send_request(request, outgoingData);
 }
 
@@ -137,6 +149,45 @@ qint64 mp::LocalSocketReply::readData(char* data, qint64 maxSize)
     return -1;
 }
 
+void mp::LocalSocketReply::connect_socket()
+{
+    QObject::connect(local_socket.get(), &QLocalSocket::readyRead, this, &LocalSocketReply::read_reply);
+    QObject::connect(local_socket.get(), &QLocalSocket::readChannelFinished, this, &LocalSocketReply::read_finish);
+}
+
+// Sends the request again on a fresh connection, at most once. Returns whether it did.
+bool mp::LocalSocketReply::retry()
+{
+    if (!reconnect)
+        return false;
+
+    auto fresh_socket = std::exchange(reconnect, nullptr)();
+    if (!fresh_socket)
+        return false;
+
+    QObject::disconnect(local_socket.get(), nullptr, this, nullptr);
+    local_socket.release()->deleteLater(); // We may be called while it is emitting readChannelFinished
+    local_socket = std::move(fresh_socket);
+    connect_socket();
+
+    try
+    {
+        if (outgoing_data)
+            outgoing_data->reset();
+
+        send_request(request, outgoing_data);
+    }
+    catch (const std::exception& e)
+    {
+        setError(QNetworkReply::InternalServerError, e.what());
+        emit error(QNetworkReply::InternalServerError);
+
+        finish(false);
+    }
+
+    return true;
+}
+
 void mp::LocalSocketReply::send_request(const QNetworkRequest& request, QIODevice* outgoingData)
 {
     QByteArray http_data;
@@ -172,10 +223,6 @@ void mp::LocalSocketReply::send_request(const QNetworkRequest& request, QIODevic
         http_data += "User-Agent: " + user_agent + "\r\n";
     }
 
-    // Workaround weird issue in LXD's use of Go where Go's HTTP handler thinks there is more
-    // data and "sees" and "empty" query and reponds with an unexpected 400 error
-    http_data += "Connection: close\r\n";
-
     if (!local_socket_write(http_data))
         return;
 
@@ -240,8 +287,16 @@ void mp::LocalSocketReply::send_request(const QNetworkRequest& request, QIODevic
                     fmt::format("Cannot read data to send to socket: {}", outgoingData->errorString()));
             }
 
+            // Nothing can follow a body of known length, or the server would read it as the start of another request
+            // on the same connection
+            if (!is_chunked)
+            {
+                local_socket->flush();
+                return;
+            }
+
             // Trailer part for chunked data
-            if (is_chunked && !local_socket_write("0\r\n"))
+            if (!local_socket_write("0\r\n"))
                 return;
         }
     }
@@ -254,22 +309,16 @@ void mp::LocalSocketReply::send_request(const QNetworkRequest& request, QIODevic
 
 void mp::LocalSocketReply::read_reply()
 {
-    auto data_ptr = reply_data.data() + reply_offset;
-    int bytes_read{0};
+    if (isFinished())
+        return;
 
-    do
-    {
-        if (reply_offset + local_socket->bytesAvailable() > reply_data.length())
-        {
-            reply_data.append(len, '\0');
-            data_ptr = reply_data.data() + reply_offset;
-        }
+    reply_data.append(local_socket->readAll());
 
-        bytes_read = local_socket->read(data_ptr, len);
+    if (!headers_parsed && !parse_headers())
+        return;
 
-        reply_offset += bytes_read;
-        data_ptr += bytes_read;
-    } while (bytes_read > 0);
+    if (parse_body())
+        finish(keep_alive && reply_data.isEmpty() && !local_socket->bytesAvailable());
 }
 
 void mp::LocalSocketReply::read_finish()
@@ -277,37 +326,141 @@ void mp::LocalSocketReply::read_finish()
     if (local_socket->bytesAvailable())
         read_reply();
 
-    if (reply_offset)
-        parse_reply();
+    if (isFinished())
+        return;
 
-    setFinished(true);
-    emit finished();
+    if (!headers_parsed && reply_data.isEmpty())
+    {
+        // The server may have been done with a reused connection just as we sent the request on it
+        if (retry())
+            return;
+
+        if (error() == QNetworkReply::NoError)
+        {
+            setError(QNetworkReply::RemoteHostClosedError, "Connection closed before the server answered");
+            emit error(QNetworkReply::RemoteHostClosedError);
+        }
+
+        finish(false);
+        return;
+    }
+
+    // Whatever arrived before the server closed the connection is all there is
+    if (!headers_parsed && !parse_headers())
+        parse_status(reply_data.left(reply_data.indexOf('\n')).trimmed());
+    else if (headers_parsed && !chunked_transfer_encoding)
+        content_data = reply_data.trimmed();
+
+    finish(false);
 }
 
-void mp::LocalSocketReply::parse_reply()
+bool mp::LocalSocketReply::parse_headers()
 {
-    auto reply_lines = reply_data.split('\n');
-    auto it = reply_lines.constBegin();
+    const auto end_of_headers = reply_data.indexOf("\r\n\r\n");
+    if (end_of_headers < 0)
+        return false;
 
-    parse_status(*it);
+    const auto header_lines = reply_data.left(end_of_headers).split('\n');
+    auto it = header_lines.constBegin();
 
-    for (++it; it != reply_lines.constEnd(); ++it)
+    parse_status((*it).trimmed());
+    if (!(*it).startsWith("HTTP/1.1"))
+        keep_alive = false;
+
+    for (++it; it != header_lines.constEnd(); ++it)
     {
-        if ((*it).contains("Transfer-Encoding") && (*it).contains("chunked"))
+        const auto separator = (*it).indexOf(':');
+        if (separator < 0)
+            continue;
+
+        const auto name = (*it).left(separator).trimmed().toLower();
+        const auto value = (*it).mid(separator + 1).trimmed().toLower();
+
+        if (name == "transfer-encoding" && value.contains("chunked"))
             chunked_transfer_encoding = true;
+        else if (name == "content-length")
+            content_length = value.toInt();
+        else if (name == "connection" && value.contains("close"))
+            keep_alive = false;
+    }
+
+    // Without either, the body only ends when the server closes the connection
+    if (!chunked_transfer_encoding && !content_length)
+        keep_alive = false;
+
+    reply_data.remove(0, end_of_headers + 4);
+    headers_parsed = true;
+
+    return true;
+}
+
+// Returns whether the whole body has been read. One that is neither chunked nor of known length goes on until the
+// server closes the connection.
+bool mp::LocalSocketReply::parse_body()
+{
+    if (chunked_transfer_encoding)
+        return parse_chunks();
+
+    if (!content_length)
+        return false;
+
+    if (reply_data.size() < *content_length)
+        return false;
 
-        if ((*it).isEmpty() || (*it).startsWith('\r'))
+    content_data = reply_data.left(*content_length);
+    reply_data.remove(0, *content_length);
+
+    return true;
+}
+
+bool mp::LocalSocketReply::parse_chunks()
+{
+    while (true)
+    {
+        const auto end_of_size = reply_data.indexOf("\r\n");
+        if (end_of_size < 0)
+            return false;
+
+        bool ok;
+        const auto chunk_size = reply_data.left(end_of_size).split(';').first().trimmed().toInt(&ok, 16);
+        if (!ok)
         {
-            // Advance to the body
-            // Chunked transfer encoding also includes a line with the amount of
-            // bytes (in hex) in the chunk. We just skip it for now.
-            it = chunked_transfer_encoding ? it + 2 : it + 1;
+            setError(QNetworkReply::ProtocolFailure, "Malformed chunk in HTTP response from server");
+            emit error(QNetworkReply::ProtocolFailure);
 
-            content_data = (*it).trimmed();
+            keep_alive = false;
+            return true;
+        }
 
-            break;
+        // The last chunk is followed by optional trailers and an empty line
+        if (chunk_size == 0)
+        {
+            const auto end_of_trailers = reply_data.indexOf("\r\n\r\n", end_of_size);
+            if (end_of_trailers < 0)
+                return false;
+
+            reply_data.remove(0, end_of_trailers + 4);
+            return true;
         }
+
+        if (reply_data.size() < end_of_size + 2 + chunk_size + 2)
+            return false;
+
+        content_data.append(reply_data.mid(end_of_size + 2, chunk_size));
+        reply_data.remove(0, end_of_size + 2 + chunk_size + 2);
+    }
+}
+
+void mp::LocalSocketReply::finish(bool reusable)
+{
+    if (reusable && release_socket)
+    {
+        QObject::disconnect(local_socket.get(), nullptr, this, nullptr);
+        release_socket(std::move(local_socket));
     }
+
+    setFinished(true);
+    emit finished();
 }
 
 void mp::LocalSocketReply::parse_status(const QByteArray& status)
@@ -340,6 +493,9 @@ bool mp::LocalSocketReply::local_socket_write(const QByteArray& data)
     auto bytes_written = local_socket->write(data);
     if (bytes_written < 0)
     {
+        if (retry())
+            return false;
+
         setError(QNetworkReply::InternalServerError, local_socket->errorString());
         emit error(QNetworkReply::InternalServerError);
 
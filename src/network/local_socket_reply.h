@@ -24,7 +24,9 @@
 #include <QNetworkRequest>
 #include <QString>
 
+#include <functional>
 #include <memory>
+#include <optional>
 
 namespace multipass
 {
@@ -34,7 +36,13 @@ class LocalSocketReply : public QNetworkReply
 {
     Q_OBJECT
 public:
-    LocalSocketReply(LocalSocketUPtr local_socket, const QNetworkRequest& request, QIODevice* outgoingData);
+    // Called with the socket once a whole reply was read from it and the server is keeping the connection open
+    using ReleaseSocket = std::function<void(LocalSocketUPtr)>;
+    // Called for a fresh connection when a reused one fails before the server answered, to send the request again
+    using Reconnect = std::function<LocalSocketUPtr()>;
+
+    LocalSocketReply(LocalSocketUPtr local_socket, const QNetworkRequest& request, QIODevice* outgoingData,
+                     const ReleaseSocket& release_socket = nullptr, const Reconnect& reconnect = nullptr);
     LocalSocketReply();
     virtual ~LocalSocketReply();
 
@@ -50,16 +58,27 @@ private slots:
     void read_finish();
 
 private:
+    void connect_socket();
+    bool retry();
     void send_request(const QNetworkRequest& request, QIODevice* outgoingData);
-    void parse_reply();
+    bool parse_headers();
+    bool parse_body();
+    bool parse_chunks();
     void parse_status(const QByteArray& status);
+    void finish(bool reusable);
     bool local_socket_write(const QByteArray& data);
 
     LocalSocketUPtr local_socket;
+    ReleaseSocket release_socket;
+    Reconnect reconnect;
+    QNetworkRequest request;
+    QIODevice* outgoing_data;
     QByteArray reply_data;
-    qint64 reply_offset{0};
     qint64 offset{0};
+    bool headers_parsed{false};
     bool chunked_transfer_encoding{false};
+    std::optional<int> content_length;
+    bool keep_alive{true};
 };
 } // namespace multipass
 
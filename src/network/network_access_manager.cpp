@@ -21,12 +21,41 @@
 #include <multipass/format.h>
 #include <multipass/network_access_manager.h>
 
+#include <QPointer>
+
 namespace mp = multipass;
 
+namespace
+{
+constexpr auto max_idle_sockets = 8u; // per socket path
+constexpr auto idle_timeout = std::chrono::seconds(30);
+
+mp::LocalSocketUPtr connect_to(const QString& socket_path)
+{
+    auto local_socket = std::make_unique<QLocalSocket>();
+
+    local_socket->connectToServer(socket_path);
+    if (!local_socket->waitForConnected(5000))
+    {
+        throw mp::LocalSocketConnectionException(
+            fmt::format("Cannot connect to {}: {}", socket_path, local_socket->errorString()));
+    }
+
+    return local_socket;
+}
+} // namespace
+
 mp::NetworkAccessManager::NetworkAccessManager(QObject* parent) : QNetworkAccessManager(parent)
 {
 }
 
+mp::NetworkAccessManager::~NetworkAccessManager() = default;
+
+mp::NetworkAccessManager::UPtr mp::NetworkAccessManager::make_for_current_thread() const
+{
+    return std::make_unique<NetworkAccessManager>();
+}
+
 QNetworkReply* mp::NetworkAccessManager::createRequest(QNetworkAccessManager::Operation operation,
                                                        const QNetworkRequest& orig_request, QIODevice* device)
 {
@@ -47,14 +76,23 @@ QNetworkReply* mp::NetworkAccessManager::createRequest(QNetworkAccessManager::Op
 
         const auto socket_path = QUrl(url_parts[0]).path();
 
-        LocalSocketUPtr local_socket = std::make_unique<QLocalSocket>();
-
-        local_socket->connectToServer(socket_path);
-        if (!local_socket->waitForConnected(5000))
+        LocalSocketReply::Reconnect reconnect;
+        LocalSocketUPtr local_socket = take_idle_socket(socket_path);
+        if (local_socket)
         {
-            throw LocalSocketConnectionException(
-                fmt::format("Cannot connect to {}: {}", socket_path, local_socket->errorString()));
+            reconnect = [socket_path]() -> LocalSocketUPtr {
+                try
+                {
+                    return connect_to(socket_path);
+                }
+                catch (const LocalSocketConnectionException&)
+                {
+                    return nullptr;
+                }
+            };
         }
+        else
+            local_socket = connect_to(socket_path);
 
         const auto server_path = url_parts[1];
         QNetworkRequest request{orig_request};
@@ -64,11 +102,46 @@ QNetworkReply* mp::NetworkAccessManager::createRequest(QNetworkAccessManager::Op
 
         request.setUrl(url);
 
+        auto release_socket = [manager = QPointer<NetworkAccessManager>(this), socket_path](LocalSocketUPtr socket) {
+            if (manager)
+                manager->release_socket(socket_path, std::move(socket));
+        };
+
         // The caller needs to be responsible for freeing the allocated memory
-        return new LocalSocketReply(std::move(local_socket), request, device);
+        return new LocalSocketReply(std::move(local_socket), request, device, release_socket, reconnect);
     }
     else
     {
         return QNetworkAccessManager::createRequest(operation, orig_request, device);
     }
 }
+
+mp::LocalSocketUPtr mp::NetworkAccessManager::take_idle_socket(const QString& socket_path)
+{
+    auto it = idle_sockets.find(socket_path);
+    if (it == idle_sockets.end())
+        return nullptr;
+
+    auto& sockets = it->second;
+    while (!sockets.empty())
+    {
+        auto idle = std::move(sockets.back());
+        sockets.pop_back();
+
+        // Anything arriving on an idle connection, or it being closed, means the server is done with it
+        if (std::chrono::steady_clock::now() - idle.since < idle_timeout && !idle.socket->waitForReadyRead(0) &&
+            idle.socket->state() == QLocalSocket::ConnectedState)
+            return std::move(idle.socket);
+    }
+
+    return nullptr;
+}
+
+void mp::NetworkAccessManager::release_socket(const QString& socket_path, LocalSocketUPtr socket)
+{
+    auto& sockets = idle_sockets[socket_path];
+    if (sockets.size() < max_idle_sockets)
+        sockets.push_back({std::move(socket), std::chrono::steady_clock::now()});
+    else
+        socket.release()->deleteLater(); // We're called while the socket is emitting readyRead
+}
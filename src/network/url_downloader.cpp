@@ -31,6 +31,7 @@
 #include <QTimer>
 #include <QUrl>
 
+#include <exception>
 #include <memory>
 
 namespace mp = multipass;
@@ -124,6 +125,28 @@ QByteArray download(QNetworkAccessManager* manager, const Time& timeout, QUrl co
     return reply->readAll();
 }
 
+auto make_progress_monitor(const std::atomic_bool& abort_downloads, std::atomic_bool& abort_download,
+                           const mp::ProgressMonitor& monitor, const int download_type, const int64_t size)
+{
+    return [&abort_downloads, &abort_download, &monitor, download_type, size](
+               QNetworkReply* reply, qint64 bytes_received, qint64 bytes_total) {
+        if (bytes_received == 0)
+            return;
+
+        if (bytes_total == -1 && size > 0)
+            bytes_total = size;
+
+        auto progress = (size < 0) ? size : (100 * bytes_received + bytes_total / 2) / bytes_total;
+
+        abort_download = abort_downloads || !monitor(download_type, progress);
+
+        if (abort_download)
+        {
+            reply->abort();
+        }
+    };
+}
+
 template <typename Time>
 auto get_header(QNetworkAccessManager* manager, const QUrl& url, const QNetworkRequest::KnownHeaders header,
                 const Time& timeout)
@@ -180,27 +203,59 @@ void mp::URLDownloader::download_to(const QUrl& url, const QString& file_name, i
     QFile file{file_name};
     file.open(QIODevice::ReadWrite | QIODevice::Truncate);
 
-    auto progress_monitor = [this, &abort_download, &monitor, download_type,
-                             size](QNetworkReply* reply, qint64 bytes_received, qint64 bytes_total) {
-        if (bytes_received == 0)
-            return;
+    auto progress_monitor = make_progress_monitor(abort_downloads, abort_download, monitor, download_type, size);
 
-        if (bytes_total == -1 && size > 0)
-            bytes_total = size;
+    auto on_download = [this, &abort_download, &file](QNetworkReply* reply, QTimer& download_timeout) {
+        abort_download = abort_download || abort_downloads;
 
-        auto progress = (size < 0) ? size : (100 * bytes_received + bytes_total / 2) / bytes_total;
+        if (abort_download)
+        {
+            reply->abort();
+            return;
+        }
 
-        abort_download = abort_downloads || !monitor(download_type, progress);
+        if (download_timeout.isActive())
+            download_timeout.stop();
+        else
+            return;
 
-        if (abort_download)
+        if (MP_FILEOPS.write(file, reply->readAll()) < 0)
         {
+            mpl::log(mpl::Level::error, category, fmt::format("error writing image: {}", file.errorString()));
+            abort_download = true;
             reply->abort();
         }
+        download_timeout.start();
     };
 
-    auto on_download = [this, &abort_download, &file](QNetworkReply* reply, QTimer& download_timeout) {
+    auto on_error = [&file]() { file.remove(); };
+
+    ::download(manager.get(), timeout, url, progress_monitor, on_download, on_error, abort_download);
+}
+
+void mp::URLDownloader::stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                                  const ProgressMonitor& monitor)
+{
+    std::atomic_bool abort_download{false};
+    std::exception_ptr sink_error;
+    QNetworkReply* current_reply{nullptr};
+    qint64 bytes_streamed{0};
+    auto manager{MP_NETMGRFACTORY.make_network_manager(cache_dir_path)};
+
+    auto progress_monitor = make_progress_monitor(abort_downloads, abort_download, monitor, download_type, size);
+
+    auto on_download = [&](QNetworkReply* reply, QTimer& download_timeout) {
         abort_download = abort_download || abort_downloads;
 
+        // Data already handed over can't be taken back, so there is no starting over from the cache halfway through
+        if (reply != current_reply && bytes_streamed > 0 && !abort_download)
+        {
+            sink_error = std::make_exception_ptr(
+                mp::DownloadException{url.toString().toStdString(), "download interrupted"});
+            abort_download = true;
+        }
+        current_reply = reply;
+
         if (abort_download)
         {
             reply->abort();
@@ -212,18 +267,36 @@ void mp::URLDownloader::download_to(const QUrl& url, const QString& file_name, i
         else
             return;
 
-        if (MP_FILEOPS.write(file, reply->readAll()) < 0)
+        try
         {
-            mpl::log(mpl::Level::error, category, fmt::format("error writing image: {}", file.errorString()));
+            const auto data = reply->readAll();
+            bytes_streamed += data.size();
+            sink(data);
+        }
+        catch (...)
+        {
+            sink_error = std::current_exception();
             abort_download = true;
             reply->abort();
+            return;
         }
+
         download_timeout.start();
     };
 
-    auto on_error = [&file]() { file.remove(); };
+    try
+    {
+        const auto rest = ::download(manager.get(), timeout, url, progress_monitor, on_download, [] {}, abort_download);
+        if (!rest.isEmpty())
+            sink(rest);
+    }
+    catch (const std::exception&)
+    {
+        if (sink_error)
+            std::rethrow_exception(sink_error);
 
-    ::download(manager.get(), timeout, url, progress_monitor, on_download, on_error, abort_download);
+        throw;
+    }
 }
 
 QByteArray mp::URLDownloader::download(const QUrl& url)
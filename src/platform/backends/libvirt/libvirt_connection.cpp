@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "libvirt_connection.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+
+#include <stdexcept>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "libvirt connection";
+constexpr auto keepalive_interval = 5; // in seconds
+constexpr auto keepalive_count = 3u;   // unanswered keepalives before the connection is considered dead
+} // namespace
+
+mp::LibvirtConnection::LibvirtConnection(const LibvirtWrapper::UPtr& libvirt_wrapper) : libvirt_wrapper{libvirt_wrapper}
+{
+}
+
+mp::LibvirtConnection::~LibvirtConnection()
+{
+    {
+        std::lock_guard<decltype(connection_mutex)> lock{connection_mutex};
+        drop_connection();
+    }
+
+    stop_event_loop();
+}
+
+auto mp::LibvirtConnection::acquire() -> ConnectionUPtr
+{
+    if (!libvirt_wrapper)
+        throw std::runtime_error("The libvirt library is not loaded. Please ensure libvirt is installed and running.");
+
+    std::lock_guard<decltype(connection_mutex)> lock{connection_mutex};
+    if (!connection || libvirt_wrapper->virConnectIsAlive(connection) != 1)
+    {
+        drop_connection();
+
+        // libvirt needs an event loop registered before connecting to deliver events and send keepalives
+        start_event_loop();
+
+        connection = libvirt_wrapper->virConnectOpen("qemu:///system");
+        if (!connection)
+        {
+            throw std::runtime_error(
+                fmt::format("Cannot connect to libvirtd: {}\nPlease ensure libvirt is installed and running.",
+                            libvirt_wrapper->virGetLastErrorMessage()));
+        }
+
+        if (event_thread.joinable())
+        {
+            if (libvirt_wrapper->virConnectSetKeepAlive(connection, keepalive_interval, keepalive_count) < 0)
+                mpl::log(mpl::Level::debug, category,
+                         fmt::format("Cannot enable keepalives: {}", libvirt_wrapper->virGetLastErrorMessage()));
+
+            event_callback_id = libvirt_wrapper->virConnectDomainEventRegisterAny(
+                connection, nullptr, VIR_DOMAIN_EVENT_ID_LIFECYCLE, VIR_DOMAIN_EVENT_CALLBACK(on_lifecycle_event),
+                this, nullptr);
+            if (event_callback_id < 0)
+                mpl::log(mpl::Level::debug, category,
+                         fmt::format("Cannot follow domain events: {}", libvirt_wrapper->virGetLastErrorMessage()));
+        }
+
+        std::lock_guard<decltype(status_mutex)> status_lock{status_mutex};
+        following_events = event_callback_id >= 0;
+    }
+
+    libvirt_wrapper->virConnectRef(connection);
+    return {connection, libvirt_wrapper->virConnectClose};
+}
+
+auto mp::LibvirtConnection::generation() const -> std::optional<Generation>
+{
+    std::lock_guard<decltype(connection_mutex)> lock{connection_mutex};
+    if (!connection || libvirt_wrapper->virConnectIsAlive(connection) != 1)
+        return std::nullopt;
+
+    std::lock_guard<decltype(status_mutex)> status_lock{status_mutex};
+    if (!following_events)
+        return std::nullopt;
+
+    return current_generation;
+}
+
+auto mp::LibvirtConnection::status_for(const std::string& name) const -> std::optional<DomainStatus>
+{
+    std::lock_guard<decltype(status_mutex)> lock{status_mutex};
+    if (!following_events)
+        return std::nullopt;
+
+    auto it = statuses.find(name);
+    if (it == statuses.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+void mp::LibvirtConnection::insert_status(const std::string& name, const DomainStatus& status, Generation generation)
+{
+    std::lock_guard<decltype(status_mutex)> lock{status_mutex};
+    if (following_events && generation == current_generation)
+        statuses[name] = status;
+}
+
+void mp::LibvirtConnection::invalidate(const std::string& name)
+{
+    std::lock_guard<decltype(status_mutex)> lock{status_mutex};
+    statuses.erase(name);
+    ++current_generation;
+}
+
+int mp::LibvirtConnection::on_lifecycle_event(virConnectPtr /*connection*/, virDomainPtr domain, int /*event*/,
+                                              int /*detail*/, void* opaque)
+{
+    auto self = static_cast<LibvirtConnection*>(opaque);
+    auto name = self->libvirt_wrapper->virDomainGetName(domain);
+
+    std::lock_guard<decltype(status_mutex)> lock{self->status_mutex};
+    if (name)
+        self->statuses.erase(name);
+    else
+        self->statuses.clear();
+    ++self->current_generation;
+
+    return 0;
+}
+
+void mp::LibvirtConnection::on_wake_up(int /*timer*/, void* /*opaque*/)
+{
+}
+
+// Called with connection_mutex held
+void mp::LibvirtConnection::start_event_loop()
+{
+    if (event_thread.joinable())
+        return;
+
+    // The default event loop can only be registered once per process
+    static const bool registered = libvirt_wrapper->virEventRegisterDefaultImpl() == 0;
+    if (!registered)
+    {
+        mpl::log(mpl::Level::debug, category,
+                 fmt::format("Cannot register an event loop: {}", libvirt_wrapper->virGetLastErrorMessage()));
+        return;
+    }
+
+    // A disabled timer that is armed to make the loop go around once more when stopping
+    wake_up_timer = libvirt_wrapper->virEventAddTimeout(-1, on_wake_up, nullptr, nullptr);
+    if (wake_up_timer < 0)
+        return;
+
+    running = true;
+    event_thread = std::thread{[this] {
+        while (running)
+        {
+            if (libvirt_wrapper->virEventRunDefaultImpl() < 0)
+            {
+                mpl::log(mpl::Level::warning, category,
+                         fmt::format("Stopped following events: {}", libvirt_wrapper->virGetLastErrorMessage()));
+                break;
+            }
+        }
+    }};
+}
+
+void mp::LibvirtConnection::stop_event_loop()
+{
+    if (!event_thread.joinable())
+        return;
+
+    running = false;
+    libvirt_wrapper->virEventUpdateTimeout(wake_up_timer, 0);
+    event_thread.join();
+    libvirt_wrapper->virEventRemoveTimeout(wake_up_timer);
+}
+
+// Called with connection_mutex held
+void mp::LibvirtConnection::drop_connection()
+{
+    if (!connection)
+        return;
+
+    if (event_callback_id >= 0)
+        libvirt_wrapper->virConnectDomainEventDeregisterAny(connection, event_callback_id);
+
+    libvirt_wrapper->virConnectClose(connection);
+    connection = nullptr;
+    event_callback_id = -1;
+
+    forget_statuses();
+}
+
+void mp::LibvirtConnection::forget_statuses()
+{
+    std::lock_guard<decltype(status_mutex)> lock{status_mutex};
+    following_events = false;
+    statuses.clear();
+    ++current_generation;
+}
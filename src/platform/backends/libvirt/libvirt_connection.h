@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_LIBVIRT_CONNECTION_H
+#define MULTIPASS_LIBVIRT_CONNECTION_H
+
+#include "libvirt_wrapper.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace multipass
+{
+// Keeps one connection to libvirtd open for everything a factory and its instances do, opening it again when it
+// goes away. While it is up, domain lifecycle events are followed on a thread running libvirt's event loop and the
+// status of each domain is kept until an event says it changed, so that asking for it again doesn't need a round
+// trip to libvirtd.
+class LibvirtConnection
+{
+public:
+    using ConnectionUPtr = std::unique_ptr<virConnect, decltype(virConnectClose)*>;
+    using Generation = std::uint64_t;
+
+    struct DomainStatus
+    {
+        int state;
+        bool has_managed_save;
+    };
+
+    // Needs to be a reference so testing can override the various libvirt functions
+    explicit LibvirtConnection(const LibvirtWrapper::UPtr& libvirt_wrapper);
+    ~LibvirtConnection();
+
+    // Returns a new reference to the shared connection, connecting first if it is not alive
+    ConnectionUPtr acquire();
+
+    // Returns the current generation, or nothing when not following events. Inserting with a generation that is no
+    // longer current is ignored, so a status that may have changed while the caller was fetching it is not kept.
+    std::optional<Generation> generation() const;
+    std::optional<DomainStatus> status_for(const std::string& name) const;
+    void insert_status(const std::string& name, const DomainStatus& status, Generation generation);
+    void invalidate(const std::string& name);
+
+private:
+    static int on_lifecycle_event(virConnectPtr connection, virDomainPtr domain, int event, int detail, void* opaque);
+    static void on_wake_up(int timer, void* opaque);
+
+    void start_event_loop();
+    void stop_event_loop();
+    void drop_connection();
+    void forget_statuses();
+
+    const LibvirtWrapper::UPtr& libvirt_wrapper;
+    mutable std::mutex connection_mutex;
+    virConnectPtr connection{nullptr};
+    int event_callback_id{-1};
+    int wake_up_timer{-1};
+    std::atomic_bool running{false};
+    std::thread event_thread;
+    mutable std::mutex status_mutex;
+    bool following_events{false};
+    Generation current_generation{0};
+    std::unordered_map<std::string, DomainStatus> statuses;
+};
+} // namespace multipass
+
+#endif // MULTIPASS_LIBVIRT_CONNECTION_H
@@ -57,14 +57,15 @@ auto instance_mac_addr_for(virDomainPtr domain, const mp::LibvirtWrapper::UPtr&
     return mac_addr;
 }
 
-auto instance_ip_for(const std::string& mac_addr, const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
+auto instance_ip_for(const std::string& mac_addr, mp::LibvirtConnection& libvirt_connection,
+                     const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
 {
     std::optional<mp::IPAddress> ip_address;
 
     mp::LibVirtVirtualMachine::ConnectionUPtr connection{nullptr, nullptr};
     try
     {
-        connection = mp::LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+        connection = libvirt_connection.acquire();
     }
     catch (const std::exception&)
     {
@@ -202,18 +203,32 @@ auto domain_by_definition_for(const mp::VirtualMachineDescription& desc, const s
     return domain;
 }
 
-auto refresh_instance_state_for_domain(virDomainPtr domain, const mp::VirtualMachine::State& current_instance_state,
-                                       const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
+std::optional<mp::LibvirtConnection::DomainStatus> domain_status_for(virDomainPtr domain,
+                                                                     const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
 {
     auto domain_state{0};
 
-    if (!domain || libvirt_wrapper->virDomainGetState(domain, &domain_state, nullptr, 0) == -1 ||
-        domain_state == VIR_DOMAIN_NOSTATE)
+    if (!domain || libvirt_wrapper->virDomainGetState(domain, &domain_state, nullptr, 0) == -1)
+        return std::nullopt;
+
+    if (domain_state == VIR_DOMAIN_NOSTATE)
+        return mp::LibvirtConnection::DomainStatus{domain_state, false};
+
+    return mp::LibvirtConnection::DomainStatus{domain_state,
+                                               libvirt_wrapper->virDomainHasManagedSaveImage(domain, 0) == 1};
+}
+
+auto instance_state_for(const std::optional<mp::LibvirtConnection::DomainStatus>& domain_status,
+                        const mp::VirtualMachine::State& current_instance_state)
+{
+    if (!domain_status || domain_status->state == VIR_DOMAIN_NOSTATE)
         return mp::VirtualMachine::State::unknown;
 
-    if (libvirt_wrapper->virDomainHasManagedSaveImage(domain, 0) == 1)
+    if (domain_status->has_managed_save)
         return mp::VirtualMachine::State::suspended;
 
+    const auto domain_state = domain_status->state;
+
     // Most of these libvirt domain states don't have a Multipass instance state
     // analogue, so we'll treat them as "off".
     const auto domain_off_states = {VIR_DOMAIN_BLOCKED, VIR_DOMAIN_PAUSED,  VIR_DOMAIN_SHUTDOWN,
@@ -228,6 +243,12 @@ auto refresh_instance_state_for_domain(virDomainPtr domain, const mp::VirtualMac
     return current_instance_state;
 }
 
+auto refresh_instance_state_for_domain(virDomainPtr domain, const mp::VirtualMachine::State& current_instance_state,
+                                       const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
+{
+    return instance_state_for(domain_status_for(domain, libvirt_wrapper), current_instance_state);
+}
+
 bool domain_is_running(virDomainPtr domain, const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
 {
     auto domain_state{0};
@@ -259,17 +280,19 @@ void update_max_and_property(virDomainPtr domain_ptr, Updater* fun_ptr, Integer
 
 mp::LibVirtVirtualMachine::LibVirtVirtualMachine(const mp::VirtualMachineDescription& desc,
                                                  const std::string& bridge_name, mp::VMStatusMonitor& monitor,
-                                                 const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
+                                                 const mp::LibvirtWrapper::UPtr& libvirt_wrapper,
+                                                 mp::LibvirtConnection& libvirt_connection)
     : BaseVirtualMachine{desc.vm_name},
       username{desc.ssh_username},
       desc{desc},
       monitor{&monitor},
       bridge_name{bridge_name},
-      libvirt_wrapper{libvirt_wrapper}
+      libvirt_wrapper{libvirt_wrapper},
+      libvirt_connection{libvirt_connection}
 {
     try
     {
-        initialize_domain_info(open_libvirt_connection(libvirt_wrapper).get());
+        initialize_domain_info(libvirt_connection.acquire().get());
     }
     catch (const std::exception&)
     {
@@ -287,7 +310,7 @@ mp::LibVirtVirtualMachine::~LibVirtVirtualMachine()
 
 void mp::LibVirtVirtualMachine::start()
 {
-    auto connection = open_libvirt_connection(libvirt_wrapper);
+    auto connection = libvirt_connection.acquire();
     DomainUPtr domain{nullptr, nullptr};
 
     if (state == VirtualMachine::State::unknown)
@@ -325,6 +348,7 @@ void mp::LibVirtVirtualMachine::start()
         throw std::runtime_error(error_string);
     }
 
+    libvirt_connection.invalidate(vm_name);
     monitor->on_resume();
 }
 
@@ -336,7 +360,7 @@ void mp::LibVirtVirtualMachine::stop()
 void mp::LibVirtVirtualMachine::shutdown()
 {
     std::unique_lock<decltype(state_mutex)> lock{state_mutex};
-    auto domain = domain_by_name_for(vm_name, open_libvirt_connection(libvirt_wrapper).get(), libvirt_wrapper);
+    auto domain = domain_by_name_for(vm_name, libvirt_connection.acquire().get(), libvirt_wrapper);
     state = refresh_instance_state_for_domain(domain.get(), state, libvirt_wrapper);
     if (state == State::running || state == State::delayed_shutdown || state == State::unknown)
     {
@@ -348,12 +372,14 @@ void mp::LibVirtVirtualMachine::shutdown()
             throw std::runtime_error(warning_string);
         }
 
+        libvirt_connection.invalidate(vm_name);
         state = State::off;
         update_state();
     }
     else if (state == State::starting)
     {
         libvirt_wrapper->virDomainDestroy(domain.get());
+        libvirt_connection.invalidate(vm_name);
         state_wait.wait(lock, [this] { return shutdown_while_starting; });
         update_state();
     }
@@ -368,7 +394,7 @@ void mp::LibVirtVirtualMachine::shutdown()
 
 void mp::LibVirtVirtualMachine::suspend()
 {
-    auto domain = domain_by_name_for(vm_name, open_libvirt_connection(libvirt_wrapper).get(), libvirt_wrapper);
+    auto domain = domain_by_name_for(vm_name, libvirt_connection.acquire().get(), libvirt_wrapper);
     state = refresh_instance_state_for_domain(domain.get(), state, libvirt_wrapper);
     if (state == State::running || state == State::delayed_shutdown)
     {
@@ -380,6 +406,7 @@ void mp::LibVirtVirtualMachine::suspend()
             throw std::runtime_error(warning_string);
         }
 
+        libvirt_connection.invalidate(vm_name);
         if (update_suspend_status)
         {
             state = State::suspended;
@@ -396,20 +423,36 @@ void mp::LibVirtVirtualMachine::suspend()
 
 mp::VirtualMachine::State mp::LibVirtVirtualMachine::current_state()
 {
+    std::optional<LibvirtConnection::DomainStatus> domain_status;
+    auto failed = false;
+
     try
     {
-        auto connection = open_libvirt_connection(libvirt_wrapper);
-        auto domain = domain_by_name_for(vm_name, connection.get(), libvirt_wrapper);
-        if (!domain)
-            initialize_domain_info(connection.get());
+        // The status is kept between calls while libvirt events say the domain didn't change
+        auto generation = libvirt_connection.generation();
+        domain_status = generation ? libvirt_connection.status_for(vm_name) : std::nullopt;
 
-        state = refresh_instance_state_for_domain(domain.get(), state, libvirt_wrapper);
+        if (!domain_status)
+        {
+            auto connection = libvirt_connection.acquire();
+            auto domain = domain_by_name_for(vm_name, connection.get(), libvirt_wrapper);
+            if (!domain)
+                initialize_domain_info(connection.get());
+
+            domain_status = domain_status_for(domain.get(), libvirt_wrapper);
+            if (domain_status && generation)
+                libvirt_connection.insert_status(vm_name, *domain_status, *generation);
+        }
     }
     catch (const std::exception&)
     {
-        state = VirtualMachine::State::unknown;
+        failed = true;
     }
 
+    // This is called from the daemon's instance queries as well as its own thread, so only touch state under the lock
+    std::lock_guard<decltype(state_mutex)> lock{state_mutex};
+    state = failed ? VirtualMachine::State::unknown : instance_state_for(domain_status, state);
+
     return state;
 }
 
@@ -421,7 +464,7 @@ int mp::LibVirtVirtualMachine::ssh_port()
 void mp::LibVirtVirtualMachine::ensure_vm_is_running()
 {
     auto is_vm_running = [this] {
-        auto domain = domain_by_name_for(vm_name, open_libvirt_connection(libvirt_wrapper).get(), libvirt_wrapper);
+        auto domain = domain_by_name_for(vm_name, libvirt_connection.acquire().get(), libvirt_wrapper);
         return domain_is_running(domain.get(), libvirt_wrapper);
     };
 
@@ -430,7 +473,9 @@ void mp::LibVirtVirtualMachine::ensure_vm_is_running()
 
 std::string mp::LibVirtVirtualMachine::ssh_hostname(std::chrono::milliseconds timeout)
 {
-    auto get_ip = [this]() -> std::optional<IPAddress> { return instance_ip_for(mac_addr, libvirt_wrapper); };
+    auto get_ip = [this]() -> std::optional<IPAddress> {
+        return instance_ip_for(mac_addr, libvirt_connection, libvirt_wrapper);
+    };
 
     return mp::backend::ip_address_for(this, get_ip, timeout);
 }
@@ -444,7 +489,7 @@ std::string mp::LibVirtVirtualMachine::management_ipv4()
 {
     if (!management_ip)
     {
-        auto result = instance_ip_for(mac_addr, libvirt_wrapper);
+        auto result = instance_ip_for(mac_addr, libvirt_connection, libvirt_wrapper);
         if (result)
             management_ip.emplace(result.value());
         else
@@ -489,7 +534,7 @@ mp::LibVirtVirtualMachine::DomainUPtr mp::LibVirtVirtualMachine::initialize_doma
 
 mp::LibVirtVirtualMachine::DomainUPtr mp::LibVirtVirtualMachine::checked_vm_domain() const
 {
-    auto connection = open_libvirt_connection(libvirt_wrapper);
+    auto connection = libvirt_connection.acquire();
     assert(connection && "should have thrown otherwise");
 
     auto domain = domain_by_name_for(vm_name, connection.get(), libvirt_wrapper);
@@ -500,24 +545,6 @@ mp::LibVirtVirtualMachine::DomainUPtr mp::LibVirtVirtualMachine::checked_vm_doma
     return domain;
 }
 
-mp::LibVirtVirtualMachine::ConnectionUPtr
-mp::LibVirtVirtualMachine::open_libvirt_connection(const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
-{
-    if (!libvirt_wrapper)
-        throw std::runtime_error("The libvirt library is not loaded. Please ensure libvirt is installed and running.");
-
-    mp::LibVirtVirtualMachine::ConnectionUPtr connection{libvirt_wrapper->virConnectOpen("qemu:///system"),
-                                                         libvirt_wrapper->virConnectClose};
-    if (!connection)
-    {
-        throw std::runtime_error(
-            fmt::format("Cannot connect to libvirtd: {}\nPlease ensure libvirt is installed and running.",
-                        libvirt_wrapper->virGetLastErrorMessage()));
-    }
-
-    return connection;
-}
-
 void mp::LibVirtVirtualMachine::update_cpus(int num_cores)
 {
     assert(num_cores > 0);
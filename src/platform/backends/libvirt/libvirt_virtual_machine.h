@@ -18,6 +18,7 @@
 #ifndef MULTIPASS_LIBVIRT_VIRTUAL_MACHINE_H
 #define MULTIPASS_LIBVIRT_VIRTUAL_MACHINE_H
 
+#include "libvirt_connection.h"
 #include "libvirt_wrapper.h"
 
 #include <shared/base_virtual_machine.h>
@@ -31,12 +32,13 @@ class VMStatusMonitor;
 class LibVirtVirtualMachine final : public BaseVirtualMachine
 {
 public:
-    using ConnectionUPtr = std::unique_ptr<virConnect, decltype(virConnectClose)*>;
+    using ConnectionUPtr = LibvirtConnection::ConnectionUPtr;
     using DomainUPtr = std::unique_ptr<virDomain, decltype(virDomainFree)*>;
     using NetworkUPtr = std::unique_ptr<virNetwork, decltype(virNetworkFree)*>;
 
     LibVirtVirtualMachine(const VirtualMachineDescription& desc, const std::string& bridge_name,
-                          VMStatusMonitor& monitor, const LibvirtWrapper::UPtr& libvirt_wrapper);
+                          VMStatusMonitor& monitor, const LibvirtWrapper::UPtr& libvirt_wrapper,
+                          LibvirtConnection& libvirt_connection);
     ~LibVirtVirtualMachine();
 
     void start() override;
@@ -56,8 +58,6 @@ public:
     void resize_memory(const MemorySize& new_size) override;
     void resize_disk(const MemorySize& new_size) override;
 
-    static ConnectionUPtr open_libvirt_connection(const LibvirtWrapper::UPtr& libvirt_wrapper);
-
 private:
     DomainUPtr initialize_domain_info(virConnectPtr connection);
     DomainUPtr checked_vm_domain() const;
@@ -70,6 +70,8 @@ private:
     const std::string& bridge_name;
     // Needs to be a reference so testing can override the various libvirt functions
     const LibvirtWrapper::UPtr& libvirt_wrapper;
+    // Shared with the factory and every other instance
+    LibvirtConnection& libvirt_connection;
     bool update_suspend_status{true};
 };
 } // namespace multipass
@@ -53,12 +53,13 @@ auto generate_libvirt_bridge_xml_config(const mp::Path& data_dir, const std::str
                        bridge_name, subnet, subnet, subnet);
 }
 
-std::string enable_libvirt_network(const mp::Path& data_dir, const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
+std::string enable_libvirt_network(const mp::Path& data_dir, mp::LibvirtConnection& libvirt_connection,
+                                   const mp::LibvirtWrapper::UPtr& libvirt_wrapper)
 {
     mp::LibVirtVirtualMachine::ConnectionUPtr connection{nullptr, nullptr};
     try
     {
-        connection = mp::LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+        connection = libvirt_connection.acquire();
     }
     catch (const std::exception&)
     {
@@ -110,7 +111,7 @@ mp::LibVirtVirtualMachineFactory::LibVirtVirtualMachineFactory(const mp::Path& d
                                                                const std::string& libvirt_object_path)
     : libvirt_wrapper{make_libvirt_wrapper(libvirt_object_path)},
       data_dir{data_dir},
-      bridge_name{enable_libvirt_network(data_dir, libvirt_wrapper)},
+      bridge_name{enable_libvirt_network(data_dir, libvirt_connection, libvirt_wrapper)},
       libvirt_object_path{libvirt_object_path}
 {
 }
@@ -124,16 +125,16 @@ mp::VirtualMachine::UPtr mp::LibVirtVirtualMachineFactory::create_virtual_machin
                                                                                   VMStatusMonitor& monitor)
 {
     if (bridge_name.empty())
-        bridge_name = enable_libvirt_network(data_dir, libvirt_wrapper);
+        bridge_name = enable_libvirt_network(data_dir, libvirt_connection, libvirt_wrapper);
 
-    return std::make_unique<mp::LibVirtVirtualMachine>(desc, bridge_name, monitor, libvirt_wrapper);
+    return std::make_unique<mp::LibVirtVirtualMachine>(desc, bridge_name, monitor, libvirt_wrapper, libvirt_connection);
 }
 
 mp::LibVirtVirtualMachineFactory::~LibVirtVirtualMachineFactory()
 {
     if (bridge_name == multipass_bridge_name)
     {
-        auto connection = LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+        auto connection = libvirt_connection.acquire();
         mp::LibVirtVirtualMachine::NetworkUPtr network{
             libvirt_wrapper->virNetworkLookupByName(connection.get(), "default"), libvirt_wrapper->virNetworkFree};
 
@@ -143,9 +144,10 @@ mp::LibVirtVirtualMachineFactory::~LibVirtVirtualMachineFactory()
 
 void mp::LibVirtVirtualMachineFactory::remove_resources_for(const std::string& name)
 {
-    auto connection = LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+    auto connection = libvirt_connection.acquire();
 
     libvirt_wrapper->virDomainUndefine(libvirt_wrapper->virDomainLookupByName(connection.get(), name.c_str()));
+    libvirt_connection.invalidate(name);
 }
 
 mp::VMImage mp::LibVirtVirtualMachineFactory::prepare_source_image(const VMImage& source_image)
@@ -169,10 +171,10 @@ void mp::LibVirtVirtualMachineFactory::hypervisor_health_check()
     if (!libvirt_wrapper)
         libvirt_wrapper = make_libvirt_wrapper(libvirt_object_path);
 
-    LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+    libvirt_connection.acquire();
 
     if (bridge_name.empty())
-        bridge_name = enable_libvirt_network(data_dir, libvirt_wrapper);
+        bridge_name = enable_libvirt_network(data_dir, libvirt_connection, libvirt_wrapper);
 }
 
 QString mp::LibVirtVirtualMachineFactory::get_backend_version_string()
@@ -180,7 +182,7 @@ QString mp::LibVirtVirtualMachineFactory::get_backend_version_string()
     try
     {
         unsigned long libvirt_version;
-        auto connection = LibVirtVirtualMachine::open_libvirt_connection(libvirt_wrapper);
+        auto connection = libvirt_connection.acquire();
 
         if (libvirt_wrapper->virConnectGetVersion(connection.get(), &libvirt_version) == 0 && libvirt_version != 0)
         {
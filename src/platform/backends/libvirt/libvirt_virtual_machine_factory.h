@@ -17,6 +17,7 @@
 #ifndef MULTIPASS_LIBVIRT_VIRTUAL_MACHINE_FACTORY_H
 #define MULTIPASS_LIBVIRT_VIRTUAL_MACHINE_FACTORY_H
 
+#include "libvirt_connection.h"
 #include "libvirt_wrapper.h"
 
 #include <shared/base_virtual_machine_factory.h>
@@ -47,6 +48,7 @@ public:
     LibvirtWrapper::UPtr libvirt_wrapper;
 
 private:
+    LibvirtConnection libvirt_connection{libvirt_wrapper};
     const Path data_dir;
     std::string bridge_name;
     const std::string libvirt_object_path;
@@ -58,6 +58,14 @@ mp::LibvirtWrapper::LibvirtWrapper(const std::string& filename)
           reinterpret_cast<virConnectGetCapabilities_t>(get_symbol_address_for("virConnectGetCapabilities", handle))},
       virConnectGetVersion{
           reinterpret_cast<virConnectGetVersion_t>(get_symbol_address_for("virConnectGetVersion", handle))},
+      virConnectRef{reinterpret_cast<virConnectRef_t>(get_symbol_address_for("virConnectRef", handle))},
+      virConnectIsAlive{reinterpret_cast<virConnectIsAlive_t>(get_symbol_address_for("virConnectIsAlive", handle))},
+      virConnectSetKeepAlive{
+          reinterpret_cast<virConnectSetKeepAlive_t>(get_symbol_address_for("virConnectSetKeepAlive", handle))},
+      virConnectDomainEventRegisterAny{reinterpret_cast<virConnectDomainEventRegisterAny_t>(
+          get_symbol_address_for("virConnectDomainEventRegisterAny", handle))},
+      virConnectDomainEventDeregisterAny{reinterpret_cast<virConnectDomainEventDeregisterAny_t>(
+          get_symbol_address_for("virConnectDomainEventDeregisterAny", handle))},
       virNetworkLookupByName{
           reinterpret_cast<virNetworkLookupByName_t>(get_symbol_address_for("virNetworkLookupByName", handle))},
       virNetworkCreateXML{
@@ -75,6 +83,7 @@ mp::LibvirtWrapper::LibvirtWrapper(const std::string& filename)
       virDomainUndefine{reinterpret_cast<virDomainUndefine_t>(get_symbol_address_for("virDomainUndefine", handle))},
       virDomainLookupByName{
           reinterpret_cast<virDomainLookupByName_t>(get_symbol_address_for("virDomainLookupByName", handle))},
+      virDomainGetName{reinterpret_cast<virDomainGetName_t>(get_symbol_address_for("virDomainGetName", handle))},
       virDomainGetXMLDesc{
           reinterpret_cast<virDomainGetXMLDesc_t>(get_symbol_address_for("virDomainGetXMLDesc", handle))},
       virDomainDestroy{reinterpret_cast<virDomainDestroy_t>(get_symbol_address_for("virDomainDestroy", handle))},
@@ -92,7 +101,16 @@ mp::LibvirtWrapper::LibvirtWrapper(const std::string& filename)
       virDomainSetMemoryFlags{
           reinterpret_cast<virDomainSetMemoryFlags_t>(get_symbol_address_for("virDomainSetMemoryFlags", handle))},
       virGetLastErrorMessage{
-          reinterpret_cast<virGetLastErrorMessage_t>(get_symbol_address_for("virGetLastErrorMessage", handle))}
+          reinterpret_cast<virGetLastErrorMessage_t>(get_symbol_address_for("virGetLastErrorMessage", handle))},
+      virEventRegisterDefaultImpl{reinterpret_cast<virEventRegisterDefaultImpl_t>(
+          get_symbol_address_for("virEventRegisterDefaultImpl", handle))},
+      virEventRunDefaultImpl{
+          reinterpret_cast<virEventRunDefaultImpl_t>(get_symbol_address_for("virEventRunDefaultImpl", handle))},
+      virEventAddTimeout{reinterpret_cast<virEventAddTimeout_t>(get_symbol_address_for("virEventAddTimeout", handle))},
+      virEventUpdateTimeout{
+          reinterpret_cast<virEventUpdateTimeout_t>(get_symbol_address_for("virEventUpdateTimeout", handle))},
+      virEventRemoveTimeout{
+          reinterpret_cast<virEventRemoveTimeout_t>(get_symbol_address_for("virEventRemoveTimeout", handle))}
 {
 }
 
@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "lxd_event_monitor.h"
+#include "lxd_request.h"
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+#include <cassert>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "lxd events";
+constexpr auto connect_timeout = 5000;   // in milliseconds
+constexpr auto handshake_timeout = 5000; // in milliseconds
+constexpr auto poll_interval = 250;      // in milliseconds, how often to check whether we're being stopped
+constexpr quint64 max_frame_size = 16 * 1024 * 1024;
+
+enum Opcode
+{
+    continuation = 0x0,
+    text = 0x1,
+    binary = 0x2,
+    close = 0x8,
+    ping = 0x9,
+    pong = 0xA
+};
+
+// Both are empty when base_url does not point to a local socket, in which case there is nothing to follow
+QStringList split_base_url(const QUrl& base_url)
+{
+    auto url_parts = base_url.toString().split('@');
+    if (url_parts.count() != 2 || (base_url.scheme() != "unix" && base_url.scheme() != "local"))
+        return {QString{}, QString{}};
+
+    return {QUrl(url_parts[0]).path(),
+            QString("/%1/events?type=lifecycle,operation&project=%2").arg(url_parts[1]).arg(mp::lxd_project_name)};
+}
+
+QByteArray random_bytes(int count)
+{
+    QByteArray bytes(count, '\0');
+    for (auto& byte : bytes)
+        byte = static_cast<char>(QRandomGenerator::global()->bounded(256));
+
+    return bytes;
+}
+
+// Frames sent by a client must be masked, see RFC 6455, section 5.3
+void send_frame(QLocalSocket& socket, Opcode opcode, const QByteArray& payload)
+{
+    assert(payload.size() <= 125 && "only control frames are sent");
+
+    QByteArray frame;
+    frame.append(static_cast<char>(0x80 | opcode));
+    frame.append(static_cast<char>(0x80 | payload.size()));
+
+    auto mask = random_bytes(4);
+    frame.append(mask);
+    for (auto i = 0; i < payload.size(); ++i)
+        frame.append(static_cast<char>(payload[i] ^ mask[i % 4]));
+
+    socket.write(frame);
+    socket.flush();
+}
+
+QString instance_name_from(const QString& source)
+{
+    // e.g. /1.0/instances/foo?project=multipass
+    auto path = source.section('?', 0, 0);
+    return path.section('/', -1);
+}
+} // namespace
+
+mp::LXDEventMonitor::LXDEventMonitor(const QUrl& base_url, std::chrono::milliseconds reconnect_interval)
+    : socket_path{split_base_url(base_url)[0]},
+      events_path{split_base_url(base_url)[1]},
+      reconnect_interval{reconnect_interval}
+{
+    if (!socket_path.isEmpty())
+        event_thread = std::thread{&LXDEventMonitor::follow_events, this};
+}
+
+mp::LXDEventMonitor::~LXDEventMonitor()
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        stopped = true;
+    }
+    stop_cv.notify_all();
+    operation_cv.notify_all();
+
+    if (event_thread.joinable())
+        event_thread.join();
+}
+
+auto mp::LXDEventMonitor::generation() const -> std::optional<Generation>
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    if (!connected)
+        return std::nullopt;
+
+    return current_generation;
+}
+
+std::optional<mp::VirtualMachine::State> mp::LXDEventMonitor::state_for(const QString& name) const
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    if (!connected)
+        return std::nullopt;
+
+    auto it = states.find(name.toStdString());
+    if (it == states.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+void mp::LXDEventMonitor::insert_state(const QString& name, VirtualMachine::State state, Generation generation)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    if (connected && generation == current_generation)
+        states[name.toStdString()] = state;
+}
+
+bool mp::LXDEventMonitor::watch_operation(const QString& id)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    if (!connected)
+        return false;
+
+    operations.emplace(id.toStdString(), std::nullopt);
+    return true;
+}
+
+std::optional<QJsonObject> mp::LXDEventMonitor::wait_for_operation(const QString& id,
+                                                                   std::chrono::milliseconds timeout)
+{
+    const auto key = id.toStdString();
+
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    operation_cv.wait_for(lock, timeout, [this, &key] {
+        auto it = operations.find(key);
+        return stopped || it == operations.end() || it->second;
+    });
+
+    auto it = operations.find(key);
+    if (it == operations.end())
+        return std::nullopt;
+
+    auto metadata = std::move(it->second);
+    operations.erase(it);
+
+    return metadata;
+}
+
+void mp::LXDEventMonitor::forget_operation(const QString& id)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    operations.erase(id.toStdString());
+}
+
+void mp::LXDEventMonitor::follow_events()
+{
+    do
+    {
+        QLocalSocket socket;
+        socket.connectToServer(socket_path);
+
+        QByteArray leftover;
+        if (socket.waitForConnected(connect_timeout) && handshake(socket, leftover))
+        {
+            mpl::log(mpl::Level::debug, category, "Following LXD events");
+
+            set_connected(true);
+            read_frames(socket, leftover);
+            set_connected(false);
+
+            mpl::log(mpl::Level::debug, category, "Stopped following LXD events");
+        }
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        stop_cv.wait_for(lock, reconnect_interval, [this] { return stopped; });
+    } while (!is_stopped());
+}
+
+bool mp::LXDEventMonitor::handshake(QLocalSocket& socket, QByteArray& leftover)
+{
+    socket.write(QString("GET %1 HTTP/1.1\r\n"
+                         "Host: lxd\r\n"
+                         "Upgrade: websocket\r\n"
+                         "Connection: Upgrade\r\n"
+                         "Sec-WebSocket-Key: %2\r\n"
+                         "Sec-WebSocket-Version: 13\r\n"
+                         "\r\n")
+                     .arg(events_path)
+                     .arg(QString::fromLatin1(random_bytes(16).toBase64()))
+                     .toLatin1());
+
+    QByteArray response;
+    int end_of_headers = -1;
+    while (end_of_headers < 0)
+    {
+        if (!socket.waitForReadyRead(handshake_timeout))
+            return false;
+
+        response.append(socket.readAll());
+        end_of_headers = response.indexOf("\r\n\r\n");
+    }
+
+    if (!response.startsWith("HTTP/1.1 101"))
+    {
+        mpl::log(mpl::Level::debug, category,
+                 fmt::format("Cannot follow LXD events: {}", response.left(response.indexOf("\r\n"))));
+        return false;
+    }
+
+    leftover = response.mid(end_of_headers + 4);
+    return true;
+}
+
+void mp::LXDEventMonitor::read_frames(QLocalSocket& socket, QByteArray buffer)
+{
+    QByteArray message;
+
+    while (!is_stopped())
+    {
+        while (buffer.size() >= 2)
+        {
+            const auto data = reinterpret_cast<const uchar*>(buffer.constData());
+            const bool fin = data[0] & 0x80;
+            const auto opcode = data[0] & 0x0F;
+            const bool masked = data[1] & 0x80;
+
+            quint64 length = data[1] & 0x7F;
+            int header_size = 2;
+            if (length == 126)
+            {
+                if (buffer.size() < 4)
+                    break;
+
+                length = qFromBigEndian<quint16>(data + 2);
+                header_size = 4;
+            }
+            else if (length == 127)
+            {
+                if (buffer.size() < 10)
+                    break;
+
+                length = qFromBigEndian<quint64>(data + 2);
+                header_size = 10;
+            }
+
+            if (length > max_frame_size)
+            {
+                mpl::log(mpl::Level::warning, category, fmt::format("Ignoring oversized frame ({} bytes)", length));
+                return;
+            }
+
+            const int mask_offset = header_size;
+            if (masked)
+                header_size += 4;
+
+            if (static_cast<quint64>(buffer.size()) < header_size + length)
+                break;
+
+            auto payload = buffer.mid(header_size, static_cast<int>(length));
+            if (masked)
+                for (auto i = 0; i < payload.size(); ++i)
+                    payload[i] = static_cast<char>(payload[i] ^ buffer[mask_offset + i % 4]);
+
+            buffer.remove(0, header_size + static_cast<int>(length));
+
+            switch (opcode)
+            {
+            case continuation:
+            case text:
+            case binary:
+                message.append(payload);
+                if (fin)
+                {
+                    handle_event(message);
+                    message.clear();
+                }
+                break;
+            case ping:
+                send_frame(socket, pong, payload);
+                break;
+            case close:
+                return;
+            default:
+                break;
+            }
+        }
+
+        if (!socket.waitForReadyRead(poll_interval) && socket.state() != QLocalSocket::ConnectedState)
+            return;
+
+        buffer.append(socket.readAll());
+    }
+
+    send_frame(socket, close, {});
+}
+
+void mp::LXDEventMonitor::handle_event(const QByteArray& message)
+{
+    auto event = QJsonDocument::fromJson(message).object();
+    if (event["type"].toString() == "operation")
+    {
+        handle_operation(event["metadata"].toObject());
+        return;
+    }
+
+    if (event["type"].toString() != "lifecycle")
+        return;
+
+    auto metadata = event["metadata"].toObject();
+    auto name = instance_name_from(metadata["source"].toString());
+
+    mpl::log(mpl::Level::trace, category,
+             fmt::format("Got LXD event: {} for {}", metadata["action"].toString(), metadata["source"].toString()));
+
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    ++current_generation;
+
+    if (name.isEmpty())
+        states.clear();
+    else
+        states.erase(name.toStdString());
+}
+
+// Operations end with a success (200), failure (400) or cancelled (401) status
+void mp::LXDEventMonitor::handle_operation(const QJsonObject& metadata)
+{
+    if (metadata["status_code"].toInt() < 200)
+        return;
+
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        auto it = operations.find(metadata["id"].toString().toStdString());
+        if (it == operations.end())
+            return;
+
+        it->second = metadata;
+    }
+
+    operation_cv.notify_all();
+}
+
+void mp::LXDEventMonitor::set_connected(bool connected)
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        this->connected = connected;
+        ++current_generation;
+        states.clear();
+
+        // Whoever is waiting can't rely on events anymore
+        operations.clear();
+    }
+
+    operation_cv.notify_all();
+}
+
+bool mp::LXDEventMonitor::is_stopped() const
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    return stopped;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_LXD_EVENT_MONITOR_H
+#define MULTIPASS_LXD_EVENT_MONITOR_H
+
+#include <multipass/virtual_machine.h>
+
+#include <QJsonObject>
+#include <QString>
+#include <QUrl>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+class QByteArray;
+class QLocalSocket;
+
+namespace multipass
+{
+// Follows LXD's lifecycle and operation events over the /1.0/events websocket. The state of each instance is kept
+// until an event says it changed, so that asking for it again doesn't need a request to LXD, and operations can be
+// waited for without holding a request open. Nothing is kept while the websocket is down, since events could be
+// missed.
+class LXDEventMonitor
+{
+public:
+    using Generation = std::uint64_t;
+
+    explicit LXDEventMonitor(const QUrl& base_url,
+                             std::chrono::milliseconds reconnect_interval = std::chrono::seconds(5));
+    ~LXDEventMonitor();
+
+    // Returns the current generation, or nothing when not following events. Inserting with a generation that is no
+    // longer current is ignored, so a state that may have changed while the caller was fetching it is not kept.
+    std::optional<Generation> generation() const;
+    std::optional<VirtualMachine::State> state_for(const QString& name) const;
+    void insert_state(const QString& name, VirtualMachine::State state, Generation generation);
+
+    // Starts keeping the outcome of an operation. Returns false when not following events.
+    bool watch_operation(const QString& id);
+    // Waits for a watched operation to end and returns its metadata, or nothing if it doesn't end within timeout or
+    // events stop being followed. Either way, the operation is no longer watched afterwards.
+    std::optional<QJsonObject> wait_for_operation(const QString& id, std::chrono::milliseconds timeout);
+    void forget_operation(const QString& id);
+
+private:
+    void follow_events();
+    bool handshake(QLocalSocket& socket, QByteArray& leftover);
+    void read_frames(QLocalSocket& socket, QByteArray buffer);
+    bool is_stopped() const;
+    void handle_event(const QByteArray& message);
+    void handle_operation(const QJsonObject& metadata);
+    void set_connected(bool connected);
+
+    const QString socket_path;
+    const QString events_path;
+    const std::chrono::milliseconds reconnect_interval;
+    mutable std::mutex mutex;
+    std::condition_variable stop_cv;
+    std::condition_variable operation_cv;
+    bool stopped{false};
+    bool connected{false};
+    Generation current_generation{0};
+    std::unordered_map<std::string, VirtualMachine::State> states;
+    std::unordered_map<std::string, std::optional<QJsonObject>> operations;
+    std::thread event_thread;
+};
+} // namespace multipass
+#endif // MULTIPASS_LXD_EVENT_MONITOR_H
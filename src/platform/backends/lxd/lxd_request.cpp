@@ -16,6 +16,7 @@
  */
 
 #include "lxd_request.h"
+#include "lxd_event_monitor.h"
 
 #include <multipass/format.h>
 #include <multipass/logging/log.h>
@@ -25,8 +26,13 @@
 #include <QEventLoop>
 #include <QJsonDocument>
 #include <QNetworkReply>
+#include <QThread>
 #include <QTimer>
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 
@@ -34,6 +40,21 @@ namespace
 {
 constexpr auto request_category = "lxd request";
 
+// A network access manager can only be used from the thread it lives in, so requests made from elsewhere (e.g. when
+// the daemon queries several instances at once) go through one the given manager makes for that thread
+mp::NetworkAccessManager* manager_for_current_thread(mp::NetworkAccessManager* manager)
+{
+    if (manager->thread() == QThread::currentThread())
+        return manager;
+
+    thread_local std::unordered_map<const mp::NetworkAccessManager*, mp::NetworkAccessManager::UPtr> thread_managers;
+    auto& thread_manager = thread_managers[manager];
+    if (!thread_manager)
+        thread_manager = manager->make_for_current_thread();
+
+    return thread_manager.get();
+}
+
 template <typename Callable>
 const QJsonObject lxd_request_common(const std::string& method, QUrl& url, int timeout, Callable&& handle_request)
 {
@@ -118,13 +139,46 @@ const QJsonObject lxd_request_common(const std::string& method, QUrl& url, int t
 
     return json_reply.object();
 }
+
+// Returns an empty object when the operation's end can't be learned from events, so the caller waits on it instead
+QJsonObject wait_for_operation_event(mp::NetworkAccessManager* manager, const QUrl& base_url, const QString& id,
+                                     std::chrono::milliseconds timeout, mp::LXDEventMonitor& event_monitor)
+{
+    if (!event_monitor.watch_operation(id))
+        return {};
+
+    // It may have ended before it was being watched
+    QJsonObject operation;
+    try
+    {
+        operation = mp::lxd_request(manager, "GET", QUrl(QString("%1/operations/%2").arg(base_url.toString()).arg(id)));
+    }
+    catch (const std::exception&)
+    {
+        event_monitor.forget_operation(id);
+        throw;
+    }
+
+    if (operation["metadata"].toObject()["status_code"].toInt() >= 200)
+    {
+        event_monitor.forget_operation(id);
+        return operation;
+    }
+
+    auto metadata = event_monitor.wait_for_operation(id, timeout);
+    if (!metadata)
+        return {};
+
+    return QJsonObject{{"type", "sync"}, {"status", "Success"}, {"status_code", 200}, {"metadata", *metadata}};
+}
 } // namespace
 
 const QJsonObject mp::lxd_request(mp::NetworkAccessManager* manager, const std::string& method, QUrl url,
                                   const std::optional<QJsonObject>& json_data, int timeout)
 try
 {
-    auto handle_request = [manager, &json_data](QNetworkRequest& request, const QByteArray& verb) {
+    auto handle_request = [manager = manager_for_current_thread(manager), &json_data](QNetworkRequest& request,
+                                                                                       const QByteArray& verb) {
         QByteArray data;
         if (json_data)
         {
@@ -152,7 +206,8 @@ const QJsonObject mp::lxd_request(mp::NetworkAccessManager* manager, const std::
                                   QHttpMultiPart& multi_part, int timeout)
 try
 {
-    auto handle_request = [manager, &multi_part](QNetworkRequest& request, const QByteArray& verb) {
+    auto handle_request = [manager = manager_for_current_thread(manager), &multi_part](QNetworkRequest& request,
+                                                                                        const QByteArray& verb) {
         request.setRawHeader("Transfer-Encoding", "chunked");
 
         return manager->sendCustomRequest(request, verb, &multi_part);
@@ -168,7 +223,7 @@ catch (const LXDRuntimeError& e)
 }
 
 const QJsonObject mp::lxd_wait(mp::NetworkAccessManager* manager, const QUrl& base_url, const QJsonObject& task_data,
-                               int timeout)
+                               int timeout, LXDEventMonitor* event_monitor)
 try
 {
     QJsonObject task_reply;
@@ -176,11 +231,23 @@ try
     if (task_data["metadata"].toObject()["class"] == QStringLiteral("task") &&
         task_data["status_code"].toInt(-1) == 100)
     {
-        QUrl task_url(QString("%1/operations/%2/wait")
-                          .arg(base_url.toString())
-                          .arg(task_data["metadata"].toObject()["id"].toString()));
+        const auto id = task_data["metadata"].toObject()["id"].toString();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+        if (event_monitor)
+            task_reply = wait_for_operation_event(manager, base_url, id, std::chrono::milliseconds(timeout),
+                                                  *event_monitor);
 
-        task_reply = lxd_request(manager, "GET", task_url, std::nullopt, timeout);
+        if (task_reply.isEmpty())
+        {
+            // Give the operation a last chance to report how it ended if the time already ran out waiting for events
+            const auto time_left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            QUrl task_url(QString("%1/operations/%2/wait").arg(base_url.toString()).arg(id));
+
+            task_reply = lxd_request(manager, "GET", task_url, std::nullopt,
+                                     std::max(static_cast<int>(time_left.count()), std::min(timeout, 1000)));
+        }
 
         if (task_reply["error_code"].toInt() >= 400)
         {
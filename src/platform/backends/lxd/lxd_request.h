@@ -30,6 +30,7 @@ namespace multipass
 const QUrl lxd_socket_url{"unix:///var/snap/lxd/common/lxd/unix.socket@1.0"};
 const QString lxd_project_name{"multipass"};
 
+class LXDEventMonitor;
 class NetworkAccessManager;
 
 class LXDNotFoundException : public std::runtime_error
@@ -63,8 +64,10 @@ const QJsonObject lxd_request(NetworkAccessManager* manager, const std::string&
 const QJsonObject lxd_request(NetworkAccessManager* manager, const std::string& method, QUrl url,
                               QHttpMultiPart& multi_part, int timeout = 30000 /* in milliseconds */);
 
+// When given an event monitor that is following LXD's events, the operation's outcome is taken from those instead of
+// keeping a request open until it ends
 const QJsonObject lxd_wait(NetworkAccessManager* manager, const QUrl& base_url, const QJsonObject& task_data,
-                           int timeout /* in milliseconds */);
+                           int timeout /* in milliseconds */, LXDEventMonitor* event_monitor = nullptr);
 } // namespace multipass
 
 #endif // MULTIPASS_LXD_REQUEST_H
@@ -16,6 +16,7 @@
  */
 
 #include "lxd_virtual_machine.h"
+#include "lxd_event_monitor.h"
 #include "lxd_request.h"
 
 #include <QJsonArray>
@@ -157,7 +158,8 @@ QJsonObject generate_devices_config(const multipass::VirtualMachineDescription&
 
 mp::LXDVirtualMachine::LXDVirtualMachine(const VirtualMachineDescription& desc, VMStatusMonitor& monitor,
                                          NetworkAccessManager* manager, const QUrl& base_url,
-                                         const QString& bridge_name, const QString& storage_pool)
+                                         const QString& bridge_name, const QString& storage_pool,
+                                         LXDEventMonitor* event_monitor)
     : BaseVirtualMachine{desc.vm_name},
       name{QString::fromStdString(desc.vm_name)},
       username{desc.ssh_username},
@@ -166,7 +168,8 @@ mp::LXDVirtualMachine::LXDVirtualMachine(const VirtualMachineDescription& desc,
       base_url{base_url},
       bridge_name{bridge_name},
       mac_addr{QString::fromStdString(desc.default_mac_address)},
-      storage_pool{storage_pool}
+      storage_pool{storage_pool},
+      event_monitor{event_monitor}
 {
     try
     {
@@ -187,7 +190,7 @@ mp::LXDVirtualMachine::LXDVirtualMachine(const VirtualMachineDescription& desc,
                                       virtual_machine);
 
         // TODO: Need a way to pass in the daemon timeout and make in general for all back ends
-        lxd_wait(manager, base_url, json_reply, 600000);
+        lxd_wait(manager, base_url, json_reply, 600000, event_monitor);
 
         current_state();
     }
@@ -288,7 +291,7 @@ mp::VirtualMachine::State mp::LXDVirtualMachine::current_state()
 {
     try
     {
-        auto present_state = instance_state_for(name, manager, state_url());
+        auto present_state = fetch_state();
 
         if ((state == State::delayed_shutdown || state == State::starting) && present_state == State::running)
             return state;
@@ -394,6 +397,25 @@ const QUrl mp::LXDVirtualMachine::network_leases_url()
     return base_url.toString() + "/networks/" + bridge_name + "/leases";
 }
 
+mp::VirtualMachine::State mp::LXDVirtualMachine::fetch_state()
+{
+    auto generation = event_monitor ? event_monitor->generation() : std::nullopt;
+    if (generation)
+    {
+        if (auto known_state = event_monitor->state_for(name))
+            return *known_state;
+    }
+
+    auto present_state = instance_state_for(name, manager, state_url());
+
+    // Transitional states are left out, since LXD doesn't announce when they end
+    if (generation && (present_state == State::running || present_state == State::stopped ||
+                       present_state == State::suspended))
+        event_monitor->insert_state(name, present_state, *generation);
+
+    return present_state;
+}
+
 void mp::LXDVirtualMachine::request_state(const QString& new_state)
 {
     const QJsonObject state_json{{"action", new_state}};
@@ -402,7 +424,7 @@ void mp::LXDVirtualMachine::request_state(const QString& new_state)
 
     try
     {
-        lxd_wait(manager, base_url, state_task, 60000);
+        lxd_wait(manager, base_url, state_task, 60000, event_monitor);
     }
     catch (const LXDNotFoundException&)
     {
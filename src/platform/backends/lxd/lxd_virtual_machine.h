@@ -26,6 +26,7 @@
 
 namespace multipass
 {
+class LXDEventMonitor;
 class NetworkAccessManager;
 class VirtualMachineDescription;
 class VMStatusMonitor;
@@ -34,7 +35,8 @@ class LXDVirtualMachine final : public BaseVirtualMachine
 {
 public:
     LXDVirtualMachine(const VirtualMachineDescription& desc, VMStatusMonitor& monitor, NetworkAccessManager* manager,
-                      const QUrl& base_url, const QString& bridge_name, const QString& storage_pool);
+                      const QUrl& base_url, const QString& bridge_name, const QString& storage_pool,
+                      LXDEventMonitor* event_monitor = nullptr);
     ~LXDVirtualMachine() override;
     void stop() override;
     void start() override;
@@ -65,11 +67,13 @@ private:
     const QString bridge_name;
     const QString mac_addr;
     const QString storage_pool;
+    LXDEventMonitor* event_monitor;
 
     const QUrl url();
     const QUrl state_url();
     const QUrl network_leases_url();
     void request_state(const QString& new_state);
+    State fetch_state();
 };
 } // namespace multipass
 #endif // MULTIPASS_LXD_VIRTUAL_MACHINE_H
@@ -88,7 +88,8 @@ mp::LXDVirtualMachineFactory::LXDVirtualMachineFactory(NetworkAccessManager::UPt
                                                        const QUrl& base_url)
     : manager{std::move(manager)},
       data_dir{mp::utils::make_dir(data_dir, get_backend_directory_name())},
-      base_url{base_url}
+      base_url{base_url},
+      event_monitor{std::make_unique<LXDEventMonitor>(base_url)}
 {
 }
 
@@ -101,7 +102,7 @@ mp::VirtualMachine::UPtr mp::LXDVirtualMachineFactory::create_virtual_machine(co
                                                                               VMStatusMonitor& monitor)
 {
     return std::make_unique<mp::LXDVirtualMachine>(desc, monitor, manager.get(), base_url, multipass_bridge_name,
-                                                   storage_pool);
+                                                   storage_pool, event_monitor.get());
 }
 
 void mp::LXDVirtualMachineFactory::remove_resources_for(const std::string& name)
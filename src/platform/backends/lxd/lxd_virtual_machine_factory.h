@@ -18,6 +18,7 @@
 #ifndef MULTIPASS_LXD_VIRTUAL_MACHINE_FACTORY_H
 #define MULTIPASS_LXD_VIRTUAL_MACHINE_FACTORY_H
 
+#include "lxd_event_monitor.h"
 #include "lxd_request.h"
 
 #include <multipass/network_access_manager.h>
@@ -25,6 +26,8 @@
 
 #include <QUrl>
 
+#include <memory>
+
 namespace multipass
 {
 class LXDVirtualMachineFactory : public BaseVirtualMachineFactory
@@ -61,6 +64,7 @@ private:
     const Path data_dir;
     const QUrl base_url;
     QString storage_pool;
+    std::unique_ptr<LXDEventMonitor> event_monitor;
 };
 } // namespace multipass
 
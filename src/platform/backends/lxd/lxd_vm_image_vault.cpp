@@ -29,13 +29,14 @@
 #include <multipass/utils.h>
 #include <multipass/vm_image.h>
 #include <multipass/vm_image_host.h>
+#include <multipass/xz_image_decoder.h>
 
-#include <shared/linux/process_factory.h>
 #include <shared/qemu_img_utils/qemu_img_utils.h>
 
 #include <yaml-cpp/yaml.h>
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
@@ -46,6 +47,7 @@
 #include <QTemporaryDir>
 
 #include <chrono>
+#include <optional>
 #include <thread>
 
 namespace mp = multipass;
@@ -75,29 +77,83 @@ auto parse_percent_as_int(const QString& progress_string)
     return -1;
 }
 
-QString post_process_downloaded_image(const QString& image_path, const mp::ProgressMonitor& monitor)
+QString convert_to_qcow(const QString& image_path)
 {
-    QString new_image_path{image_path};
+    const auto qcow_image_path = mp::backend::convert_to_qcow_if_necessary(image_path);
 
-    if (image_path.endsWith(".xz"))
+    if (qcow_image_path != image_path)
     {
-        new_image_path = mp::vault::extract_image(image_path, monitor, true);
+        mp::vault::delete_file(image_path);
     }
 
-    QString original_image_path{new_image_path};
-    new_image_path = mp::backend::convert_to_qcow_if_necessary(new_image_path);
+    return qcow_image_path;
+}
+
+bool is_qcow2(const QString& image_path)
+{
+    QFile image_file{image_path};
 
-    if (original_image_path != new_image_path)
+    return image_file.open(QIODevice::ReadOnly) && image_file.read(4) == QByteArray("QFI\xfb", 4);
+}
+
+// Only writes into the import directory when the image cannot be handed to LXD as it is
+QString prepare_local_image(const QString& source_path, const QTemporaryDir& lxd_import_dir,
+                            const mp::ProgressMonitor& monitor)
+{
+    if (source_path.endsWith(".xz"))
     {
-        mp::vault::delete_file(original_image_path);
+        auto decoded_name = QFileInfo{source_path}.fileName();
+        decoded_name.chop(3);
+
+        const auto decoded_path = lxd_import_dir.filePath(decoded_name);
+        mp::XzImageDecoder{source_path}.decode_to(decoded_path, monitor);
+
+        return convert_to_qcow(decoded_path);
     }
 
-    return new_image_path;
+    if (is_qcow2(source_path))
+        return source_path;
+
+    return convert_to_qcow(mp::vault::copy(source_path, lxd_import_dir.path()));
 }
 
-QString create_metadata_tarball(const mp::VMImageInfo& info, const QTemporaryDir& lxd_import_dir)
+// Writes a ustar archive holding a single file, which is all LXD needs for the image metadata
+QByteArray make_tarball(const QString& file_name, const QByteArray& contents)
+{
+    constexpr auto block_size = 512;
+    QByteArray header(block_size, '\0');
+
+    auto set_field = [&header](int offset, const QByteArray& value) { header.replace(offset, value.size(), value); };
+    auto octal = [](qint64 value, int field_size) {
+        return QByteArray::number(value, 8).rightJustified(field_size - 1, '0');
+    };
+
+    set_field(0, file_name.toUtf8().left(99));                     // name
+    set_field(100, octal(0644, 8));                                // mode
+    set_field(108, octal(0, 8));                                   // uid
+    set_field(116, octal(0, 8));                                   // gid
+    set_field(124, octal(contents.size(), 12));                    // size
+    set_field(136, octal(QDateTime::currentSecsSinceEpoch(), 12)); // mtime
+    set_field(148, QByteArray(8, ' '));                            // checksum, blank while summing
+    set_field(156, "0");                                           // type: regular file
+    set_field(257, "ustar");                                       // magic
+    set_field(263, "00");                                          // version
+
+    qint64 checksum{0};
+    for (const auto c : header)
+        checksum += static_cast<unsigned char>(c);
+
+    set_field(148, octal(checksum, 7) + '\0');
+
+    QByteArray tarball{header + contents};
+    tarball.append(QByteArray((block_size - contents.size() % block_size) % block_size, '\0'));
+    tarball.append(QByteArray(2 * block_size, '\0')); // end of archive
+
+    return tarball;
+}
+
+QByteArray create_metadata_tarball(const mp::VMImageInfo& info)
 {
-    QFile metadata_yaml_file{lxd_import_dir.filePath("metadata.yaml")};
     YAML::Node metadata_node;
 
     metadata_node["architecture"] = host_to_lxd_arch.value(QSysInfo::currentCpuArchitecture()).toStdString();
@@ -111,24 +167,7 @@ QString create_metadata_tarball(const mp::VMImageInfo& info, const QTemporaryDir
     YAML::Emitter emitter;
     emitter << metadata_node << YAML::Newline;
 
-    metadata_yaml_file.open(QIODevice::WriteOnly);
-    metadata_yaml_file.write(emitter.c_str());
-    metadata_yaml_file.close();
-
-    const auto metadata_tarball_path = lxd_import_dir.filePath("metadata.tar");
-    auto process = MP_PROCFACTORY.create_process(
-        "tar", QStringList() << "-cf" << metadata_tarball_path << "-C" << lxd_import_dir.path()
-                             << QFileInfo(metadata_yaml_file.fileName()).fileName());
-
-    auto exit_state = process->execute();
-
-    if (!exit_state.completed_successfully())
-    {
-        throw std::runtime_error(
-            fmt::format("Failed to create LXD image import metadata tarball: {}", process->read_all_standard_error()));
-    }
-
-    return metadata_tarball_path;
+    return make_tarball("metadata.yaml", QByteArray{emitter.c_str()});
 }
 
 std::vector<std::string> copy_aliases(const QStringList& aliases)
@@ -249,6 +288,7 @@ mp::VMImage mp::LXDVMImageVault::fetch_image(const FetchType& fetch_type, const
                 throw std::runtime_error(fmt::format("Custom image `{}` does not exist.", image_url.path()));
 
             source_image.image_path = image_url.path();
+            monitor(LaunchProgress::VERIFY, -1);
             id = mp::vault::compute_image_hash(source_image.image_path);
             last_modified = QDateTime::currentDateTime();
         }
@@ -276,28 +316,24 @@ mp::VMImage mp::LXDVMImageVault::fetch_image(const FetchType& fetch_type, const
         }
         else if (!info.image_location.isEmpty())
         {
-            QString image_path;
             QTemporaryDir lxd_import_dir{template_path};
+            QString image_path;
 
             if (query.query_type != Query::Type::LocalFile)
             {
                 // TODO: Need to make this async like in DefaultVMImageVault
-                image_path = lxd_import_dir.filePath(mp::vault::filename_for(info.image_location));
-
-                url_download_image(info, image_path, monitor);
+                image_path = url_download_image(
+                    info, lxd_import_dir.filePath(mp::vault::filename_for(info.image_location)), monitor);
+                image_path = convert_to_qcow(image_path);
             }
             else
             {
-                image_path = mp::vault::copy(source_image.image_path, lxd_import_dir.path());
+                image_path = prepare_local_image(source_image.image_path, lxd_import_dir, monitor);
             }
 
-            image_path = post_process_downloaded_image(image_path, monitor);
-
             monitor(LaunchProgress::WAITING, -1);
 
-            auto metadata_tarball_path = create_metadata_tarball(info, lxd_import_dir);
-
-            source_image.id = lxd_import_metadata_and_image(metadata_tarball_path, image_path);
+            source_image.id = lxd_import_metadata_and_image(create_metadata_tarball(info), image_path);
         }
         else
         {
@@ -487,18 +523,51 @@ void mp::LXDVMImageVault::lxd_download_image(const VMImageInfo& info, const Quer
     poll_download_operation(json_reply, monitor);
 }
 
-void mp::LXDVMImageVault::url_download_image(const VMImageInfo& info, const QString& image_path,
-                                             const ProgressMonitor& monitor)
+// Verifies and, if need be, decompresses the image as it comes in, so that only the image LXD imports is written out
+QString mp::LXDVMImageVault::url_download_image(const VMImageInfo& info, const QString& image_path,
+                                                const ProgressMonitor& monitor)
 {
-    mp::vault::DeleteOnException image_file{image_path};
-
-    url_downloader->download_to(info.image_location, image_path, info.size, LaunchProgress::IMAGE, monitor);
+    QString final_image_path{image_path};
+    const auto compressed = final_image_path.endsWith(".xz");
+    if (compressed)
+        final_image_path.chop(3);
+
+    mp::vault::DeleteOnException image_file{final_image_path};
+    QCryptographicHash hash{QCryptographicHash::Sha256};
+    std::optional<mp::XzStreamDecoder> decoder;
+    QFile file{final_image_path};
+
+    if (compressed)
+        decoder.emplace(final_image_path);
+    else if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw std::runtime_error(fmt::format("failed to open {} for writing", final_image_path));
+
+    url_downloader->stream_to(
+        info.image_location,
+        [&](const QByteArray& data) {
+            if (info.verify)
+                hash.addData(data);
+
+            if (decoder)
+                decoder->decode(data.constData(), data.size());
+            else if (file.write(data) != data.size())
+                throw std::runtime_error(fmt::format("error writing image: {}", file.errorString()));
+        },
+        info.size, LaunchProgress::IMAGE, monitor);
+
+    if (decoder)
+        decoder->finish();
+    else
+        file.close();
 
     if (info.verify)
     {
         monitor(LaunchProgress::VERIFY, -1);
-        mp::vault::verify_image_download(image_path, info.id);
+        if (hash.result().toHex() != info.id)
+            throw std::runtime_error("Downloaded image hash does not match");
     }
+
+    return final_image_path;
 }
 
 void mp::LXDVMImageVault::poll_download_operation(const QJsonObject& json_reply, const ProgressMonitor& monitor)
@@ -551,20 +620,17 @@ void mp::LXDVMImageVault::poll_download_operation(const QJsonObject& json_reply,
     }
 }
 
-std::string mp::LXDVMImageVault::lxd_import_metadata_and_image(const QString& metadata_path, const QString& image_path)
+std::string mp::LXDVMImageVault::lxd_import_metadata_and_image(const QByteArray& metadata_tarball,
+                                                              const QString& image_path)
 {
     QHttpMultiPart lxd_multipart{QHttpMultiPart::FormDataType};
-    QFileInfo metadata_info{metadata_path}, image_info{image_path};
+    QFileInfo image_info{image_path};
 
     QHttpPart metadata_part;
     metadata_part.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
-    metadata_part.setHeader(
-        QNetworkRequest::ContentDispositionHeader,
-        QVariant(QString("form-data; name=\"metadata\"; filename=\"%1\"").arg(metadata_info.fileName())));
-    QFile* metadata_file = new QFile(metadata_path);
-    metadata_file->open(QIODevice::ReadOnly);
-    metadata_part.setBodyDevice(metadata_file);
-    metadata_file->setParent(&lxd_multipart);
+    metadata_part.setHeader(QNetworkRequest::ContentDispositionHeader,
+                            QVariant("form-data; name=\"metadata\"; filename=\"metadata.tar\""));
+    metadata_part.setBody(metadata_tarball);
 
     QHttpPart image_part;
     image_part.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
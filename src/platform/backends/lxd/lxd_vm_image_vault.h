@@ -51,9 +51,9 @@ public:
 private:
     void lxd_download_image(const VMImageInfo& info, const Query& query, const ProgressMonitor& monitor,
                             const QString& last_used = QString());
-    void url_download_image(const VMImageInfo& info, const QString& image_path, const ProgressMonitor& monitor);
+    QString url_download_image(const VMImageInfo& info, const QString& image_path, const ProgressMonitor& monitor);
     void poll_download_operation(const QJsonObject& json_reply, const ProgressMonitor& monitor);
-    std::string lxd_import_metadata_and_image(const QString& metadata_path, const QString& image_path);
+    std::string lxd_import_metadata_and_image(const QByteArray& metadata_tarball, const QString& image_path);
     std::string get_lxd_image_hash_for(const QString& id);
     QJsonArray retrieve_image_list();
 
@@ -28,6 +28,8 @@
 
 #include <fstream>
 
+#include <sys/stat.h>
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 
@@ -85,9 +87,34 @@ mp::DNSMasqServer::~DNSMasqServer()
 // FIXME: after moving to core22, go to the old way of just returning the ip address
 std::optional<std::pair<mp::IPAddress, std::string>> mp::DNSMasqServer::get_ip_and_host_for(const std::string& hw_addr)
 {
+    std::lock_guard<decltype(leases_mutex)> lock{leases_mutex};
+    refresh_leases();
+
+    auto it = leases.find(hw_addr);
+    if (it == leases.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+void mp::DNSMasqServer::refresh_leases()
+{
+    const auto path = QDir(data_dir).filePath("dnsmasq.leases").toStdString();
+
+    // Only parse the file again when dnsmasq has written to it since the last time
+    struct stat leases_stat;
+    LeasesStamp stamp{};
+    if (::stat(path.c_str(), &leases_stat) == 0)
+        stamp = {leases_stat.st_ino, leases_stat.st_size, leases_stat.st_mtim.tv_sec, leases_stat.st_mtim.tv_nsec};
+
+    if (leases_stamp && *leases_stamp == stamp)
+        return;
+
+    leases.clear();
+    leases_stamp = stamp;
+
     // DNSMasq leases entries consist of:
     // <lease expiration> <mac addr> <ipv4> <name> * * *
-    const auto path = QDir(data_dir).filePath("dnsmasq.leases").toStdString();
     const std::string delimiter{" "};
     const int hw_addr_idx{1};
     const int ipv4_idx{2};
@@ -97,10 +124,18 @@ std::optional<std::pair<mp::IPAddress, std::string>> mp::DNSMasqServer::get_ip_a
     while (getline(leases_file, line))
     {
         const auto fields = mp::utils::split(line, delimiter);
-        if (fields.size() > 3 && fields[hw_addr_idx] == hw_addr)
-            return {{fields[ipv4_idx], fields[host_name_idx]}};
+        if (fields.size() > 3 && leases.find(fields[hw_addr_idx]) == leases.end())
+        {
+            try
+            {
+                leases.try_emplace(fields[hw_addr_idx], mp::IPAddress{fields[ipv4_idx]}, fields[host_name_idx]);
+            }
+            catch (const std::invalid_argument&)
+            {
+                continue; // not an IPv4 lease
+            }
+        }
     }
-    return std::nullopt;
 }
 
 void mp::DNSMasqServer::release_mac(const std::string& hw_addr)
@@ -26,8 +26,12 @@
 #include <QTemporaryFile>
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
 
 namespace multipass
 {
@@ -49,7 +53,22 @@ protected:
     DNSMasqServer() = default; // For testing
 
 private:
+    struct LeasesStamp
+    {
+        ino_t inode;
+        off_t size;
+        time_t mtime_sec;
+        long mtime_nsec;
+
+        bool operator==(const LeasesStamp& other) const
+        {
+            return inode == other.inode && size == other.size && mtime_sec == other.mtime_sec &&
+                   mtime_nsec == other.mtime_nsec;
+        }
+    };
+
     void start_dnsmasq();
+    void refresh_leases();
 
     const QString data_dir;
     const QString bridge_name;
@@ -57,6 +76,9 @@ private:
     std::unique_ptr<Process> dnsmasq_cmd;
     QMetaObject::Connection finish_connection;
     QTemporaryFile conf_file;
+    std::mutex leases_mutex;
+    std::unordered_map<std::string, std::pair<IPAddress, std::string>> leases;
+    std::optional<LeasesStamp> leases_stamp;
 };
 
 #define MP_DNSMASQ_SERVER_FACTORY multipass::DNSMasqServerFactory::instance()
@@ -19,6 +19,7 @@
 
 #include <multipass/exceptions/ssh_exception.h>
 #include <multipass/logging/log.h>
+#include <multipass/ssh/ssh_session_pool.h>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
@@ -26,7 +27,7 @@ namespace mpl = multipass::logging;
 namespace multipass
 {
 
-std::vector<std::string> BaseVirtualMachine::get_all_ipv4(const SSHKeyProvider& key_provider)
+std::vector<std::string> BaseVirtualMachine::get_all_ipv4(SSHSessionPool& session_pool)
 {
     std::vector<std::string> all_ipv4;
 
@@ -36,10 +37,10 @@ std::vector<std::string> BaseVirtualMachine::get_all_ipv4(const SSHKeyProvider&
 
         try
         {
-            SSHSession session{ssh_hostname(), ssh_port(), ssh_username(), key_provider};
-
             ip_a_output = QString::fromStdString(
-                mpu::run_in_ssh_session(session, "ip -brief -family inet address show scope global"));
+                session_pool.run(ssh_hostname(), ssh_port(), ssh_username(), [](SSHSession& session) {
+                    return mpu::run_in_ssh_session(session, "ip -brief -family inet address show scope global");
+                }));
 
             QRegularExpression ipv4_re{QStringLiteral("([\\d\\.]+)\\/\\d+\\s*(metric \\d+)?\\s*$"),
                                        QRegularExpression::MultilineOption};
@@ -40,7 +40,7 @@ public:
     BaseVirtualMachine(VirtualMachine::State state, const std::string& vm_name) : VirtualMachine(state, vm_name){};
     BaseVirtualMachine(const std::string& vm_name) : VirtualMachine(vm_name){};
 
-    std::vector<std::string> get_all_ipv4(const SSHKeyProvider& key_provider) override;
+    std::vector<std::string> get_all_ipv4(SSHSessionPool& session_pool) override;
     void add_vm_mount(const std::string& target_path, const VMMount& vm_mount) override
     {
     }
@@ -25,6 +25,7 @@
 #include <QString>
 #include <QTimer>
 
+#include <mutex>
 #include <optional>
 
 namespace multipass
@@ -59,6 +60,7 @@ private slots:
 
 private:
     const QString current_version, update_url;
+    mutable std::mutex new_release_mutex;
     std::optional<NewReleaseInfo> new_release;
     QTimer refresh_timer;
 
@@ -17,12 +17,15 @@
 
 #include <multipass/simple_streams_manifest.h>
 
+#include <QDataStream>
 #include <QFileInfo>
 #include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QSysInfo>
 
+#include <algorithm>
+
 #include <multipass/constants.h>
 #include <multipass/exceptions/manifest_exceptions.h>
 #include <multipass/settings/settings.h>
@@ -61,6 +64,61 @@ QString latest_version_in(const QJsonObject& versions)
     return max_version;
 }
 
+// Bump whenever the layout written by toBinary changes
+constexpr quint32 binary_format_version = 1;
+constexpr quint32 binary_magic = 0x4d50534d; // "MPSM"
+constexpr auto binary_stream_version = QDataStream::Qt_5_6;
+
+// Products are picked differently depending on architecture and driver, so a binary manifest only applies to the
+// combination it was parsed for
+QString binary_flavour()
+{
+    return arch_to_manifest.value(QSysInfo::currentCpuArchitecture()) + '/' + MP_SETTINGS.get(mp::driver_key);
+}
+
+// Equal strings are stored once and come back sharing their data
+struct StringTable
+{
+    quint32 index_of(const QString& string)
+    {
+        auto it = indices.constFind(string);
+        if (it == indices.constEnd())
+        {
+            it = indices.insert(string, static_cast<quint32>(strings.size()));
+            strings.append(string);
+        }
+
+        return it.value();
+    }
+
+    QHash<QString, quint32> indices;
+    QStringList strings;
+};
+
+std::unique_ptr<mp::SimpleStreamsManifest> make_manifest(const QString& updated, std::vector<mp::VMImageInfo> products)
+{
+    QHash<QString, const mp::VMImageInfo*> map;
+    std::vector<const mp::VMImageInfo*> by_id;
+    by_id.reserve(products.size());
+
+    for (const auto& product : products)
+    {
+        map[product.id] = &product;
+        for (const auto& alias : product.aliases)
+        {
+            map[alias] = &product;
+        }
+
+        by_id.push_back(&product);
+    }
+
+    // Stable, so that products sharing an id keep their manifest order
+    std::stable_sort(by_id.begin(), by_id.end(), [](const auto* a, const auto* b) { return a->id < b->id; });
+
+    return std::unique_ptr<mp::SimpleStreamsManifest>(
+        new mp::SimpleStreamsManifest{updated, std::move(products), std::move(map), std::move(by_id)});
+}
+
 QString derive_unpacked_file_path_prefix_from(const QString& image_location, const QString& image_suffix)
 {
     QFileInfo info{image_location};
@@ -176,17 +234,95 @@ mp::SimpleStreamsManifest::fromJson(const QByteArray& json_from_official,
     if (products.empty())
         throw mp::EmptyManifestException("No supported products found.");
 
-    QMap<QString, const VMImageInfo*> map;
+    return make_manifest(updated, std::move(products));
+}
 
+QByteArray mp::SimpleStreamsManifest::toBinary() const
+{
+    StringTable strings;
+    QByteArray body;
+    QDataStream body_stream{&body, QIODevice::WriteOnly};
+    body_stream.setVersion(binary_stream_version);
+
+    body_stream << static_cast<quint32>(products.size());
     for (const auto& product : products)
     {
-        map[product.id] = &product;
+        body_stream << static_cast<quint32>(product.aliases.size());
         for (const auto& alias : product.aliases)
-        {
-            map[alias] = &product;
-        }
+            body_stream << strings.index_of(alias);
+
+        for (const auto* field : {&product.os, &product.release, &product.release_title, &product.image_location,
+                                  &product.kernel_location, &product.initrd_location, &product.id,
+                                  &product.stream_location, &product.version})
+            body_stream << strings.index_of(*field);
+
+        body_stream << product.supported << static_cast<qint64>(product.size) << product.verify;
+    }
+
+    QByteArray data;
+    QDataStream stream{&data, QIODevice::WriteOnly};
+    stream.setVersion(binary_stream_version);
+    stream << binary_magic << binary_format_version << binary_flavour() << updated_at << strings.strings << body;
+
+    return data;
+}
+
+std::unique_ptr<mp::SimpleStreamsManifest> mp::SimpleStreamsManifest::fromBinary(const QByteArray& data)
+{
+    QDataStream stream{data};
+    stream.setVersion(binary_stream_version);
+
+    quint32 magic, format_version;
+    stream >> magic >> format_version;
+    if (stream.status() != QDataStream::Ok || magic != binary_magic || format_version != binary_format_version)
+        throw mp::GenericManifestException("Unknown cached manifest format");
+
+    QString flavour, updated;
+    QStringList strings;
+    QByteArray body;
+    stream >> flavour >> updated >> strings >> body;
+    if (stream.status() != QDataStream::Ok || flavour != binary_flavour())
+        throw mp::GenericManifestException("Cached manifest does not apply");
+
+    QDataStream body_stream{body};
+    body_stream.setVersion(binary_stream_version);
+
+    auto read_string = [&body_stream, &strings] {
+        quint32 index;
+        body_stream >> index;
+        if (body_stream.status() != QDataStream::Ok || index >= static_cast<quint32>(strings.size()))
+            throw mp::GenericManifestException("Corrupt cached manifest");
+
+        return strings[index];
+    };
+
+    quint32 product_count;
+    body_stream >> product_count;
+
+    std::vector<VMImageInfo> products;
+    for (quint32 i = 0; i < product_count && body_stream.status() == QDataStream::Ok; ++i)
+    {
+        VMImageInfo product;
+
+        quint32 alias_count;
+        body_stream >> alias_count;
+        for (quint32 j = 0; j < alias_count && body_stream.status() == QDataStream::Ok; ++j)
+            product.aliases.append(read_string());
+
+        for (auto* field : {&product.os, &product.release, &product.release_title, &product.image_location,
+                            &product.kernel_location, &product.initrd_location, &product.id, &product.stream_location,
+                            &product.version})
+            *field = read_string();
+
+        qint64 size;
+        body_stream >> product.supported >> size >> product.verify;
+        product.size = size;
+
+        products.push_back(std::move(product));
     }
 
-    return std::unique_ptr<SimpleStreamsManifest>(
-        new SimpleStreamsManifest{updated, std::move(products), std::move(map)});
+    if (body_stream.status() != QDataStream::Ok || products.empty())
+        throw mp::GenericManifestException("Corrupt cached manifest");
+
+    return make_manifest(updated, std::move(products));
 }
@@ -24,13 +24,50 @@
 #include <multipass/ssh/throw_on_error.h>
 #include <multipass/utils.h>
 
+#include <QCryptographicHash>
+
+#include <scope_guard.hpp>
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
 #include <fcntl.h>
 
 constexpr int file_mode = 0664;
 constexpr auto max_transfer = 65536u;
+// Files at least this large are pushed in parts over separate connections, when there are any
+constexpr auto min_parallel_push_size = 64ull * 1024 * 1024;
+// Syncing compares files in blocks of this size, and only sends the ones whose digests differ
+constexpr auto sync_block_size = 2 * max_transfer;
+// Prints the SHA-256 of each block of a file in the instance. Ubuntu images ship python3 for cloud-init; should it be
+// missing, files are sent whole
+constexpr auto block_digests_script = "import hashlib,sys\n"
+                                      "f = open(sys.argv[1], \"rb\")\n"
+                                      "for b in iter(lambda: f.read(int(sys.argv[2])), b\"\"):\n"
+                                      "    print(hashlib.sha256(b).hexdigest())";
 const std::string stream_file_name{"stream_output.dat"};
 const char* log_category = "sftp";
+// The shell's exit code for a command it cannot find
+constexpr auto command_not_found = 127;
+
+namespace
+{
+// The filesystem clock has no portable epoch, so go through what both clocks say the time is now
+std::int64_t to_secs_since_epoch(std::filesystem::file_time_type file_time)
+{
+    const auto system_time = file_time - std::filesystem::file_time_type::clock::now() +
+                             std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::seconds>(system_time.time_since_epoch()).count();
+}
+} // namespace
 
 namespace multipass
 {
@@ -45,13 +82,26 @@ SFTPSessionUPtr make_sftp_session(ssh_session session)
     return sftp;
 }
 
-SFTPClient::SFTPClient(const std::string& host, int port, const std::string& username, const std::string& priv_key_blob)
-    : SFTPClient{std::make_unique<SSHSession>(host, port, username, SSHClientKeyProvider(priv_key_blob))}
+SFTPClient::SFTPClient(const std::string& host, int port, const std::string& username, const std::string& priv_key_blob,
+                       const SFTPTransferOptions& options)
+    : SFTPClient{std::make_unique<SSHSession>(host, port, username, SSHClientKeyProvider(priv_key_blob)),
+                 [host, port, username, priv_key_blob] {
+                     return std::make_unique<SSHSession>(host, port, username, SSHClientKeyProvider(priv_key_blob));
+                 },
+                 options}
+{
+}
+
+SFTPClient::SFTPClient(SSHSessionUPtr ssh_session, const SFTPTransferOptions& options)
+    : SFTPClient{std::move(ssh_session), nullptr, options}
 {
 }
 
-SFTPClient::SFTPClient(SSHSessionUPtr ssh_session)
-    : ssh_session{std::move(ssh_session)}, sftp{make_sftp_session(*this->ssh_session)}
+SFTPClient::SFTPClient(SSHSessionUPtr ssh_session, SessionFactory make_session, const SFTPTransferOptions& options)
+    : ssh_session{std::move(ssh_session)},
+      sftp{make_sftp_session(*this->ssh_session)},
+      make_session{std::move(make_session)},
+      options{options}
 {
     SSH::throw_on_error(sftp, *this->ssh_session, "[sftp] init failed", sftp_init);
 }
@@ -76,14 +126,17 @@ try
 
         auto full_target_path = MP_SFTPUTILS.get_remote_dir_target(sftp.get(), source, target_path,
                                                                    flags.testFlag(SFTPClient::Flag::MakeParent));
-        return push_dir(source, full_target_path);
+        return push_dir(source, full_target_path, flags);
     }
     else if (err)
         throw SFTPError{"cannot access {}: {}", source_path, err.message()};
 
     auto full_target_path = MP_SFTPUTILS.get_remote_file_target(sftp.get(), source, target_path,
                                                                 flags.testFlag(SFTPClient::Flag::MakeParent));
-    push_file(source, full_target_path);
+    if (flags.testFlag(Flag::Sync))
+        sync_file(source, full_target_path);
+    else
+        push_file(source, full_target_path);
     return true;
 }
 catch (const SFTPError& e)
@@ -125,7 +178,10 @@ void SFTPClient::push_file(const fs::path& source_path, const fs::path& target_p
     if (local_file->fail())
         throw SFTPError{"cannot open local file {}: {}", source_path, strerror(errno)};
 
-    do_push_file(*local_file, target_path);
+    if (make_session && split_large_files && options.streams > 1)
+        push_in_parts(*local_file, source_path, target_path);
+    else
+        do_push_file(*local_file, target_path);
 
     std::error_code _;
     auto status = MP_FILEOPS.status(source_path, _);
@@ -153,7 +209,7 @@ void SFTPClient::pull_file(const fs::path& source_path, const fs::path& target_p
         throw SFTPError{"cannot write to local file {}: {}", target_path, strerror(errno)};
 }
 
-bool SFTPClient::push_dir(const fs::path& source_path, const fs::path& target_path)
+bool SFTPClient::push_dir(const fs::path& source_path, const fs::path& target_path, const Flags flags)
 {
     auto success = true;
     std::error_code err;
@@ -164,6 +220,8 @@ bool SFTPClient::push_dir(const fs::path& source_path, const fs::path& target_pa
 
     std::vector<std::pair<fs::path, fs::perms>> subdirectory_perms{
         {target_path, MP_FILEOPS.status(source_path, err).permissions()}};
+    FilePairs files;
+    std::vector<std::string> pushed_paths;
 
     while (local_iter->hasNext())
     {
@@ -174,13 +232,14 @@ bool SFTPClient::push_dir(const fs::path& source_path, const fs::path& target_pa
                 entry.path().u8string().replace(0, source_path.u8string().size(), target_path.u8string());
             std::replace(remote_file_str.begin(), remote_file_str.end(), (char)fs::path::preferred_separator, '/');
             const fs::path remote_file_path{remote_file_str};
+            pushed_paths.push_back(remote_file_str);
 
             const auto status = entry.symlink_status();
             switch (status.type())
             {
             case fs::file_type::regular:
             {
-                push_file(entry.path(), remote_file_path);
+                files.emplace_back(entry.path(), remote_file_path);
                 break;
             }
             case fs::file_type::directory:
@@ -222,6 +281,14 @@ bool SFTPClient::push_dir(const fs::path& source_path, const fs::path& target_pa
         }
     }
 
+    // Only delete once every local entry was seen, lest something that failed to go across gets deleted
+    if (flags.testFlag(Flag::Delete) && success)
+        success = delete_extraneous(target_path, pushed_paths);
+
+    // Directories are all there by now, so files can go in any order
+    const auto transfer = flags.testFlag(Flag::Sync) ? &SFTPClient::sync_file : &SFTPClient::push_file;
+    success = transfer_files(files, transfer) && success;
+
     for (auto it = subdirectory_perms.crbegin(); it != subdirectory_perms.crend(); ++it)
     {
         const auto& [path, perms] = *it;
@@ -246,6 +313,7 @@ bool SFTPClient::pull_dir(const fs::path& source_path, const fs::path& target_pa
 
     std::vector<std::pair<fs::path, mode_t>> subdirectory_perms{
         {target_path, mp_sftp_stat(sftp.get(), source_path.u8string().c_str())->permissions}};
+    FilePairs files;
 
     while (remote_iter->hasNext())
     {
@@ -258,7 +326,7 @@ bool SFTPClient::pull_dir(const fs::path& source_path, const fs::path& target_pa
             {
             case SSH_FILEXFER_TYPE_REGULAR:
             {
-                pull_file(entry->name, local_file_path);
+                files.emplace_back(entry->name, local_file_path);
                 break;
             }
             case SSH_FILEXFER_TYPE_DIRECTORY:
@@ -295,6 +363,8 @@ bool SFTPClient::pull_dir(const fs::path& source_path, const fs::path& target_pa
         }
     }
 
+    success = transfer_files(files, &SFTPClient::pull_file) && success;
+
     for (auto it = subdirectory_perms.crbegin(); it != subdirectory_perms.crend(); ++it)
     {
         const auto& [path, perms] = *it;
@@ -310,6 +380,289 @@ bool SFTPClient::pull_dir(const fs::path& source_path, const fs::path& target_pa
     return success;
 }
 
+// Brings target_path in line with source_path. Files with the same size and modification time are taken to be the
+// same; otherwise only the blocks that differ are sent
+void SFTPClient::sync_file(const fs::path& source_path, const fs::path& target_path)
+{
+    std::error_code err;
+    const auto size = static_cast<uint64_t>(MP_FILEOPS.file_size(source_path, err));
+    if (err)
+        throw SFTPError{"cannot get size of local file {}: {}", source_path, err.message()};
+
+    const auto mtime = static_cast<uint32_t>(to_secs_since_epoch(MP_FILEOPS.last_write_time(source_path, err)));
+    if (err)
+        throw SFTPError{"cannot get modification time of local file {}: {}", source_path, err.message()};
+
+    auto target_attr = mp_sftp_stat(sftp.get(), target_path.u8string().c_str());
+    if (target_attr && target_attr->type == SSH_FILEXFER_TYPE_REGULAR && target_attr->size == size &&
+        target_attr->mtime == mtime)
+        return;
+
+    std::optional<std::vector<std::string>> digests;
+    if (target_attr && target_attr->type == SSH_FILEXFER_TYPE_REGULAR && target_attr->size > 0)
+        digests = remote_block_digests(target_path);
+
+    if (digests)
+    {
+        push_changed_blocks(source_path, target_path, *digests);
+
+        if (target_attr->size > size)
+        {
+            sftp_attributes_struct attr{};
+            attr.flags = SSH_FILEXFER_ATTR_SIZE;
+            attr.size = size;
+            if (sftp_setstat(sftp.get(), target_path.u8string().c_str(), &attr) != SSH_FX_OK)
+                throw SFTPError{"cannot truncate remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+        }
+
+        std::error_code _;
+        auto status = MP_FILEOPS.status(source_path, _);
+        if (sftp_chmod(sftp.get(), target_path.u8string().c_str(), static_cast<mode_t>(status.permissions())) !=
+            SSH_FX_OK)
+            throw SFTPError{"cannot set permissions for remote file {}: {}", target_path,
+                            ssh_get_error(sftp->session)};
+    }
+    else
+        push_file(source_path, target_path);
+
+    // Carry the modification time over, so the file can be recognized as unchanged next time
+    const timeval times[2]{{static_cast<long>(mtime), 0}, {static_cast<long>(mtime), 0}};
+    if (sftp_utimes(sftp.get(), target_path.u8string().c_str(), times) != SSH_FX_OK)
+        throw SFTPError{"cannot set modification time for remote file {}: {}", target_path,
+                        ssh_get_error(sftp->session)};
+}
+
+std::optional<std::vector<std::string>> SFTPClient::remote_block_digests(const fs::path& path)
+try
+{
+    auto process = ssh_session->exec(fmt::format("python3 -c '{}' {} {}", block_digests_script,
+                                                 utils::escape_for_shell(path.u8string()), sync_block_size));
+    auto output = process.read_std_output();
+    if (auto exit_code = process.exit_code(); exit_code != 0)
+    {
+        mpl::log(mpl::Level::debug, log_category,
+                 exit_code == command_not_found
+                     ? fmt::format("python3 is not available in the instance, sending {} whole", path)
+                     : fmt::format("cannot get block digests for {}: exit code {}", path, exit_code));
+        return std::nullopt;
+    }
+
+    auto digests = utils::split(output, "\n");
+    digests.erase(std::remove(digests.begin(), digests.end(), ""), digests.end());
+    return digests;
+}
+catch (const std::exception& e)
+{
+    mpl::log(mpl::Level::debug, log_category, fmt::format("cannot get block digests for {}: {}", path, e.what()));
+    return std::nullopt;
+}
+
+void SFTPClient::push_changed_blocks(const fs::path& source_path, const fs::path& target_path,
+                                     const std::vector<std::string>& remote_digests)
+{
+    auto local_file = MP_FILEOPS.open_read(source_path);
+    if (local_file->fail())
+        throw SFTPError{"cannot open local file {}: {}", source_path, strerror(errno)};
+
+    auto remote_file = mp_sftp_open(sftp.get(), target_path.u8string().c_str(), O_WRONLY, file_mode);
+    if (!remote_file)
+        throw SFTPError{"cannot open remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+
+    std::vector<char> buffer(sync_block_size);
+    for (uint64_t block = 0; local_file->read(buffer.data(), buffer.size()).gcount() > 0; ++block)
+    {
+        const auto r = local_file->gcount();
+        if (block < remote_digests.size() &&
+            QCryptographicHash::hash(QByteArray::fromRawData(buffer.data(), r), QCryptographicHash::Sha256)
+                    .toHex()
+                    .toStdString() == remote_digests[block])
+            continue;
+
+        if (sftp_seek64(remote_file.get(), block * sync_block_size) < 0)
+            throw SFTPError{"cannot seek in remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+
+        for (std::streamsize written = 0; written < r; written += max_transfer)
+        {
+            const auto length = std::min<std::streamsize>(r - written, max_transfer);
+            if (sftp_write(remote_file.get(), buffer.data() + written, length) < 0)
+                throw SFTPError{"cannot write to remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+        }
+    }
+
+    if (local_file->fail() && !local_file->eof())
+        throw SFTPError{"cannot read from local file {}: {}", source_path, strerror(errno)};
+}
+
+// Deletes whatever is under target_path but not among kept_paths
+bool SFTPClient::delete_extraneous(const fs::path& target_path, const std::vector<std::string>& kept_paths)
+{
+    auto success = true;
+    const std::unordered_set<std::string> kept{kept_paths.begin(), kept_paths.end()};
+    std::vector<std::pair<std::string, bool>> extraneous;
+
+    auto remote_iter = MP_SFTPUTILS.make_SFTPDirIterator(sftp.get(), target_path);
+    while (remote_iter->hasNext())
+    {
+        const auto entry = remote_iter->next();
+        if (!kept.count(entry->name))
+            extraneous.emplace_back(entry->name, entry->type == SSH_FILEXFER_TYPE_DIRECTORY);
+    }
+
+    // Directories are listed before what they contain, so going backwards empties them before they are removed
+    for (auto it = extraneous.crbegin(); it != extraneous.crend(); ++it)
+    {
+        const auto& [path, is_dir] = *it;
+        if ((is_dir ? sftp_rmdir(sftp.get(), path.c_str()) : sftp_unlink(sftp.get(), path.c_str())) != SSH_FX_OK)
+        {
+            mpl::log(mpl::Level::error, log_category,
+                     fmt::format("cannot delete remote {} '{}': {}", is_dir ? "directory" : "file", path,
+                                 ssh_get_error(sftp->session)));
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool SFTPClient::transfer_files(const FilePairs& files, FileTransfer transfer)
+{
+    // With several files every connection gets some, so splitting one into parts would open connections beyond the
+    // number of streams
+    const auto split = std::exchange(split_large_files, split_large_files && files.size() < 2);
+    auto restore_split = sg::make_scope_guard([this, split]() noexcept { split_large_files = split; });
+
+    return in_parallel(files.size(), [&files, transfer](SFTPClient& client, std::size_t i) {
+        const auto& [source, target] = files[i];
+        (client.*transfer)(source, target);
+    });
+}
+
+// Runs tasks 0 to num_tasks - 1 on this client and, when possible, on clients of their own on separate connections.
+// Failed tasks are logged. Tasks are handed out one at a time, so those a connection can't take go to the others.
+// Anything other than an SFTPError stops the handing out, and is rethrown once every connection is done
+bool SFTPClient::in_parallel(std::size_t num_tasks, const std::function<void(SFTPClient&, std::size_t)>& task)
+{
+    std::atomic_bool success{true};
+    std::atomic_size_t next_task{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    const auto run_tasks = [&](SFTPClient& client) {
+        for (auto i = next_task++; i < num_tasks; i = next_task++)
+        {
+            try
+            {
+                task(client, i);
+            }
+            catch (const SFTPError& e)
+            {
+                mpl::log(mpl::Level::error, log_category, e.what());
+                success = false;
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{error_mutex};
+                if (!error)
+                    error = std::current_exception();
+
+                success = false;
+                next_task = num_tasks;
+            }
+        }
+    };
+
+    {
+        std::vector<std::thread> extra_streams;
+        auto join_streams = sg::make_scope_guard([&extra_streams]() noexcept {
+            for (auto& stream : extra_streams)
+                if (stream.joinable())
+                    stream.join();
+        });
+
+        const auto num_extra =
+            make_session && num_tasks > 1 ? std::min<std::size_t>(options.streams, num_tasks) - 1 : 0;
+        for (std::size_t i = 0; i < num_extra; ++i)
+        {
+            extra_streams.emplace_back([this, &run_tasks] {
+                std::unique_ptr<SFTPClient> client;
+                try
+                {
+                    client.reset(new SFTPClient{make_session(), nullptr, {options.window, 1}});
+                }
+                catch (const std::exception& e)
+                {
+                    mpl::log(mpl::Level::debug, log_category,
+                             fmt::format("cannot open extra connection: {}", e.what()));
+                    return;
+                }
+
+                run_tasks(*client);
+            });
+        }
+
+        run_tasks(*this);
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+
+    return success;
+}
+
+void SFTPClient::push_in_parts(std::istream& source, const fs::path& source_path, const fs::path& target_path)
+{
+    source.seekg(0, std::ios::end);
+    const auto size = static_cast<uint64_t>(source.tellg());
+    source.seekg(0);
+
+    if (source.fail() || size < min_parallel_push_size)
+    {
+        source.clear();
+        return do_push_file(source, target_path);
+    }
+
+    // The file is created and truncated up front, so the parts can each be written wherever they belong
+    if (!mp_sftp_open(sftp.get(), target_path.u8string().c_str(), O_WRONLY | O_CREAT | O_TRUNC, file_mode))
+        throw SFTPError{"cannot open remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+
+    const auto num_parts = std::min<uint64_t>(options.streams, size / max_transfer);
+    const auto part_size = (size / num_parts + max_transfer - 1) / max_transfer * max_transfer;
+
+    const auto pushed = in_parallel(num_parts, [&](SFTPClient& client, std::size_t i) {
+        const auto offset = i * part_size;
+        if (offset < size)
+            client.push_part(source_path, target_path, offset, std::min(part_size, size - offset));
+    });
+
+    if (!pushed)
+        throw SFTPError{"cannot push {} to {}", source_path, target_path};
+}
+
+void SFTPClient::push_part(const fs::path& source_path, const fs::path& target_path, uint64_t offset,
+                           uint64_t length)
+{
+    auto local_file = MP_FILEOPS.open_read(source_path);
+    if (local_file->fail() || !local_file->seekg(offset))
+        throw SFTPError{"cannot open local file {}: {}", source_path, strerror(errno)};
+
+    auto remote_file = mp_sftp_open(sftp.get(), target_path.u8string().c_str(), O_WRONLY, file_mode);
+    if (!remote_file || sftp_seek64(remote_file.get(), offset) < 0)
+        throw SFTPError{"cannot open remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+
+    std::array<char, max_transfer> buffer{};
+    while (length > 0)
+    {
+        const auto r = local_file->read(buffer.data(), std::min<uint64_t>(length, buffer.size())).gcount();
+        if (r <= 0)
+            throw SFTPError{"cannot read from local file {}: {}", source_path, strerror(errno)};
+
+        if (sftp_write(remote_file.get(), buffer.data(), r) < 0)
+            throw SFTPError{"cannot write to remote file {}: {}", target_path, ssh_get_error(sftp->session)};
+
+        length -= r;
+    }
+}
+
 void SFTPClient::from_cin(std::istream& cin, const fs::path& target_path, bool make_parent)
 {
     auto full_target_path = MP_SFTPUTILS.get_remote_file_target(sftp.get(), stream_file_name, target_path, make_parent);
@@ -341,13 +694,73 @@ void SFTPClient::do_pull_file(const fs::path& source_path, std::ostream& target)
         throw SFTPError{"cannot open remote file {}: {}", source_path, ssh_get_error(sftp->session)};
 
     std::array<char, max_transfer> buffer{};
-    while (auto r = sftp_read(remote_file.get(), buffer.data(), buffer.size()))
+    const auto read_rest = [&] {
+        while (auto r = sftp_read(remote_file.get(), buffer.data(), buffer.size()))
+        {
+            if (r < 0)
+                throw SFTPError{"cannot read from remote file {}: {}", source_path, ssh_get_error(sftp->session)};
+
+            target.write(buffer.data(), r);
+        }
+    };
+
+    if (options.window <= 1)
+        return read_rest();
+
+    // Keep several reads in flight, so the link isn't left idle while each chunk makes its round trip
+    std::deque<int> requests;
+    const auto request_chunk = [&] {
+        const auto id = sftp_async_read_begin(remote_file.get(), max_transfer);
+        if (id < 0)
+            throw SFTPError{"cannot read from remote file {}: {}", source_path, ssh_get_error(sftp->session)};
+
+        requests.push_back(id);
+    };
+
+    // Replies to requests still in flight are read before the handle is closed, however reading ends, so they are not
+    // left behind for whatever the session does next
+    const auto drain_requests = [&]() noexcept {
+        for (const auto id : requests)
+            sftp_async_read(remote_file.get(), buffer.data(), buffer.size(), id);
+        requests.clear();
+    };
+    auto drain_on_exit = sg::make_scope_guard([&drain_requests]() noexcept { drain_requests(); });
+
+    for (auto i = 0u; i < options.window; ++i)
+        request_chunk();
+
+    auto short_read = false;
+    uint64_t offset{0};
+    while (!requests.empty())
     {
+        const auto r = sftp_async_read(remote_file.get(), buffer.data(), buffer.size(), requests.front());
+        requests.pop_front();
+
         if (r < 0)
             throw SFTPError{"cannot read from remote file {}: {}", source_path, ssh_get_error(sftp->session)};
 
+        if (r == 0)
+            return;
+
+        // Requests already sent assumed every earlier one got a full chunk, so data after a short one is not where
+        // they expected
+        if (short_read)
+            break;
+
+        short_read = static_cast<unsigned>(r) < max_transfer;
         target.write(buffer.data(), r);
+        offset += r;
+
+        if (!short_read)
+            request_chunk();
     }
+
+    // The server stopped short of the end of the file; the rest is read one chunk at a time from where it stopped
+    drain_requests();
+    if (sftp_seek64(remote_file.get(), offset) < 0)
+        throw SFTPError{"cannot seek in remote file {}: {}", source_path, ssh_get_error(sftp->session)};
+
+    read_rest();
 }
 
 } // namespace multipass
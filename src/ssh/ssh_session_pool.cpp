@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <multipass/format.h>
+#include <multipass/logging/log.h>
+#include <multipass/ssh/ssh_session_pool.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace mp = multipass;
+namespace mpl = multipass::logging;
+
+namespace
+{
+constexpr auto category = "ssh session pool";
+constexpr auto max_idle_per_key = 4u;
+
+auto key_for(const std::string& host, int port, const std::string& username)
+{
+    return fmt::format("{}@{}:{}", username, host, port);
+}
+} // namespace
+
+mp::SSHSessionPool::Lease::Lease(SSHSessionPool* pool, const std::string& key, std::unique_ptr<SSHSession> session,
+                                 bool reused)
+    : pool{pool}, key{key}, session{std::move(session)}, was_reused{reused}
+{
+}
+
+mp::SSHSessionPool::Lease::Lease(Lease&& other)
+    : pool{other.pool}, key{std::move(other.key)}, session{std::move(other.session)}, was_reused{other.was_reused}
+{
+}
+
+mp::SSHSessionPool::Lease::~Lease()
+{
+    if (session)
+        pool->release(key, std::move(session));
+}
+
+mp::SSHSession& mp::SSHSessionPool::Lease::operator*() const
+{
+    return *session;
+}
+
+mp::SSHSession* mp::SSHSessionPool::Lease::operator->() const
+{
+    return session.get();
+}
+
+bool mp::SSHSessionPool::Lease::reused() const
+{
+    return was_reused;
+}
+
+void mp::SSHSessionPool::Lease::discard()
+{
+    session.reset();
+}
+
+mp::SSHSessionPool::SSHSessionPool(const SSHKeyProvider& key_provider, std::chrono::milliseconds max_idle)
+    : key_provider{key_provider}, max_idle{max_idle}, closer{[this] { close_idle_sessions(); }}
+{
+}
+
+mp::SSHSessionPool::~SSHSessionPool()
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        stopping = true;
+    }
+
+    idle_changed.notify_one();
+    closer.join();
+}
+
+mp::SSHSessionPool::Lease mp::SSHSessionPool::acquire(const std::string& host, int port, const std::string& username)
+{
+    auto key = key_for(host, port, username);
+    std::unique_ptr<SSHSession> session;
+    std::vector<std::unique_ptr<SSHSession>> expired; // closed once the lock is let go
+
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        expired = prune_locked();
+
+        auto it = idle_sessions.find(key);
+        if (it != idle_sessions.end())
+        {
+            auto& sessions = it->second;
+            while (!sessions.empty() && !session)
+            {
+                session = std::move(sessions.back().session);
+                sessions.pop_back();
+
+                if (!ssh_is_connected(*session))
+                    session.reset();
+            }
+        }
+    }
+
+    if (session)
+        return {this, key, std::move(session), true};
+
+    mpl::log(mpl::Level::trace, category, fmt::format("Opening a new session to {}", key));
+    return {this, key, std::make_unique<SSHSession>(host, port, username, key_provider), false};
+}
+
+void mp::SSHSessionPool::release(const std::string& key, std::unique_ptr<SSHSession> session)
+{
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+
+        auto& sessions = idle_sessions[key];
+        if (sessions.size() < max_idle_per_key && ssh_is_connected(*session))
+            sessions.push_back({std::move(session), std::chrono::steady_clock::now()});
+    }
+
+    idle_changed.notify_one();
+}
+
+void mp::SSHSessionPool::drop_idle(const std::string& key)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    idle_sessions.erase(key);
+}
+
+// Takes out the sessions that have been idle for too long, for the caller to close without holding the lock
+std::vector<std::unique_ptr<mp::SSHSession>> mp::SSHSessionPool::prune_locked()
+{
+    const auto oldest = std::chrono::steady_clock::now() - max_idle;
+    std::vector<std::unique_ptr<SSHSession>> expired;
+
+    for (auto it = idle_sessions.begin(); it != idle_sessions.end();)
+    {
+        auto& sessions = it->second;
+        auto first_expired = std::stable_partition(sessions.begin(), sessions.end(),
+                                                   [oldest](const IdleSession& idle) { return idle.since >= oldest; });
+        for (auto expired_it = first_expired; expired_it != sessions.end(); ++expired_it)
+            expired.push_back(std::move(expired_it->session));
+        sessions.erase(first_expired, sessions.end());
+
+        it = sessions.empty() ? idle_sessions.erase(it) : std::next(it);
+    }
+
+    return expired;
+}
+
+// Runs on its own thread for as long as the pool is around, waking up whenever the longest idle session is due
+void mp::SSHSessionPool::close_idle_sessions()
+{
+    std::unique_lock<decltype(mutex)> lock{mutex};
+    while (!stopping)
+    {
+        if (auto expired = prune_locked(); !expired.empty())
+        {
+            lock.unlock();
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        std::optional<std::chrono::steady_clock::time_point> next_due;
+        for (const auto& entry : idle_sessions)
+            for (const auto& idle : entry.second)
+                if (!next_due || idle.since + max_idle < *next_due)
+                    next_due = idle.since + max_idle;
+
+        if (next_due)
+            idle_changed.wait_until(lock, *next_due);
+        else
+            idle_changed.wait(lock);
+    }
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sftp_attribute_cache.h"
+
+#include <multipass/format.h>
+
+#include <QDir>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef MULTIPASS_PLATFORM_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace mp = multipass;
+
+namespace
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+constexpr auto watch_mask = IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+// Elsewhere there are no change notifications, and with no way of telling how long anything stays fresh, watching
+// always fails and nothing gets cached
+int add_watch(int inotify_fd, const std::string& dir)
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    return inotify_add_watch(inotify_fd, dir.c_str(), watch_mask);
+#else
+    return -1;
+#endif
+}
+
+void remove_watch(int inotify_fd, int wd)
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    inotify_rm_watch(inotify_fd, wd);
+#endif
+}
+
+std::string clean(const std::string& path)
+{
+    return QDir::cleanPath(QString::fromStdString(path)).toStdString();
+}
+
+std::string parent_of(const std::string& path)
+{
+    const auto pos = path.find_last_of('/');
+    if (pos == std::string::npos)
+        return ".";
+
+    return pos == 0 ? "/" : path.substr(0, pos);
+}
+
+// Erases path itself and everything underneath it
+template <typename Map>
+void erase_tree(Map& map, const std::string& path)
+{
+    map.erase(path);
+
+    const auto prefix = path == "/" ? path : path + '/';
+    map.erase(map.lower_bound(prefix), map.lower_bound(prefix.substr(0, prefix.size() - 1) + char('/' + 1)));
+}
+
+#ifdef MULTIPASS_PLATFORM_LINUX
+std::string child_of(const std::string& dir, const char* name)
+{
+    return dir == "/" ? dir + name : fmt::format("{}/{}", dir, name);
+}
+
+[[noreturn]] void throw_errno(const char* what)
+{
+    throw std::runtime_error(fmt::format("{}: {}", what, std::strerror(errno)));
+}
+#endif
+} // namespace
+
+mp::SftpAttributeCache::SftpAttributeCache(std::size_t max_entries) : max_entries{max_entries}
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        throw_errno("cannot initialise inotify");
+
+    if (pipe2(stop_fds, O_CLOEXEC) < 0)
+    {
+        close(inotify_fd);
+        throw_errno("cannot create pipe");
+    }
+
+    event_thread = std::thread{&SftpAttributeCache::watch_for_changes, this};
+#endif
+}
+
+mp::SftpAttributeCache::~SftpAttributeCache()
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    // Closing the write end wakes up the event thread
+    close(stop_fds[1]);
+    if (event_thread.joinable())
+        event_thread.join();
+
+    close(stop_fds[0]);
+    close(inotify_fd);
+#endif
+}
+
+std::optional<mp::SftpStat> mp::SftpAttributeCache::find_stat(const std::string& path, bool follow)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto it = stat_entries.find(clean(path));
+    if (it != stat_entries.end())
+    {
+        const auto& stat = follow ? it->second.followed : it->second.not_followed;
+        if (stat)
+        {
+            ++hits;
+            return stat;
+        }
+    }
+
+    ++misses;
+    return std::nullopt;
+}
+
+std::shared_ptr<const mp::SftpDirEntries> mp::SftpAttributeCache::find_listing(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto it = listings.find(clean(path));
+    if (it != listings.end())
+    {
+        ++hits;
+        return it->second;
+    }
+
+    ++misses;
+    return nullptr;
+}
+
+std::optional<mp::SftpAttributeCache::Generation> mp::SftpAttributeCache::watch(const std::string& dir)
+{
+    const auto key = clean(dir);
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto it = watches.find(key);
+    if (it != watches.end())
+        return it->second.generation;
+
+    const auto wd = add_watch(inotify_fd, key);
+    if (wd < 0)
+        return std::nullopt;
+
+    watches.emplace(key, Watch{wd, ++last_generation});
+    dirs_for_wd[wd].push_back(key);
+
+    return last_generation;
+}
+
+void mp::SftpAttributeCache::insert_stat(const std::string& path, bool follow, const SftpStat& stat,
+                                         Generation generation)
+{
+    const auto key = clean(path);
+    std::lock_guard<std::mutex> lock{mutex};
+
+    // Apply whatever happened while the caller was gathering the attributes before deciding to keep them
+    process_events();
+    if (!is_current(parent_of(key), generation) || !make_room())
+        return;
+
+    auto& entry = stat_entries[key];
+    (follow ? entry.followed : entry.not_followed) = stat;
+}
+
+void mp::SftpAttributeCache::insert_listing(const std::string& path, std::shared_ptr<const SftpDirEntries> entries,
+                                            Generation generation)
+{
+    const auto key = clean(path);
+    std::lock_guard<std::mutex> lock{mutex};
+
+    process_events();
+    if (!is_current(key, generation) || !make_room())
+        return;
+
+    listings[key] = std::move(entries);
+}
+
+void mp::SftpAttributeCache::invalidate(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    invalidate_locked(clean(path));
+}
+
+mp::SftpAttributeCache::Stats mp::SftpAttributeCache::stats() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return {hits, misses, stat_entries.size() + listings.size()};
+}
+
+void mp::SftpAttributeCache::watch_for_changes()
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    std::array<pollfd, 2> fds{{{inotify_fd, POLLIN, 0}, {stop_fds[0], POLLIN, 0}}};
+
+    while (true)
+    {
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // Without notifications nothing can be trusted to stay fresh
+            std::lock_guard<std::mutex> lock{mutex};
+            reset();
+            return;
+        }
+
+        if (fds[1].revents)
+            return;
+
+        if (fds[0].revents & POLLIN)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            process_events();
+        }
+    }
+#endif
+}
+
+void mp::SftpAttributeCache::process_events()
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    alignas(inotify_event) char buffer[4096];
+
+    while (true)
+    {
+        const auto len = read(inotify_fd, buffer, sizeof(buffer));
+        if (len <= 0)
+            return;
+
+        for (auto ptr = buffer; ptr < buffer + len;)
+        {
+            const auto event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                stat_entries.clear();
+                listings.clear();
+                for (auto& entry : watches)
+                    entry.second.generation = ++last_generation;
+                continue;
+            }
+
+            auto it = dirs_for_wd.find(event->wd);
+            if (it == dirs_for_wd.end())
+                continue;
+
+            // Copied, as invalidating may drop this very watch
+            const auto dirs = it->second;
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                drop_watch(event->wd, !(event->mask & IN_IGNORED));
+
+            for (const auto& dir : dirs)
+                invalidate_locked(event->len > 0 ? child_of(dir, event->name) : dir);
+        }
+    }
+#endif
+}
+
+void mp::SftpAttributeCache::invalidate_locked(const std::string& path)
+{
+    erase_tree(stat_entries, path);
+    erase_tree(listings, path);
+
+    // The parent's listing and times change along with any of its entries. Its own stat is filed under the watch on
+    // its parent, which moves on as well, so that one gathered before the change isn't kept
+    const auto parent = parent_of(path);
+    stat_entries.erase(parent);
+    listings.erase(parent);
+
+    for (const auto& dir : {parent, parent_of(parent)})
+        if (auto it = watches.find(dir); it != watches.end())
+            it->second.generation = ++last_generation;
+
+    // Watches on path and underneath may now be following directories that live somewhere else, so they are
+    // dropped and set up again on the next lookup
+    std::vector<int> stale_wds;
+    if (auto it = watches.find(path); it != watches.end())
+        stale_wds.push_back(it->second.wd);
+
+    const auto prefix = path == "/" ? path : path + '/';
+    for (auto it = watches.lower_bound(prefix);
+         it != watches.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+        stale_wds.push_back(it->second.wd);
+
+    for (const auto wd : stale_wds)
+        drop_watch(wd, true);
+}
+
+void mp::SftpAttributeCache::drop_watch(int wd, bool remove)
+{
+    auto it = dirs_for_wd.find(wd);
+    if (it == dirs_for_wd.end())
+        return;
+
+    for (const auto& dir : it->second)
+        if (auto watch = watches.find(dir); watch != watches.end() && watch->second.wd == wd)
+            watches.erase(watch);
+
+    dirs_for_wd.erase(it);
+
+    if (remove)
+        remove_watch(inotify_fd, wd);
+}
+
+bool mp::SftpAttributeCache::is_current(const std::string& dir, Generation generation) const
+{
+    auto it = watches.find(dir);
+    return it != watches.end() && it->second.generation == generation;
+}
+
+bool mp::SftpAttributeCache::make_room()
+{
+    if (stat_entries.size() + listings.size() < max_entries)
+        return true;
+
+    // Start over rather than tracking usage; the watches go too, so they don't pile up either
+    reset();
+    return false;
+}
+
+void mp::SftpAttributeCache::reset()
+{
+    for (const auto& entry : dirs_for_wd)
+        remove_watch(inotify_fd, entry.first);
+
+    stat_entries.clear();
+    listings.clear();
+    watches.clear();
+    dirs_for_wd.clear();
+}
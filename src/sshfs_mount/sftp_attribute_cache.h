@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIPASS_SFTP_ATTRIBUTE_CACHE_H
+#define MULTIPASS_SFTP_ATTRIBUTE_CACHE_H
+
+#include <libssh/sftp.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace multipass
+{
+struct SftpDirEntry
+{
+    std::string filename;
+    std::string longname;
+    sftp_attributes_struct attr;
+};
+
+using SftpDirEntries = std::vector<SftpDirEntry>;
+
+struct SftpStat
+{
+    bool exists;
+    sftp_attributes_struct attr;
+};
+
+// Keeps the attributes and directory listings the SFTP server replies with, so repeated lookups don't need to touch
+// the host filesystem. Entries are dropped when inotify reports a change in the directory they come from, or when
+// the server invalidates them after changing something itself. Without inotify, watching always fails, so nothing is
+// ever cached and every lookup misses.
+class SftpAttributeCache
+{
+public:
+    using Generation = std::uint64_t;
+
+    struct Stats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::size_t entries;
+    };
+
+    explicit SftpAttributeCache(std::size_t max_entries);
+    ~SftpAttributeCache();
+
+    std::optional<SftpStat> find_stat(const std::string& path, bool follow);
+    std::shared_ptr<const SftpDirEntries> find_listing(const std::string& path);
+
+    // Starts watching dir, if needed, and returns its current generation. Inserting with a generation that is no
+    // longer current is ignored, so anything that changed while the caller was gathering the entry is not cached.
+    std::optional<Generation> watch(const std::string& dir);
+    void insert_stat(const std::string& path, bool follow, const SftpStat& stat, Generation generation);
+    void insert_listing(const std::string& path, std::shared_ptr<const SftpDirEntries> entries,
+                        Generation generation);
+
+    void invalidate(const std::string& path);
+    Stats stats() const;
+
+private:
+    struct StatEntry
+    {
+        std::optional<SftpStat> followed;
+        std::optional<SftpStat> not_followed;
+    };
+
+    struct Watch
+    {
+        int wd;
+        Generation generation;
+    };
+
+    void watch_for_changes();
+    void process_events();
+    void invalidate_locked(const std::string& path);
+    void drop_watch(int wd, bool remove);
+    bool is_current(const std::string& dir, Generation generation) const;
+    bool make_room();
+    void reset();
+
+    const std::size_t max_entries;
+    int inotify_fd{-1};
+    int stop_fds[2]{-1, -1};
+    mutable std::mutex mutex;
+    std::map<std::string, StatEntry> stat_entries;
+    std::map<std::string, std::shared_ptr<const SftpDirEntries>> listings;
+    std::map<std::string, Watch> watches;
+    std::unordered_map<int, std::vector<std::string>> dirs_for_wd;
+    Generation last_generation{0};
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::thread event_thread;
+};
+} // namespace multipass
+#endif // MULTIPASS_SFTP_ATTRIBUTE_CACHE_H
@@ -25,12 +25,35 @@
 #include <multipass/platform.h>
 #include <multipass/ssh/ssh_session.h>
 #include <multipass/ssh/throw_on_error.h>
+#include <multipass/top_catch_all.h>
 #include <multipass/utils.h>
 
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#ifdef MULTIPASS_PLATFORM_WINDOWS
+#include <io.h>
+#include <winsock2.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif
+
 namespace mp = multipass;
 namespace mpl = multipass::logging;
 
@@ -40,6 +63,23 @@ constexpr auto category = "sftp server";
 using SftpHandleUPtr = std::unique_ptr<ssh_string_struct, void (*)(ssh_string)>;
 using namespace std::literals::chrono_literals;
 
+// Upper bound on how long the reader waits on the socket before checking the channel again, in case a
+// worker sending a reply has already pulled the pending data into libssh's buffers
+constexpr auto reader_poll_interval = 50ms;
+
+// Same limit as OpenSSH's sftp-server, leaving room for the reply header within its maximum message length
+constexpr auto max_read_length = 256u * 1024u - 1024u;
+
+// Directory listings are held to the same budget, as clients cap every message they receive to the same length
+constexpr auto max_names_length = max_read_length;
+
+// What an entry adds to a names reply: length-prefixed filename and longname, plus flags, size, ids,
+// permissions and times
+std::size_t encoded_length(const mp::SftpDirEntry& entry)
+{
+    return 4 + entry.filename.size() + 4 + entry.longname.size() + 32;
+}
+
 enum Permissions
 {
     read_user = 0400,
@@ -53,13 +93,179 @@ enum Permissions
     exec_other = 01
 };
 
+// Extended methods handled below, with their versions, as announced to the client during the handshake
+constexpr std::array<std::pair<const char*, const char*>, 6> advertised_extensions{{{"posix-rename@openssh.com", "1"},
+                                                                                   {"statvfs@openssh.com", "2"},
+                                                                                   {"fstatvfs@openssh.com", "2"},
+                                                                                   {"hardlink@openssh.com", "1"},
+                                                                                   {"fsync@openssh.com", "1"},
+                                                                                   {"copy-data", "1"}}};
+
+// Fields of extended requests, read from libssh's copy of the whole request. libssh only parses the fields of a
+// couple of methods itself, and not the same ones in every version, so everything is taken from the copy
+class ExtendedPayload
+{
+public:
+    explicit ExtendedPayload(sftp_client_message msg)
+        : data{msg->complete_message ? static_cast<const unsigned char*>(ssh_buffer_get(msg->complete_message))
+                                     : nullptr},
+          remaining{msg->complete_message ? ssh_buffer_get_len(msg->complete_message) : 0u}
+    {
+        // Skip the request id and the method name
+        read_integer(4);
+        string();
+    }
+
+    std::optional<uint64_t> u64()
+    {
+        return read_integer(8);
+    }
+
+    std::optional<std::string> string()
+    {
+        const auto len = read_integer(4);
+        if (!len || *len > remaining)
+            return std::nullopt;
+
+        std::string value{reinterpret_cast<const char*>(data), *len};
+        consume(*len);
+        return value;
+    }
+
+    SftpHandleUPtr handle()
+    {
+        SftpHandleUPtr handle{nullptr, ssh_string_free};
+        if (auto value = string())
+        {
+            handle.reset(ssh_string_new(value->size()));
+            if (handle)
+                ssh_string_fill(handle.get(), value->data(), value->size());
+        }
+
+        return handle;
+    }
+
+private:
+    std::optional<uint64_t> read_integer(std::size_t size)
+    {
+        if (remaining < size)
+            return std::nullopt;
+
+        uint64_t value{0};
+        for (std::size_t i = 0; i < size; ++i)
+            value = (value << 8) | data[i];
+
+        consume(size);
+        return value;
+    }
+
+    void consume(std::size_t size)
+    {
+        data += size;
+        remaining -= size;
+    }
+
+    const unsigned char* data;
+    std::size_t remaining;
+};
+
+void append_u32(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (auto shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<unsigned char>(value >> shift));
+}
+
+void append_u64(std::vector<unsigned char>& out, uint64_t value)
+{
+    append_u32(out, static_cast<uint32_t>(value >> 32));
+    append_u32(out, static_cast<uint32_t>(value));
+}
+
+void append_string(std::vector<unsigned char>& out, const std::string& value)
+{
+    append_u32(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+int write_packet(ssh_channel channel, uint8_t type, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> packet;
+    append_u32(packet, static_cast<uint32_t>(1 + data.size()));
+    packet.push_back(type);
+    packet.insert(packet.end(), data.begin(), data.end());
+
+    const auto written = ssh_channel_write(channel, packet.data(), packet.size());
+    return written == static_cast<int>(packet.size()) ? SSH_OK : SSH_ERROR;
+}
+
+bool read_exactly(ssh_channel channel, unsigned char* data, uint32_t size)
+{
+    while (size > 0)
+    {
+        const auto read = ssh_channel_read(channel, data, size, 0);
+        if (read <= 0)
+            return false;
+
+        data += read;
+        size -= static_cast<uint32_t>(read);
+    }
+
+    return true;
+}
+
+uint32_t to_u32(const unsigned char* data)
+{
+    return uint32_t{data[0]} << 24 | uint32_t{data[1]} << 16 | uint32_t{data[2]} << 8 | uint32_t{data[3]};
+}
+
+// libssh's sftp_server_init replies with a bare version, which leaves clients unaware of the extensions handled
+// here, so the handshake is done by hand
+int init_sftp_server(sftp_session sftp)
+{
+    std::array<unsigned char, 4 + 1 + 4> init;
+    if (!read_exactly(sftp->channel, init.data(), init.size()))
+        return SSH_ERROR;
+
+    // The client may follow its version with extension data of its own, which is of no use here
+    const auto length = to_u32(init.data());
+    if (init[4] != SSH_FXP_INIT || length < 1 + 4 || length > max_read_length)
+        return SSH_ERROR;
+
+    std::vector<unsigned char> extension_data(length - 1 - 4);
+    if (!read_exactly(sftp->channel, extension_data.data(), static_cast<uint32_t>(extension_data.size())))
+        return SSH_ERROR;
+
+    sftp->client_version = static_cast<int>(to_u32(init.data() + 5));
+    sftp->server_version = sftp->version = LIBSFTP_VERSION;
+
+    std::vector<unsigned char> version;
+    append_u32(version, LIBSFTP_VERSION);
+    for (const auto& [name, extension_version] : advertised_extensions)
+    {
+        append_string(version, name);
+        append_string(version, extension_version);
+    }
+
+    return write_packet(sftp->channel, SSH_FXP_VERSION, version);
+}
+
 auto make_sftp_session(ssh_session session, ssh_channel channel)
 {
     mp::SftpServer::SftpSessionUptr sftp_server_session{sftp_server_new(session, channel), sftp_free};
-    mp::SSH::throw_on_error(sftp_server_session, session, "[sftp] server init failed", sftp_server_init);
+    mp::SSH::throw_on_error(sftp_server_session, session, "[sftp] server init failed", init_sftp_server);
     return sftp_server_session;
 }
 
+// libssh has no public call for replies whose contents are defined by an extension, so the packet is framed here
+int reply_extended(sftp_client_message msg, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> packet;
+    append_u32(packet, msg->id);
+    packet.insert(packet.end(), data.begin(), data.end());
+
+    return write_packet(msg->sftp->channel, SSH_FXP_EXTENDED_REPLY, packet);
+}
+
 int reply_ok(sftp_client_message msg)
 {
     return sftp_reply_status(msg, SSH_FX_OK, nullptr);
@@ -91,69 +297,63 @@ fmt::memory_buffer& operator<<(fmt::memory_buffer& buf, const char* v)
     return buf;
 }
 
-auto longname_from(const QFileInfo& file_info, const std::string& filename)
+auto longname_from(const char type, const uint32_t mode, const unsigned int owner, const unsigned int group,
+                   const uint64_t size, const QDateTime& last_modified, const std::string& filename)
 {
     fmt::memory_buffer out;
-    auto mode = file_info.permissions();
-
-    if (file_info.isSymLink())
-        out << "l";
-    else if (file_info.isDir())
-        out << "d";
-    else
-        out << "-";
+    fmt::format_to(out, "{}", type);
 
     /* user */
-    if (mode & QFileDevice::ReadOwner)
+    if (mode & Permissions::read_user)
         out << "r";
     else
         out << "-";
 
-    if (mode & QFileDevice::WriteOwner)
+    if (mode & Permissions::write_user)
         out << "w";
     else
         out << "-";
 
-    if (mode & QFileDevice::ExeOwner)
+    if (mode & Permissions::exec_user)
         out << "x";
     else
         out << "-";
 
     /*group*/
-    if (mode & QFileDevice::ReadGroup)
+    if (mode & Permissions::read_group)
         out << "r";
     else
         out << "-";
 
-    if (mode & QFileDevice::WriteGroup)
+    if (mode & Permissions::write_group)
         out << "w";
     else
         out << "-";
 
-    if (mode & QFileDevice::ExeGroup)
+    if (mode & Permissions::exec_group)
         out << "x";
     else
         out << "-";
 
     /* other */
-    if (mode & QFileDevice::ReadOther)
+    if (mode & Permissions::read_other)
         out << "r";
     else
         out << "-";
 
-    if (mode & QFileDevice::WriteOther)
+    if (mode & Permissions::write_other)
         out << "w";
     else
         out << "-";
 
-    if (mode & QFileDevice::ExeOther)
+    if (mode & Permissions::exec_other)
         out << "x";
     else
         out << "-";
 
-    fmt::format_to(out, " 1 {} {} {}", file_info.ownerId(), file_info.groupId(), file_info.size());
+    fmt::format_to(out, " 1 {} {} {}", owner, group, size);
 
-    const auto timestamp = file_info.lastModified().toString("MMM d hh:mm:ss yyyy").toStdString();
+    const auto timestamp = last_modified.toString("MMM d hh:mm:ss yyyy").toStdString();
     fmt::format_to(out, " {} {}", timestamp, filename);
 
     return out;
@@ -211,6 +411,91 @@ auto to_unix_permissions(QFile::Permissions perms)
     return out;
 }
 
+auto longname_from(const QFileInfo& file_info, const std::string& filename)
+{
+    const auto type = file_info.isSymLink() ? 'l' : file_info.isDir() ? 'd' : '-';
+
+    return longname_from(type, to_unix_permissions(file_info.permissions()), file_info.ownerId(),
+                         file_info.groupId(), file_info.size(), file_info.lastModified(), filename);
+}
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+struct RawDirEntry
+{
+    std::string filename;
+    struct stat st;
+};
+
+// readdir() fetches entries from the kernel in large batches (getdents64 on Linux) and stat'ing relative to the
+// directory's descriptor saves resolving the whole path again for every entry
+std::optional<std::vector<RawDirEntry>> read_dir(const std::string& path)
+{
+    std::unique_ptr<DIR, int (*)(DIR*)> dir{::opendir(path.c_str()), ::closedir};
+    if (!dir)
+        return std::nullopt;
+
+    const auto fd = ::dirfd(dir.get());
+    std::vector<RawDirEntry> entries;
+
+    errno = 0;
+    while (const auto entry = ::readdir(dir.get()))
+    {
+        RawDirEntry raw{entry->d_name, {}};
+
+        // Entries removed since the directory was read are left out
+        if (::fstatat(fd, entry->d_name, &raw.st, AT_SYMLINK_NOFOLLOW) == 0)
+            entries.push_back(std::move(raw));
+
+        errno = 0;
+    }
+
+    if (errno != 0)
+        return std::nullopt;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const RawDirEntry& a, const RawDirEntry& b) { return a.filename < b.filename; });
+
+    return entries;
+}
+
+// Matches what attr_from() and symlink_attr_from() report, leaving ids unmapped
+sftp_attributes_struct attr_from_stat(const struct stat& st)
+{
+    sftp_attributes_struct attr{};
+
+    attr.size = st.st_size;
+    attr.uid = st.st_uid;
+    attr.gid = st.st_gid;
+    attr.atime = st.st_atime;
+    attr.mtime = st.st_mtime;
+    attr.flags =
+        SSH_FILEXFER_ATTR_SIZE | SSH_FILEXFER_ATTR_UIDGID | SSH_FILEXFER_ATTR_PERMISSIONS | SSH_FILEXFER_ATTR_ACMODTIME;
+
+    if (S_ISLNK(st.st_mode))
+    {
+        attr.permissions = st.st_mode;
+    }
+    else
+    {
+        attr.permissions = st.st_mode & 0777;
+        if (S_ISDIR(st.st_mode))
+            attr.permissions |= SSH_S_IFDIR;
+        else if (S_ISREG(st.st_mode))
+            attr.permissions |= SSH_S_IFREG;
+    }
+
+    return attr;
+}
+
+auto longname_from(const struct stat& st, const std::string& filename)
+{
+    const auto type = S_ISLNK(st.st_mode) ? 'l' : S_ISDIR(st.st_mode) ? 'd' : '-';
+
+    return longname_from(type, st.st_mode & 0777, st.st_uid, st.st_gid, st.st_size,
+                         QDateTime::fromSecsSinceEpoch(st.st_mtime), filename);
+}
+#endif
+
 auto validate_path(const std::string& source_path, const std::string& current_path)
 {
     if (source_path.empty())
@@ -219,14 +504,62 @@ auto validate_path(const std::string& source_path, const std::string& current_pa
     return current_path.compare(0, source_path.length(), source_path) == 0;
 }
 
-template <typename T>
-auto handle_from(sftp_client_message msg, const std::unordered_map<void*, std::unique_ptr<T>>& handles) -> T*
+bool wait_for_readable(socket_t socket, std::chrono::milliseconds timeout)
 {
-    const auto id = sftp_handle(msg->sftp, msg->handle);
-    auto entry = handles.find(id);
-    if (entry != handles.end())
-        return entry->second.get();
-    return nullptr;
+#ifdef MULTIPASS_PLATFORM_WINDOWS
+    WSAPOLLFD fd{socket, POLLIN, 0};
+    return WSAPoll(&fd, 1, static_cast<INT>(timeout.count())) > 0;
+#else
+    pollfd fd{socket, POLLIN, 0};
+    return poll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+#endif
+}
+
+// libssh only parses the handle of the basic requests; the extended ones acting on a handle carry it first in their
+// payload
+std::optional<std::string> handle_of(sftp_client_message msg)
+{
+    if (msg->handle != nullptr)
+        return std::string{ssh_string_get_char(msg->handle), ssh_string_len(msg->handle)};
+
+    const auto submessage = sftp_client_message_get_submessage(msg);
+    if (sftp_client_message_get_type(msg) != SFTP_EXTENDED || submessage == nullptr)
+        return std::nullopt;
+
+    const std::string method{submessage};
+    if (method != "fsync@openssh.com" && method != "fstatvfs@openssh.com" && method != "copy-data")
+        return std::nullopt;
+
+    return ExtendedPayload{msg}.string();
+}
+
+// libssh hands over everything buffered on the channel, which starts at a message since messages are only read whole.
+// It is all left for sftp_get_client_message to read
+int count_complete_packets(ssh_session, ssh_channel, void* data, uint32_t len, int is_stderr, void* userdata)
+{
+    if (is_stderr)
+        return 0;
+
+    const auto bytes = static_cast<const unsigned char*>(data);
+    int count{0};
+    uint64_t offset{0};
+    while (len - offset >= 4 && len - offset - 4 >= to_u32(bytes + offset))
+    {
+        offset += 4 + uint64_t{to_u32(bytes + offset)};
+        ++count;
+    }
+
+    *static_cast<int*>(userdata) = count;
+    return 0;
+}
+
+// libssh only takes in what arrived on the socket when reading from an empty channel, which one holding part of a
+// message never is, so the session is polled here without waiting
+void take_in_arrived_data(ssh_session session)
+{
+    std::unique_ptr<ssh_event_struct, decltype(ssh_event_free)*> event{ssh_event_new(), ssh_event_free};
+    ssh_event_add_session(event.get(), session);
+    ssh_event_dopoll(event.get(), 0);
 }
 
 void check_sshfs_status(mp::SSHSession& session, mp::SSHProcess& sshfs_process)
@@ -276,11 +609,41 @@ int reverse_id_for(const mp::id_mappings& id_maps, const int id, const int rev_i
 
     return found == id_maps.cend() ? rev_id_if_not_found : found->first;
 }
+
+std::unique_ptr<mp::SftpAttributeCache> make_attr_cache(const mp::SftpServerOptions& options)
+{
+    if (options.attr_cache_entries == 0)
+        return nullptr;
+
+#ifdef MULTIPASS_PLATFORM_LINUX
+    try
+    {
+        return std::make_unique<mp::SftpAttributeCache>(options.attr_cache_entries);
+    }
+    catch (const std::exception& e)
+    {
+        mpl::log(mpl::Level::warning, category, fmt::format("Attribute cache disabled: {}", e.what()));
+    }
+#else
+    mpl::log(mpl::Level::warning, category, "Attribute cache is not supported on this platform");
+#endif
+
+    return nullptr;
+}
 } // namespace
 
+struct mp::SftpServer::Worker
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<MsgUPtr> queue;
+    bool stopping{false};
+    std::thread thread;
+};
+
 mp::SftpServer::SftpServer(SSHSession&& session, const std::string& source, const std::string& target,
                            const id_mappings& gid_mappings, const id_mappings& uid_mappings, int default_uid,
-                           int default_gid, const std::string& sshfs_exec_line)
+                           int default_gid, const std::string& sshfs_exec_line, const SftpServerOptions& options)
     : ssh_session{std::move(session)},
       sshfs_process{create_sshfs_process(ssh_session, sshfs_exec_line, mp::utils::escape_char(source, '"'),
                                          mp::utils::escape_char(target, '"'))},
@@ -291,13 +654,62 @@ mp::SftpServer::SftpServer(SSHSession&& session, const std::string& source, cons
       uid_mappings{uid_mappings},
       default_uid{default_uid},
       default_gid{default_gid},
-      sshfs_exec_line{sshfs_exec_line}
+      sshfs_exec_line{sshfs_exec_line},
+      options{options},
+      attr_cache{make_attr_cache(options)}
 {
 }
 
 mp::SftpServer::~SftpServer()
 {
     stop_invoked = true;
+    stop_workers();
+
+    // Handles the client never closed still get their buffered data written
+    for (auto& entry : pending_writes)
+    {
+        auto file = open_file_handles.find(entry.first);
+        if (file != open_file_handles.end())
+            write_out(*file->second, *entry.second);
+    }
+}
+
+std::optional<mp::SftpAttributeCache::Stats> mp::SftpServer::attr_cache_stats() const
+{
+    if (!attr_cache)
+        return std::nullopt;
+
+    return attr_cache->stats();
+}
+
+template <typename T>
+std::shared_ptr<T> mp::SftpServer::handle_from(sftp_client_message msg,
+                                               const std::unordered_map<void*, std::shared_ptr<T>>& handles)
+{
+    return handle_from(msg, msg->handle, handles);
+}
+
+template <typename T>
+std::shared_ptr<T> mp::SftpServer::handle_from(sftp_client_message msg, ssh_string handle,
+                                               const std::unordered_map<void*, std::shared_ptr<T>>& handles)
+{
+    if (handle == nullptr)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock{handles_mutex};
+    const auto id = sftp_handle(msg->sftp, handle);
+    auto entry = handles.find(id);
+    if (entry != handles.end())
+        return entry->second;
+    return nullptr;
+}
+
+template <typename Reply, typename... Args>
+int mp::SftpServer::reply(Reply&& send_reply, Args&&... args)
+{
+    // Replies are written to the channel, which may be shared with the reader and other workers
+    std::lock_guard<std::mutex> lock{session_mutex};
+    return send_reply(std::forward<Args>(args)...);
 }
 
 sftp_attributes_struct mp::SftpServer::attr_from(const QFileInfo& file_info)
@@ -325,6 +737,166 @@ sftp_attributes_struct mp::SftpServer::attr_from(const QFileInfo& file_info)
     return attr;
 }
 
+mp::SftpStat mp::SftpServer::stat_for(const QString& filename, const bool follow)
+{
+    QFileInfo file_info(filename);
+    if (!file_info.isSymLink() && !file_info.exists())
+        return {false, {}};
+
+    sftp_attributes_struct attr{};
+
+    if (!follow && file_info.isSymLink())
+    {
+        mp::platform::symlink_attr_from(filename.toStdString().c_str(), &attr);
+        attr.uid = mapped_uid_for(attr.uid);
+        attr.gid = mapped_gid_for(attr.gid);
+    }
+    else
+    {
+        if (file_info.isSymLink())
+            file_info = QFileInfo(file_info.symLinkTarget());
+
+        attr = attr_from(file_info);
+    }
+
+    return {true, attr};
+}
+
+std::shared_ptr<const mp::SftpDirEntries> mp::SftpServer::entries_for(const QDir& dir)
+{
+    auto entries = std::make_shared<SftpDirEntries>();
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+    if (auto raw_entries = read_dir(dir.path().toStdString()))
+    {
+        entries->reserve(raw_entries->size());
+        for (const auto& raw : *raw_entries)
+        {
+            auto attr = attr_from_stat(raw.st);
+            attr.uid = mapped_uid_for(attr.uid);
+            attr.gid = mapped_gid_for(attr.gid);
+
+            entries->push_back({raw.filename, fmt::to_string(longname_from(raw.st, raw.filename)), attr});
+        }
+
+        return entries;
+    }
+#endif
+
+    for (const auto& entry : dir.entryInfoList(QDir::AllEntries | QDir::System | QDir::Hidden))
+    {
+        const auto filename = entry.fileName().toStdString();
+        sftp_attributes_struct attr{};
+        if (entry.isSymLink())
+        {
+            mp::platform::symlink_attr_from(entry.absoluteFilePath().toStdString().c_str(), &attr);
+            attr.uid = mapped_uid_for(attr.uid);
+            attr.gid = mapped_gid_for(attr.gid);
+        }
+        else
+        {
+            attr = attr_from(entry);
+        }
+
+        entries->push_back({filename, fmt::to_string(longname_from(entry, filename)), attr});
+    }
+
+    return entries;
+}
+
+void mp::SftpServer::invalidate_cached(const QString& path)
+{
+    if (attr_cache)
+        attr_cache->invalidate(path.toStdString());
+}
+
+bool mp::SftpServer::write_at(QFile& file, uint64_t offset, const char* data, std::size_t len)
+{
+    if (!MP_FILEOPS.seek(file, offset))
+    {
+        mpl::log(mpl::Level::trace, category,
+                 fmt::format("{}: cannot seek to position {} in \'{}\'", __FUNCTION__, offset, file.fileName()));
+        return false;
+    }
+
+    do
+    {
+        auto r = MP_FILEOPS.write(file, data, len);
+        if (r < 0)
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("{}: write failed for \'{}\': {}", __FUNCTION__, file.fileName(), file.errorString()));
+            return false;
+        }
+
+        file.flush();
+
+        data += r;
+        len -= r;
+    } while (len > 0);
+
+    invalidate_cached(file.fileName());
+    return true;
+}
+
+// Expects pending's mutex to be held. Whatever was buffered is dropped, even on failure, which is reported once to
+// whichever request triggered the write
+bool mp::SftpServer::write_out(QFile& file, PendingWrite& pending)
+{
+    if (pending.data.empty())
+        return true;
+
+    const auto written = write_at(file, pending.offset, pending.data.data(), pending.data.size());
+    pending.data.clear();
+
+    return written;
+}
+
+std::shared_ptr<mp::SftpServer::PendingWrite> mp::SftpServer::pending_for(QFile& file)
+{
+    std::lock_guard<std::mutex> lock{handles_mutex};
+    auto it = pending_writes.find(&file);
+    return it != pending_writes.end() ? it->second : nullptr;
+}
+
+std::optional<mp::SftpServer::FileLock> mp::SftpServer::flush_pending(QFile& file)
+{
+    FileLock file_lock{pending_for(file), {}};
+    if (file_lock.pending == nullptr)
+        return file_lock;
+
+    file_lock.lock = std::unique_lock<std::mutex>{file_lock.pending->mutex};
+    if (!write_out(file, *file_lock.pending))
+        return std::nullopt;
+
+    return file_lock;
+}
+
+bool mp::SftpServer::flush_pending(const QString& path)
+{
+    // Only the lookup is done under the handles' lock. Each file is written to under its own, which whoever is using
+    // it through its handle holds as well
+    std::vector<std::pair<std::shared_ptr<QFile>, std::shared_ptr<PendingWrite>>> open_files;
+    {
+        std::lock_guard<std::mutex> lock{handles_mutex};
+        for (const auto& entry : pending_writes)
+        {
+            auto file = open_file_handles.find(entry.first);
+            if (file != open_file_handles.end() && file->second->fileName() == path)
+                open_files.emplace_back(file->second, entry.second);
+        }
+    }
+
+    auto flushed = true;
+    for (const auto& [file, pending] : open_files)
+    {
+        std::lock_guard<std::mutex> pending_lock{pending->mutex};
+        flushed = write_out(*file, *pending) && flushed;
+    }
+
+    return flushed;
+}
+
 inline int mp::SftpServer::mapped_uid_for(const int uid)
 {
     return mapped_id_for(uid_mappings, uid, default_uid);
@@ -406,22 +978,130 @@ void mp::SftpServer::process_message(sftp_client_message msg)
         break;
     default:
         mpl::log(mpl::Level::trace, category, fmt::format("Unknown message: {}", static_cast<int>(type)));
-        ret = reply_unsupported(msg);
+        ret = reply(reply_unsupported, msg);
     }
     if (ret != 0)
         mpl::log(mpl::Level::error, category, fmt::format("error occurred when replying to client: {}", ret));
 }
 
+mp::SftpServer::MsgUPtr mp::SftpServer::read_message()
+{
+    if (workers.empty())
+        return {sftp_get_client_message(sftp_server_session.get()), sftp_client_message_free};
+
+    // Only hold on to the session while a whole message is there to be read, so that workers can send their replies
+    // while the client is still sending the rest of one
+    while (!stop_invoked)
+    {
+        {
+            std::lock_guard<std::mutex> lock{session_mutex};
+            take_in_arrived_data(ssh_session);
+
+            const auto available = ssh_channel_poll(sftp_server_session->channel, 0);
+            if (complete_packets_buffered > 0)
+            {
+                --complete_packets_buffered;
+                return {sftp_get_client_message(sftp_server_session.get()), sftp_client_message_free};
+            }
+
+            // libssh gives up on reading right away once the channel is at its end or broken
+            if (available < 0)
+                return {sftp_get_client_message(sftp_server_session.get()), sftp_client_message_free};
+        }
+
+        wait_for_readable(ssh_get_fd(ssh_session), reader_poll_interval);
+    }
+
+    return {nullptr, sftp_client_message_free};
+}
+
+void mp::SftpServer::dispatch(MsgUPtr msg)
+{
+    // Requests on a handle always go to the same worker, so they are processed in the order they were received.
+    // copy-data goes by the handle it reads from; the file it writes to is only used under that file's lock
+    std::size_t index;
+    if (const auto handle = handle_of(msg.get()))
+        index = std::hash<std::string>{}(*handle);
+    else
+        index = next_worker++;
+
+    auto& worker = *workers[index % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        worker.queue.push_back(std::move(msg));
+    }
+    worker.cv.notify_one();
+}
+
+void mp::SftpServer::start_workers()
+{
+    if (options.worker_threads > 0)
+    {
+        complete_packets_buffered = 0;
+        channel_callbacks = {};
+        ssh_callbacks_init(&channel_callbacks);
+        channel_callbacks.channel_data_function = count_complete_packets;
+        channel_callbacks.userdata = &complete_packets_buffered;
+        ssh_add_channel_callbacks(sftp_server_session->channel, &channel_callbacks);
+    }
+
+    for (auto i = 0; i < options.worker_threads; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->thread = std::thread{[this, &worker = *worker] {
+            while (true)
+            {
+                std::unique_lock<std::mutex> lock{worker.mutex};
+                worker.cv.wait(lock, [&worker] { return worker.stopping || !worker.queue.empty(); });
+                if (worker.queue.empty())
+                    return;
+
+                auto msg = std::move(worker.queue.front());
+                worker.queue.pop_front();
+                lock.unlock();
+
+                mp::top_catch_all(category, [this, &msg] { process_message(msg.get()); });
+            }
+        }};
+        workers.push_back(std::move(worker));
+    }
+}
+
+void mp::SftpServer::stop_workers()
+{
+    for (auto& worker : workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock{worker->mutex};
+            worker->stopping = true;
+        }
+        worker->cv.notify_one();
+    }
+
+    // Queued requests are still answered before the workers exit
+    for (auto& worker : workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+
+    if (!workers.empty())
+        ssh_remove_channel_callbacks(sftp_server_session->channel, &channel_callbacks);
+
+    workers.clear();
+}
+
 void mp::SftpServer::run()
 {
-    using MsgUPtr = std::unique_ptr<sftp_client_message_struct, decltype(sftp_client_message_free)*>;
+    start_workers();
 
     while (true)
     {
-        MsgUPtr client_msg{sftp_get_client_message(sftp_server_session.get()), sftp_client_message_free};
+        auto client_msg = read_message();
         auto msg = client_msg.get();
         if (msg == nullptr)
         {
+            // Outstanding requests refer to the current sftp session, so they need to be finished before it goes away
+            stop_workers();
+
             if (stop_invoked)
                 break;
 
@@ -450,6 +1130,7 @@ void mp::SftpServer::run()
                     create_sshfs_process(ssh_session, sshfs_exec_line, mp::utils::escape_char(source_path, '"'),
                                          mp::utils::escape_char(target_path, '"'));
                 sftp_server_session = make_sftp_session(ssh_session, sshfs_process->release_channel());
+                start_workers();
 
                 continue;
             }
@@ -459,7 +1140,10 @@ void mp::SftpServer::run()
             }
         }
 
-        process_message(msg);
+        if (workers.empty())
+            process_message(msg);
+        else
+            dispatch(std::move(client_msg));
     }
 }
 
@@ -471,18 +1155,32 @@ void mp::SftpServer::stop()
 
 int mp::SftpServer::handle_close(sftp_client_message msg)
 {
-    const auto id = sftp_handle(sftp_server_session.get(), msg->handle);
+    // This is the last chance to report a failure writing out buffered data
+    auto file = handle_from(msg, open_file_handles);
+    const auto flushed = file == nullptr || flush_pending(*file).has_value();
+
+    std::size_t erased{0};
+    {
+        std::lock_guard<std::mutex> lock{handles_mutex};
+        const auto id = sftp_handle(sftp_server_session.get(), msg->handle);
+
+        pending_writes.erase(id);
+        erased = open_file_handles.erase(id);
+        erased += open_dir_handles.erase(id);
+        if (erased != 0)
+            sftp_handle_remove(sftp_server_session.get(), id);
+    }
 
-    auto erased = open_file_handles.erase(id);
-    erased += open_dir_handles.erase(id);
     if (erased == 0)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-        return reply_bad_handle(msg, "close");
+        return reply(reply_bad_handle, msg, "close");
     }
 
-    sftp_handle_remove(sftp_server_session.get(), id);
-    return reply_ok(msg);
+    if (!flushed)
+        return reply(reply_failure, msg);
+
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_fstat(sftp_client_message msg)
@@ -491,16 +1189,20 @@ int mp::SftpServer::handle_fstat(sftp_client_message msg)
     if (file == nullptr)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-        return reply_bad_handle(msg, "fstat");
+        return reply(reply_bad_handle, msg, "fstat");
     }
 
+    const auto file_lock = flush_pending(*file);
+    if (!file_lock)
+        return reply(reply_failure, msg);
+
     QFileInfo file_info(*file);
 
     if (file_info.isSymLink())
         file_info = QFileInfo(file_info.symLinkTarget());
 
     auto attr = attr_from(file_info);
-    return sftp_reply_attr(msg, &attr);
+    return reply(sftp_reply_attr, msg, &attr);
 }
 
 int mp::SftpServer::handle_mkdir(sftp_client_message msg)
@@ -511,14 +1213,16 @@ int mp::SftpServer::handle_mkdir(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     QDir dir(filename);
-    if (!dir.mkdir(filename))
+    const auto created = dir.mkdir(filename);
+    invalidate_cached(filename);
+    if (!created)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: mkdir failed for \'{}\'", __FUNCTION__, filename));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
     QFile file(filename);
@@ -526,7 +1230,7 @@ int mp::SftpServer::handle_mkdir(sftp_client_message msg)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: set permissions failed for \'{}\'", __FUNCTION__, filename));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
     QFileInfo current_dir(filename);
@@ -538,9 +1242,9 @@ int mp::SftpServer::handle_mkdir(sftp_client_message msg)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("failed to chown '{}' to owner:{} and group:{}", filename, rev_uid, rev_gid));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_rmdir(sftp_client_message msg)
@@ -551,17 +1255,19 @@ int mp::SftpServer::handle_rmdir(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     QDir dir(filename);
-    if (!MP_FILEOPS.rmdir(dir, filename))
+    const auto removed = MP_FILEOPS.rmdir(dir, filename);
+    invalidate_cached(filename);
+    if (!removed)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: rmdir failed for \'{}\'", __FUNCTION__, filename));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_open(sftp_client_message msg)
@@ -572,7 +1278,7 @@ int mp::SftpServer::handle_open(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     QIODevice::OpenMode mode{QIODevice::NotOpen};
@@ -604,10 +1310,14 @@ int mp::SftpServer::handle_open(sftp_client_message msg)
 
     auto exists = QFileInfo(filename).isSymLink() || file->exists();
 
-    if (!MP_FILEOPS.open(*file, mode))
+    const auto opened = MP_FILEOPS.open(*file, mode);
+    if (mode & (QIODevice::WriteOnly | QIODevice::Truncate))
+        invalidate_cached(filename);
+
+    if (!opened)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("Cannot open \'{}\': {}", filename, file->errorString()));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
     if (!exists)
@@ -616,7 +1326,7 @@ int mp::SftpServer::handle_open(sftp_client_message msg)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("Cannot set permissions for \'{}\': {}", filename, file->errorString()));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
 
         QFileInfo current_file(filename);
@@ -629,20 +1339,28 @@ int mp::SftpServer::handle_open(sftp_client_message msg)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("failed to chown '{}' to owner:{} and group:{}", filename, new_uid, new_gid));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
+        }
+    }
+
+    SftpHandleUPtr sftp_handle{nullptr, ssh_string_free};
+    {
+        std::lock_guard<std::mutex> lock{handles_mutex};
+        sftp_handle.reset(sftp_handle_alloc(sftp_server_session.get(), file.get()));
+        if (sftp_handle)
+        {
+            pending_writes.emplace(file.get(), std::make_shared<PendingWrite>());
+            open_file_handles.emplace(file.get(), std::move(file));
         }
     }
 
-    SftpHandleUPtr sftp_handle{sftp_handle_alloc(sftp_server_session.get(), file.get()), ssh_string_free};
     if (!sftp_handle)
     {
         mpl::log(mpl::Level::trace, category, "Cannot allocate handle for open()");
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    open_file_handles.emplace(file.get(), std::move(file));
-
-    return sftp_reply_handle(msg, sftp_handle.get());
+    return reply(sftp_reply_handle, msg, sftp_handle.get());
 }
 
 int mp::SftpServer::handle_opendir(sftp_client_message msg)
@@ -653,35 +1371,51 @@ int mp::SftpServer::handle_opendir(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
-    QDir dir(filename);
-    if (!dir.exists())
+    auto open_dir = std::make_unique<OpenDir>();
+    if (attr_cache)
+        open_dir->entries = attr_cache->find_listing(filename);
+
+    if (!open_dir->entries)
     {
-        mpl::log(mpl::Level::trace, category, fmt::format("Cannot open directory \'{}\': no such directory", filename));
-        return sftp_reply_status(msg, SSH_FX_NO_SUCH_FILE, "no such directory");
+        QDir dir(filename);
+        if (!dir.exists())
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("Cannot open directory \'{}\': no such directory", filename));
+            return reply(sftp_reply_status, msg, SSH_FX_NO_SUCH_FILE, "no such directory");
+        }
+
+        if (!MP_FILEOPS.isReadable(dir))
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("Cannot read directory \'{}\': permission denied", filename));
+            return reply(reply_perm_denied, msg);
+        }
+
+        auto generation = attr_cache ? attr_cache->watch(filename) : std::nullopt;
+        open_dir->entries = entries_for(dir);
+        if (generation)
+            attr_cache->insert_listing(filename, open_dir->entries, *generation);
     }
 
-    if (!MP_FILEOPS.isReadable(dir))
+    SftpHandleUPtr sftp_handle{nullptr, ssh_string_free};
     {
-        mpl::log(mpl::Level::trace, category, fmt::format("Cannot read directory \'{}\': permission denied", filename));
-        return reply_perm_denied(msg);
+        std::lock_guard<std::mutex> lock{handles_mutex};
+        sftp_handle.reset(sftp_handle_alloc(sftp_server_session.get(), open_dir.get()));
+        if (sftp_handle)
+            open_dir_handles.emplace(open_dir.get(), std::move(open_dir));
     }
 
-    auto entry_list =
-        std::make_unique<QFileInfoList>(dir.entryInfoList(QDir::AllEntries | QDir::System | QDir::Hidden));
-
-    SftpHandleUPtr sftp_handle{sftp_handle_alloc(sftp_server_session.get(), entry_list.get()), ssh_string_free};
     if (!sftp_handle)
     {
         mpl::log(mpl::Level::trace, category, "Cannot allocate handle for opendir()");
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    open_dir_handles.emplace(entry_list.get(), std::move(entry_list));
-
-    return sftp_reply_handle(msg, sftp_handle.get());
+    return reply(sftp_reply_handle, msg, sftp_handle.get());
 }
 
 int mp::SftpServer::handle_read(sftp_client_message msg)
@@ -690,20 +1424,49 @@ int mp::SftpServer::handle_read(sftp_client_message msg)
     if (file == nullptr)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-        return reply_bad_handle(msg, "read");
+        return reply(reply_bad_handle, msg, "read");
     }
 
-    const auto max_packet_size = 65536u;
-    const auto len = std::min(msg->len, max_packet_size);
+    const auto file_lock = flush_pending(*file);
+    if (!file_lock)
+        return reply(reply_failure, msg);
+
+    const auto len = std::min(msg->len, max_read_length);
+
+    // Reused across requests served by this thread, so large sequential reads don't allocate each time
+    thread_local std::vector<char> data;
+    if (data.size() < len)
+        data.resize(len);
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+    // Read straight from the file descriptor at the requested offset when there is one, skipping the separate seek
+    if (const auto fd = file->handle(); fd >= 0)
+    {
+        ssize_t r;
+        do
+        {
+            r = ::pread(fd, data.data(), len, msg->offset);
+        } while (r < 0 && errno == EINTR);
+
+        if (r < 0)
+        {
+            const auto error = std::strerror(errno);
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("{}: read failed for {}: {}", __FUNCTION__, file->fileName(), error));
+            return reply(sftp_reply_status, msg, SSH_FX_FAILURE, error);
+        }
+        else if (r == 0)
+            return reply(sftp_reply_status, msg, SSH_FX_EOF, "End of file");
 
-    std::vector<char> data;
-    data.reserve(len);
+        return reply(sftp_reply_data, msg, data.data(), r);
+    }
+#endif
 
     if (!MP_FILEOPS.seek(*file, msg->offset))
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: cannot seek to position {} in \'{}\'", __FUNCTION__, msg->offset, file->fileName()));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
     auto r = MP_FILEOPS.read(*file, data.data(), len);
@@ -711,49 +1474,44 @@ int mp::SftpServer::handle_read(sftp_client_message msg)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: read failed for {}: {}", __FUNCTION__, file->fileName(), file->errorString()));
-        return sftp_reply_status(msg, SSH_FX_FAILURE, file->errorString().toStdString().c_str());
+        return reply(sftp_reply_status, msg, SSH_FX_FAILURE, file->errorString().toStdString().c_str());
     }
     else if (r == 0)
-        return sftp_reply_status(msg, SSH_FX_EOF, "End of file");
+        return reply(sftp_reply_status, msg, SSH_FX_EOF, "End of file");
 
-    return sftp_reply_data(msg, data.data(), r);
+    return reply(sftp_reply_data, msg, data.data(), r);
 }
 
 int mp::SftpServer::handle_readdir(sftp_client_message msg)
 {
-    auto dir_entries = handle_from(msg, open_dir_handles);
-    if (dir_entries == nullptr)
+    auto open_dir = handle_from(msg, open_dir_handles);
+    if (open_dir == nullptr)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-        return reply_bad_handle(msg, "readdir");
+        return reply(reply_bad_handle, msg, "readdir");
     }
 
-    if (dir_entries->empty())
-        return sftp_reply_status(msg, SSH_FX_EOF, nullptr);
+    const auto& entries = *open_dir->entries;
+    if (open_dir->position >= entries.size())
+        return reply(sftp_reply_status, msg, SSH_FX_EOF, nullptr);
 
-    const auto max_num_entries_per_packet = 50;
-    const auto num_entries = std::min(dir_entries->size(), max_num_entries_per_packet);
+    // Pack as many entries as fit in one reply, unless asked to send fewer; there's always room for one
+    const auto max_entries = options.readdir_max_entries ? options.readdir_max_entries : entries.size();
+    std::size_t num_entries{0}, reply_length{0};
 
-    for (int i = 0; i < num_entries; i++)
+    for (; open_dir->position < entries.size() && num_entries < max_entries; ++open_dir->position, ++num_entries)
     {
-        const QFileInfo entry = dir_entries->takeFirst();
-        const auto filename = entry.fileName().toStdString();
-        sftp_attributes_struct attr{};
-        if (entry.isSymLink())
-        {
-            mp::platform::symlink_attr_from(entry.absoluteFilePath().toStdString().c_str(), &attr);
-            attr.uid = mapped_uid_for(attr.uid);
-            attr.gid = mapped_gid_for(attr.gid);
-        }
-        else
-        {
-            attr = attr_from(entry);
-        }
-        const auto longname = longname_from(entry, filename);
-        sftp_reply_names_add(msg, filename.c_str(), longname.data(), &attr);
+        const auto& entry = entries[open_dir->position];
+
+        reply_length += encoded_length(entry);
+        if (num_entries > 0 && reply_length > max_names_length)
+            break;
+
+        auto attr = entry.attr;
+        sftp_reply_names_add(msg, entry.filename.c_str(), entry.longname.c_str(), &attr);
     }
 
-    return sftp_reply_names(msg);
+    return reply(sftp_reply_names, msg);
 }
 
 int mp::SftpServer::handle_readlink(sftp_client_message msg)
@@ -764,19 +1522,19 @@ int mp::SftpServer::handle_readlink(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     auto link = QFile::symLinkTarget(filename);
     if (link.isEmpty())
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: invalid link for \'{}\'", __FUNCTION__, filename));
-        return sftp_reply_status(msg, SSH_FX_NO_SUCH_FILE, "invalid link");
+        return reply(sftp_reply_status, msg, SSH_FX_NO_SUCH_FILE, "invalid link");
     }
 
     sftp_attributes_struct attr{};
     sftp_reply_names_add(msg, link.toStdString().c_str(), link.toStdString().c_str(), &attr);
-    return sftp_reply_names(msg);
+    return reply(sftp_reply_names, msg);
 }
 
 int mp::SftpServer::handle_realpath(sftp_client_message msg)
@@ -787,11 +1545,11 @@ int mp::SftpServer::handle_realpath(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     auto realpath = QFileInfo(filename).absoluteFilePath();
-    return sftp_reply_name(msg, realpath.toStdString().c_str(), nullptr);
+    return reply(sftp_reply_name, msg, realpath.toStdString().c_str(), nullptr);
 }
 
 int mp::SftpServer::handle_remove(sftp_client_message msg)
@@ -802,17 +1560,19 @@ int mp::SftpServer::handle_remove(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     QFile file{filename};
-    if (!MP_FILEOPS.remove(file))
+    const auto removed = MP_FILEOPS.remove(file);
+    invalidate_cached(filename);
+    if (!removed)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: cannot remove \'{}\'", __FUNCTION__, filename));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_rename(sftp_client_message msg)
@@ -823,14 +1583,14 @@ int mp::SftpServer::handle_rename(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, source, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     if (!QFileInfo(source).isSymLink() && !QFile::exists(source))
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: cannot rename \'{}\': no such file", __FUNCTION__, source));
-        return sftp_reply_status(msg, SSH_FX_NO_SUCH_FILE, "no such file");
+        return reply(sftp_reply_status, msg, SSH_FX_NO_SUCH_FILE, "no such file");
     }
 
     const auto target = sftp_client_message_get_data(msg);
@@ -839,7 +1599,7 @@ int mp::SftpServer::handle_rename(sftp_client_message msg)
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: cannot validate target path \'{}\' against source \'{}\'", __FUNCTION__, target,
                              source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
     QFile target_file{target};
@@ -849,19 +1609,22 @@ int mp::SftpServer::handle_rename(sftp_client_message msg)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: cannot remove \'{}\' for renaming", __FUNCTION__, target));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
     }
 
     QFile source_file{source};
-    if (!MP_FILEOPS.rename(source_file, target))
+    const auto renamed = MP_FILEOPS.rename(source_file, target);
+    invalidate_cached(source);
+    invalidate_cached(target);
+    if (!renamed)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: failed renaming \'{}\' to \'{}\'", __FUNCTION__, source, target));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_setstat(sftp_client_message msg)
@@ -874,10 +1637,12 @@ int mp::SftpServer::handle_setstat(sftp_client_message msg)
         if (handle == nullptr)
         {
             mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-            return reply_bad_handle(msg, "setstat");
+            return reply(reply_bad_handle, msg, "setstat");
         }
 
         filename = handle->fileName();
+        if (!flush_pending(*handle))
+            return reply(reply_failure, msg);
     }
     else
     {
@@ -887,25 +1652,30 @@ int mp::SftpServer::handle_setstat(sftp_client_message msg)
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename,
                                  source_path));
-            return reply_perm_denied(msg);
+            return reply(reply_perm_denied, msg);
         }
 
         if (!QFileInfo(filename).isSymLink() && !QFile::exists(filename))
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: cannot setstat \'{}\': no such file", __FUNCTION__, filename));
-            return sftp_reply_status(msg, SSH_FX_NO_SUCH_FILE, "no such file");
+            return reply(sftp_reply_status, msg, SSH_FX_NO_SUCH_FILE, "no such file");
         }
+
+        // Buffered writes would otherwise land after a truncation or undo new times
+        if (!flush_pending(filename))
+            return reply(reply_failure, msg);
     }
 
     QFile file{filename};
+    invalidate_cached(filename);
 
     if (msg->attr->flags & SSH_FILEXFER_ATTR_SIZE)
     {
         if (!MP_FILEOPS.resize(file, msg->attr->size))
         {
             mpl::log(mpl::Level::trace, category, fmt::format("{}: cannot resize \'{}\'", __FUNCTION__, filename));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
     }
 
@@ -915,7 +1685,7 @@ int mp::SftpServer::handle_setstat(sftp_client_message msg)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: set permissions failed for \'{}\'", __FUNCTION__, filename));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
     }
 
@@ -925,7 +1695,7 @@ int mp::SftpServer::handle_setstat(sftp_client_message msg)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: cannot set modification date for \'{}\'", __FUNCTION__, filename));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
     }
 
@@ -935,10 +1705,10 @@ int mp::SftpServer::handle_setstat(sftp_client_message msg)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: cannot set ownership for \'{}\'", __FUNCTION__, filename));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_stat(sftp_client_message msg, const bool follow)
@@ -949,34 +1719,32 @@ int mp::SftpServer::handle_stat(sftp_client_message msg, const bool follow)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, filename, source_path));
-        return reply_perm_denied(msg);
-    }
-
-    QFileInfo file_info(filename);
-    if (!file_info.isSymLink() && !file_info.exists())
-    {
-        mpl::log(mpl::Level::trace, category,
-                 fmt::format("{}: cannot stat  \'{}\': no such file", __FUNCTION__, filename));
-        return sftp_reply_status(msg, SSH_FX_NO_SUCH_FILE, "no such file");
+        return reply(reply_perm_denied, msg);
     }
 
-    sftp_attributes_struct attr{};
+    // Buffered writes would otherwise not show in the size and times
+    if (!flush_pending(QString{filename}))
+        return reply(reply_failure, msg);
 
-    if (!follow && file_info.isSymLink())
+    auto stat = attr_cache ? attr_cache->find_stat(filename, follow) : std::nullopt;
+    if (!stat)
     {
-        mp::platform::symlink_attr_from(filename, &attr);
-        attr.uid = mapped_uid_for(attr.uid);
-        attr.gid = mapped_gid_for(attr.gid);
+        auto generation = attr_cache ? attr_cache->watch(QFileInfo(filename).path().toStdString()) : std::nullopt;
+        stat = stat_for(filename, follow);
+
+        // Whatever a followed link points to can change without any notification for the link's directory
+        if (generation && !(follow && QFileInfo(filename).isSymLink()))
+            attr_cache->insert_stat(filename, follow, *stat, *generation);
     }
-    else
-    {
-        if (file_info.isSymLink())
-            file_info = QFileInfo(file_info.symLinkTarget());
 
-        attr = attr_from(file_info);
+    if (!stat->exists)
+    {
+        mpl::log(mpl::Level::trace, category,
+                 fmt::format("{}: cannot stat  \'{}\': no such file", __FUNCTION__, filename));
+        return reply(sftp_reply_status, msg, SSH_FX_NO_SUCH_FILE, "no such file");
     }
 
-    return sftp_reply_attr(msg, &attr);
+    return reply(sftp_reply_attr, msg, &stat->attr);
 }
 
 int mp::SftpServer::handle_symlink(sftp_client_message msg)
@@ -989,17 +1757,19 @@ int mp::SftpServer::handle_symlink(sftp_client_message msg)
         mpl::log(
             mpl::Level::trace, category,
             fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, new_name, source_path));
-        return reply_perm_denied(msg);
+        return reply(reply_perm_denied, msg);
     }
 
-    if (!MP_PLATFORM.symlink(old_name, new_name, QFileInfo(old_name).isDir()))
+    const auto linked = MP_PLATFORM.symlink(old_name, new_name, QFileInfo(old_name).isDir());
+    invalidate_cached(new_name);
+    if (!linked)
     {
         mpl::log(mpl::Level::trace, category,
                  fmt::format("{}: failure creating symlink from \'{}\' to \'{}\'", __FUNCTION__, old_name, new_name));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_write(sftp_client_message msg)
@@ -1008,36 +1778,38 @@ int mp::SftpServer::handle_write(sftp_client_message msg)
     if (file == nullptr)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
-        return reply_bad_handle(msg, "write");
+        return reply(reply_bad_handle, msg, "write");
     }
 
-    auto len = ssh_string_len(msg->data);
-    auto data_ptr = ssh_string_get_char(msg->data);
-    if (!MP_FILEOPS.seek(*file, msg->offset))
-    {
-        mpl::log(mpl::Level::trace, category,
-                 fmt::format("{}: cannot seek to position {} in \'{}\'", __FUNCTION__, msg->offset, file->fileName()));
-        return reply_failure(msg);
-    }
+    const auto len = ssh_string_len(msg->data);
+    const auto data_ptr = ssh_string_get_char(msg->data);
 
-    do
+    // Requests on paths may write out the buffered data meanwhile, so the file is only used under the lock
+    auto pending = pending_for(*file);
+    std::unique_lock<std::mutex> file_lock;
+    if (pending != nullptr)
     {
-        auto r = MP_FILEOPS.write(*file, data_ptr, len);
-        if (r < 0)
+        file_lock = std::unique_lock<std::mutex>{pending->mutex};
+
+        // Errors writing out earlier data are reported here, NFS-style, as the requests they belong to were acked
+        const auto adjacent = msg->offset == pending->offset + pending->data.size();
+        if ((!adjacent || pending->data.size() + len > options.write_behind_bytes) && !write_out(*file, *pending))
+            return reply(reply_failure, msg);
+
+        if (len < options.write_behind_bytes && (file->openMode() & QIODevice::WriteOnly))
         {
-            mpl::log(
-                mpl::Level::trace, category,
-                fmt::format("{}: write failed for \'{}\': {}", __FUNCTION__, file->fileName(), file->errorString()));
-            return reply_failure(msg);
-        }
+            if (pending->data.empty())
+                pending->offset = msg->offset;
 
-        file->flush();
+            pending->data.insert(pending->data.end(), data_ptr, data_ptr + len);
+            return reply(reply_ok, msg);
+        }
+    }
 
-        data_ptr += r;
-        len -= r;
-    } while (len > 0);
+    if (!write_at(*file, msg->offset, data_ptr, len))
+        return reply(reply_failure, msg);
 
-    return reply_ok(msg);
+    return reply(reply_ok, msg);
 }
 
 int mp::SftpServer::handle_extended(sftp_client_message msg)
@@ -1046,7 +1818,7 @@ int mp::SftpServer::handle_extended(sftp_client_message msg)
     if (submessage == nullptr)
     {
         mpl::log(mpl::Level::trace, category, fmt::format("{}: invalid submesage requested", __FUNCTION__));
-        return reply_failure(msg);
+        return reply(reply_failure, msg);
     }
 
     const std::string method(submessage);
@@ -1060,25 +1832,337 @@ int mp::SftpServer::handle_extended(sftp_client_message msg)
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__, new_name,
                                  source_path));
-            return reply_perm_denied(msg);
+            return reply(reply_perm_denied, msg);
         }
 
-        if (!MP_PLATFORM.link(old_name, new_name))
+        const auto linked = MP_PLATFORM.link(old_name, new_name);
+        invalidate_cached(new_name);
+        if (!linked)
         {
             mpl::log(mpl::Level::trace, category,
                      fmt::format("{}: failed creating link from \'{}\' to \'{}\'", __FUNCTION__, old_name, new_name));
-            return reply_failure(msg);
+            return reply(reply_failure, msg);
         }
     }
     else if (method == "posix-rename@openssh.com")
     {
         return handle_rename(msg);
     }
+    else if (method == "fsync@openssh.com")
+    {
+        return handle_fsync(msg);
+    }
+    else if (method == "statvfs@openssh.com" || method == "fstatvfs@openssh.com")
+    {
+        return handle_statvfs(msg, method == "fstatvfs@openssh.com");
+    }
+    else if (method == "copy-data")
+    {
+        return handle_copy_data(msg);
+    }
     else
     {
         mpl::log(mpl::Level::trace, category, fmt::format("Unhandled extended method requested: {}", method));
-        return reply_unsupported(msg);
+        return reply(reply_unsupported, msg);
+    }
+
+    return reply(reply_ok, msg);
+}
+
+int mp::SftpServer::handle_fsync(sftp_client_message msg)
+{
+    const auto handle = ExtendedPayload{msg}.handle();
+    auto file = handle_from(msg, handle.get(), open_file_handles);
+    if (file == nullptr)
+    {
+        mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
+        return reply(reply_bad_handle, msg, "fsync");
+    }
+
+    const auto file_lock = flush_pending(*file);
+    if (!file_lock || !file->flush())
+        return reply(reply_failure, msg);
+
+#ifdef MULTIPASS_PLATFORM_WINDOWS
+    const auto synced = _commit(file->handle()) == 0;
+#else
+    const auto synced = ::fsync(file->handle()) == 0;
+#endif
+    if (!synced)
+    {
+        mpl::log(mpl::Level::trace, category,
+                 fmt::format("{}: cannot sync \'{}\': {}", __FUNCTION__, file->fileName(), std::strerror(errno)));
+        return reply(reply_failure, msg);
+    }
+
+    return reply(reply_ok, msg);
+}
+
+int mp::SftpServer::handle_statvfs(sftp_client_message msg, const bool by_handle)
+{
+#ifdef MULTIPASS_PLATFORM_WINDOWS
+    mpl::log(mpl::Level::trace, category, fmt::format("{}: not supported on this platform", __FUNCTION__));
+    return reply(reply_unsupported, msg);
+#else
+    ExtendedPayload payload{msg};
+    struct statvfs st
+    {
+    };
+    int ret{-1};
+
+    if (by_handle)
+    {
+        const auto handle = payload.handle();
+        auto file = handle_from(msg, handle.get(), open_file_handles);
+        if (file == nullptr)
+        {
+            mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
+            return reply(reply_bad_handle, msg, "fstatvfs");
+        }
+
+        ret = ::fstatvfs(file->handle(), &st);
+    }
+    else
+    {
+        auto path = payload.string();
+        if (!path || !validate_path(source_path, *path))
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("{}: cannot validate path \'{}\' against source \'{}\'", __FUNCTION__,
+                                 path.value_or(""), source_path));
+            return reply(reply_perm_denied, msg);
+        }
+
+        ret = ::statvfs(path->c_str(), &st);
+    }
+
+    if (ret < 0)
+    {
+        mpl::log(mpl::Level::trace, category,
+                 fmt::format("{}: statvfs failed: {}", __FUNCTION__, std::strerror(errno)));
+        return reply(reply_failure, msg);
+    }
+
+    // Laid out as in OpenSSH's PROTOCOL file
+    const uint64_t read_only = 0x1, no_suid = 0x2;
+    std::vector<unsigned char> data;
+    append_u64(data, st.f_bsize);
+    append_u64(data, st.f_frsize);
+    append_u64(data, st.f_blocks);
+    append_u64(data, st.f_bfree);
+    append_u64(data, st.f_bavail);
+    append_u64(data, st.f_files);
+    append_u64(data, st.f_ffree);
+    append_u64(data, st.f_favail);
+    append_u64(data, st.f_fsid);
+    append_u64(data, ((st.f_flag & ST_RDONLY) ? read_only : 0) | ((st.f_flag & ST_NOSUID) ? no_suid : 0));
+    append_u64(data, st.f_namemax);
+
+    return reply(reply_extended, msg, data);
+#endif
+}
+
+int mp::SftpServer::handle_copy_data(sftp_client_message msg)
+{
+    ExtendedPayload payload{msg};
+    const auto read_handle = payload.handle();
+    const auto read_offset = payload.u64();
+    const auto read_length = payload.u64();
+    const auto write_handle = payload.handle();
+    const auto write_offset = payload.u64();
+
+    if (!write_offset)
+    {
+        mpl::log(mpl::Level::trace, category, fmt::format("{}: malformed request", __FUNCTION__));
+        return reply(sftp_reply_status, msg, SSH_FX_BAD_MESSAGE, "malformed copy-data request");
+    }
+
+    auto source = handle_from(msg, read_handle.get(), open_file_handles);
+    auto target = handle_from(msg, write_handle.get(), open_file_handles);
+    if (source == nullptr || target == nullptr)
+    {
+        mpl::log(mpl::Level::trace, category, fmt::format("{}: bad handle requested", __FUNCTION__));
+        return reply(reply_bad_handle, msg, "copy-data");
+    }
+
+    if (!(source->openMode() & QIODevice::ReadOnly) || !(target->openMode() & QIODevice::WriteOnly))
+    {
+        mpl::log(mpl::Level::trace, category,
+                 fmt::format("{}: cannot copy from \'{}\' to \'{}\' with their open modes", __FUNCTION__,
+                             source->fileName(), target->fileName()));
+        return reply(reply_perm_denied, msg);
+    }
+
+    // As with OpenSSH, copying within a file is only allowed between ranges that don't overlap
+    const auto end_of = [length = *read_length](uint64_t offset) {
+        const auto max = std::numeric_limits<uint64_t>::max();
+        return length == 0 || length > max - offset ? max : offset + length;
+    };
+    if (source == target && *read_offset < end_of(*write_offset) && *write_offset < end_of(*read_offset))
+    {
+        mpl::log(mpl::Level::trace, category, fmt::format("{}: overlapping ranges requested", __FUNCTION__));
+        return reply(reply_failure, msg);
+    }
+
+    // Another copy may go the opposite way, so both locks are taken at once
+    auto source_pending = pending_for(*source);
+    auto target_pending = source == target ? nullptr : pending_for(*target);
+    std::unique_lock<std::mutex> source_lock, target_lock;
+    if (source_pending)
+        source_lock = std::unique_lock<std::mutex>{source_pending->mutex, std::defer_lock};
+    if (target_pending)
+        target_lock = std::unique_lock<std::mutex>{target_pending->mutex, std::defer_lock};
+
+    if (source_pending && target_pending)
+        std::lock(source_lock, target_lock);
+    else if (source_pending)
+        source_lock.lock();
+    else if (target_pending)
+        target_lock.lock();
+
+    if ((source_pending && !write_out(*source, *source_pending)) ||
+        (target_pending && !write_out(*target, *target_pending)) ||
+        !copy_data(*source, *read_offset, *read_length, *target, *write_offset))
+        return reply(reply_failure, msg);
+
+    return reply(reply_ok, msg);
+}
+
+// A length of 0 copies everything up to the end of the source
+bool mp::SftpServer::copy_data(QFile& source, uint64_t source_offset, uint64_t length, QFile& target,
+                               uint64_t target_offset)
+{
+    const auto unbounded = length == 0;
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+    if (source.handle() >= 0 && target.handle() >= 0)
+    {
+#ifdef MULTIPASS_PLATFORM_LINUX
+        // The kernel moves the data without it ever reaching us, and filesystems that can will share extents
+        // (reflink) instead of copying them
+        auto copied = false;
+        auto remaining = length;
+        auto range_in = static_cast<loff_t>(source_offset);
+        auto range_out = static_cast<loff_t>(target_offset);
+
+        while (unbounded || remaining > 0)
+        {
+            const auto chunk = unbounded ? std::size_t{1} << 30 : static_cast<std::size_t>(remaining);
+            const auto r = ::copy_file_range(source.handle(), &range_in, target.handle(), &range_out, chunk, 0);
+            if (r < 0 && errno == EINTR)
+                continue;
+
+            // Not every filesystem (or pairing of them) supports it; start over with plain reads and writes
+            if (r < 0 && !copied && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+                break;
+
+            if (r < 0)
+            {
+                mpl::log(mpl::Level::trace, category,
+                         fmt::format("{}: copy from \'{}\' to \'{}\' failed: {}", __FUNCTION__, source.fileName(),
+                                     target.fileName(), std::strerror(errno)));
+                invalidate_cached(target.fileName());
+                return false;
+            }
+
+            copied = true;
+            if (r == 0)
+                break;
+
+            if (!unbounded)
+                remaining -= r;
+        }
+
+        if (copied)
+        {
+            invalidate_cached(target.fileName());
+            return true;
+        }
+#endif
+
+        auto in = static_cast<off_t>(source_offset);
+        auto out = static_cast<off_t>(target_offset);
+        thread_local std::vector<char> buffer(max_read_length);
+
+        while (unbounded || length > 0)
+        {
+            const auto chunk = unbounded ? buffer.size() : std::min<uint64_t>(length, buffer.size());
+            const auto r = ::pread(source.handle(), buffer.data(), chunk, in);
+            if (r < 0 && errno == EINTR)
+                continue;
+
+            if (r < 0)
+            {
+                mpl::log(mpl::Level::trace, category,
+                         fmt::format("{}: read failed for \'{}\': {}", __FUNCTION__, source.fileName(),
+                                     std::strerror(errno)));
+                return false;
+            }
+
+            if (r == 0)
+                break;
+
+            for (ssize_t written = 0; written < r;)
+            {
+                const auto w = ::pwrite(target.handle(), buffer.data() + written, r - written, out);
+                if (w < 0 && errno == EINTR)
+                    continue;
+
+                if (w < 0)
+                {
+                    mpl::log(mpl::Level::trace, category,
+                             fmt::format("{}: write failed for \'{}\': {}", __FUNCTION__, target.fileName(),
+                                         std::strerror(errno)));
+                    invalidate_cached(target.fileName());
+                    return false;
+                }
+
+                written += w;
+                out += w;
+            }
+
+            in += r;
+            if (!unbounded)
+                length -= r;
+        }
+
+        invalidate_cached(target.fileName());
+        return true;
+    }
+#endif
+
+    std::vector<char> buffer(max_read_length);
+    while (unbounded || length > 0)
+    {
+        const auto chunk = unbounded ? buffer.size() : std::min<uint64_t>(length, buffer.size());
+        if (!MP_FILEOPS.seek(source, source_offset))
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("{}: cannot seek to position {} in \'{}\'", __FUNCTION__, source_offset,
+                                 source.fileName()));
+            return false;
+        }
+
+        const auto r = MP_FILEOPS.read(source, buffer.data(), chunk);
+        if (r < 0)
+        {
+            mpl::log(mpl::Level::trace, category,
+                     fmt::format("{}: read failed for \'{}\': {}", __FUNCTION__, source.fileName(),
+                                 source.errorString()));
+            return false;
+        }
+
+        if (r == 0)
+            break;
+
+        if (!write_at(target, target_offset, buffer.data(), r))
+            return false;
+
+        source_offset += r;
+        target_offset += r;
+        if (!unbounded)
+            length -= r;
     }
 
-    return reply_ok(msg);
+    return true;
 }
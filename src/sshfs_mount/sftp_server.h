@@ -18,14 +18,23 @@
 #ifndef MULTIPASS_SFTP_SERVER_H
 #define MULTIPASS_SFTP_SERVER_H
 
+#include "sftp_attribute_cache.h"
+
 #include <multipass/id_mappings.h>
 #include <multipass/ssh/ssh_session.h>
+#include <multipass/sshfs_server_config.h>
 
+#include <libssh/callbacks.h>
 #include <libssh/sftp.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 
@@ -39,20 +48,64 @@ class SftpServer
 public:
     SftpServer(SSHSession&& ssh_session, const std::string& source, const std::string& target,
                const id_mappings& gid_mappings, const id_mappings& uid_mappings, int default_uid, int default_gid,
-               const std::string& sshfs_exec_line);
+               const std::string& sshfs_exec_line, const SftpServerOptions& options = {});
     SftpServer(SftpServer&& other);
     ~SftpServer();
 
     void run();
     void stop();
+    std::optional<SftpAttributeCache::Stats> attr_cache_stats() const;
 
     using SSHSessionUptr = std::unique_ptr<ssh_session_struct, decltype(ssh_free)*>;
     using SftpSessionUptr = std::unique_ptr<sftp_session_struct, decltype(sftp_free)*>;
     using SSHFSProcUptr = std::unique_ptr<SSHProcess>;
+    using MsgUPtr = std::unique_ptr<sftp_client_message_struct, decltype(sftp_client_message_free)*>;
 
 private:
+    struct Worker;
+    struct OpenDir
+    {
+        std::shared_ptr<const SftpDirEntries> entries;
+        std::size_t position{0};
+    };
+    struct PendingWrite
+    {
+        // Held by anyone using the file the data is for, as requests on paths can write it out at any time and
+        // copy-data writes to a file whose requests go to another worker
+        std::mutex mutex;
+        uint64_t offset{0};
+        std::vector<char> data;
+    };
+    // Closing the handle lets go of its pending write, so the lock comes with a reference keeping the mutex alive
+    struct FileLock
+    {
+        std::shared_ptr<PendingWrite> pending;
+        std::unique_lock<std::mutex> lock;
+    };
+
+    MsgUPtr read_message();
+    void dispatch(MsgUPtr msg);
+    void start_workers();
+    void stop_workers();
     void process_message(sftp_client_message msg);
+    template <typename T>
+    std::shared_ptr<T> handle_from(sftp_client_message msg,
+                                   const std::unordered_map<void*, std::shared_ptr<T>>& handles);
+    template <typename T>
+    std::shared_ptr<T> handle_from(sftp_client_message msg, ssh_string handle,
+                                   const std::unordered_map<void*, std::shared_ptr<T>>& handles);
+    template <typename Reply, typename... Args>
+    int reply(Reply&& send_reply, Args&&... args);
     sftp_attributes_struct attr_from(const QFileInfo& file_info);
+    SftpStat stat_for(const QString& filename, bool follow);
+    std::shared_ptr<const SftpDirEntries> entries_for(const QDir& dir);
+    void invalidate_cached(const QString& path);
+    bool write_at(QFile& file, uint64_t offset, const char* data, std::size_t len);
+    bool write_out(QFile& file, PendingWrite& pending);
+    std::shared_ptr<PendingWrite> pending_for(QFile& file);
+    std::optional<FileLock> flush_pending(QFile& file);
+    bool flush_pending(const QString& path);
+    bool copy_data(QFile& source, uint64_t source_offset, uint64_t length, QFile& target, uint64_t target_offset);
     int mapped_uid_for(const int uid);
     int mapped_gid_for(const int gid);
     int reverse_uid_for(const int uid, const int rev_uid_if_not_found);
@@ -75,20 +128,34 @@ private:
     int handle_symlink(sftp_client_message msg);
     int handle_write(sftp_client_message msg);
     int handle_extended(sftp_client_message msg);
+    int handle_fsync(sftp_client_message msg);
+    int handle_statvfs(sftp_client_message msg, bool by_handle);
+    int handle_copy_data(sftp_client_message msg);
 
     SSHSession ssh_session;
     SSHFSProcUptr sshfs_process;
     SftpSessionUptr sftp_server_session;
     const std::string source_path;
     const std::string target_path;
-    std::unordered_map<void*, std::unique_ptr<QFileInfoList>> open_dir_handles;
-    std::unordered_map<void*, std::unique_ptr<QFile>> open_file_handles;
+    // Shared with the requests using them, so that closing a handle leaves them to finish
+    std::unordered_map<void*, std::shared_ptr<OpenDir>> open_dir_handles;
+    std::unordered_map<void*, std::shared_ptr<QFile>> open_file_handles;
+    std::unordered_map<void*, std::shared_ptr<PendingWrite>> pending_writes;
     const id_mappings gid_mappings;
     const id_mappings uid_mappings;
     const int default_uid;
     const int default_gid;
     const std::string sshfs_exec_line;
-    bool stop_invoked{false};
+    const SftpServerOptions options;
+    std::unique_ptr<SftpAttributeCache> attr_cache;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::size_t next_worker{0};
+    std::mutex session_mutex;
+    // Messages that have arrived in full, so the reader can take them without waiting on the client
+    ssh_channel_callbacks_struct channel_callbacks{};
+    int complete_packets_buffered{0};
+    std::mutex handles_mutex;
+    std::atomic_bool stop_invoked{false};
 };
 } // namespace multipass
 #endif // MULTIPASS_SFTP_SERVER_H
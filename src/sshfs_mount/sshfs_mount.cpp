@@ -172,7 +172,8 @@ void set_owner_for(mp::SSHSession& session, const std::string& root, const std::
 }
 
 auto make_sftp_server(mp::SSHSession&& session, const std::string& source, const std::string& target,
-                      const mp::id_mappings& gid_mappings, const mp::id_mappings& uid_mappings)
+                      const mp::id_mappings& gid_mappings, const mp::id_mappings& uid_mappings,
+                      const mp::SftpServerOptions& options)
 {
     mpl::log(mpl::Level::debug, category,
              fmt::format("{}:{} {}(source = {}, target = {}, …): ", __FILE__, __LINE__, __FUNCTION__, source, target));
@@ -201,14 +202,15 @@ auto make_sftp_server(mp::SSHSession&& session, const std::string& source, const
     }
 
     return std::make_unique<mp::SftpServer>(std::move(session), source, leading + missing, gid_mappings, uid_mappings,
-                                            default_uid, default_gid, sshfs_exec_line);
+                                            default_uid, default_gid, sshfs_exec_line, options);
 }
 
 } // namespace
 
 mp::SshfsMount::SshfsMount(SSHSession&& session, const std::string& source, const std::string& target,
-                           const mp::id_mappings& gid_mappings, const mp::id_mappings& uid_mappings)
-    : sftp_server{make_sftp_server(std::move(session), source, target, gid_mappings, uid_mappings)},
+                           const mp::id_mappings& gid_mappings, const mp::id_mappings& uid_mappings,
+                           const SftpServerOptions& options)
+    : sftp_server{make_sftp_server(std::move(session), source, target, gid_mappings, uid_mappings, options)},
       sftp_thread{[this]() {
           mp::top_catch_all(category, [this] {
               std::cout << "Connected" << std::endl;
@@ -19,6 +19,7 @@
 #define MULTIPASS_SSHFS_MOUNT
 
 #include <multipass/id_mappings.h>
+#include <multipass/sshfs_server_config.h>
 
 #include <memory>
 #include <thread>
@@ -32,7 +33,8 @@ class SshfsMount
 {
 public:
     SshfsMount(SSHSession&& session, const std::string& source, const std::string& target,
-               const id_mappings& gid_mappings, const id_mappings& uid_mappings);
+               const id_mappings& gid_mappings, const id_mappings& uid_mappings,
+               const SftpServerOptions& options = {});
     SshfsMount(SshfsMount&& other);
     ~SshfsMount();
 
@@ -69,6 +69,30 @@ mp::id_mappings convert_id_mappings(const char* in)
 
     return ret_map;
 }
+
+mp::SftpServerOptions sftp_server_options_from_env()
+{
+    mp::SftpServerOptions options;
+
+    bool ok;
+    const auto workers = qEnvironmentVariableIntValue("MULTIPASS_SFTP_WORKERS", &ok);
+    if (ok && workers >= 0)
+        options.worker_threads = workers;
+
+    const auto cache_entries = qEnvironmentVariableIntValue("MULTIPASS_SFTP_ATTR_CACHE_SIZE", &ok);
+    if (ok && cache_entries >= 0)
+        options.attr_cache_entries = cache_entries;
+
+    const auto readdir_entries = qEnvironmentVariableIntValue("MULTIPASS_SFTP_READDIR_ENTRIES", &ok);
+    if (ok && readdir_entries >= 0)
+        options.readdir_max_entries = readdir_entries;
+
+    const auto write_behind = qEnvironmentVariableIntValue("MULTIPASS_SFTP_WRITE_BEHIND_SIZE", &ok);
+    if (ok && write_behind >= 0)
+        options.write_behind_bytes = write_behind;
+
+    return options;
+}
 } // namespace
 
 int main(int argc, char* argv[])
@@ -108,7 +132,8 @@ int main(int argc, char* argv[])
         auto watchdog = mpp::make_quit_watchdog(); // called while there is only one thread
 
         mp::SSHSession session{host, port, username, mp::SSHClientKeyProvider{priv_key_blob}};
-        mp::SshfsMount sshfs_mount(move(session), source_path, target_path, gid_mappings, uid_mappings);
+        mp::SshfsMount sshfs_mount(move(session), source_path, target_path, gid_mappings, uid_mappings,
+                                   sftp_server_options_from_env());
 
         // ssh lives on its own thread, use this thread to listen for quit signal
         if (int sig = watchdog())
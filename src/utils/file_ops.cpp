@@ -184,6 +184,16 @@ fs::file_status mp::FileOps::status(const fs::path& path, std::error_code& err)
     return fs::status(path, err);
 }
 
+std::uintmax_t mp::FileOps::file_size(const fs::path& path, std::error_code& err) const
+{
+    return fs::file_size(path, err);
+}
+
+fs::file_time_type mp::FileOps::last_write_time(const fs::path& path, std::error_code& err) const
+{
+    return fs::last_write_time(path, err);
+}
+
 std::unique_ptr<mp::RecursiveDirIterator> mp::FileOps::recursive_dir_iterator(const fs::path& path,
                                                                               std::error_code& err) const
 {
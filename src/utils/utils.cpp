@@ -26,12 +26,14 @@
 #include <multipass/standard_paths.h>
 #include <multipass/utils.h>
 
+#include <QDeadlineTimer>
 #include <QDir>
 #include <QFileInfo>
 #include <QProcess>
 #include <QRegularExpression>
 #include <QStorageInfo>
 #include <QSysInfo>
+#include <QTcpSocket>
 #include <QUuid>
 #include <QtGlobal>
 
@@ -55,6 +57,13 @@ namespace
 {
 constexpr auto category = "utils";
 constexpr auto scrypt_hash_size{64};
+constexpr auto ssh_probe_timeout = 1s;
+constexpr auto ssh_probe_interval = 100ms;
+
+// Have cloud-init report when it is done, instead of checking for it over and over again. Versions that do not know
+// how to wait fail straight away, leaving a single check for the marker file.
+const std::string cloud_init_wait_cmd{
+    "cloud-init status --wait >/dev/null 2>&1; [ -e /var/lib/cloud/instance/boot-finished ]"};
 
 auto quote_for(const std::string& arg, mp::utils::QuoteType quote_type)
 {
@@ -142,16 +151,23 @@ void mp::Utils::make_file_with_content(const std::string& file_name, const std::
 void mp::Utils::wait_for_cloud_init(mp::VirtualMachine* virtual_machine, std::chrono::milliseconds timeout,
                                     const mp::SSHKeyProvider& key_provider) const
 {
-    auto action = [virtual_machine, &key_provider] {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto action = [virtual_machine, &key_provider, deadline] {
         virtual_machine->ensure_vm_is_running();
         try
         {
             mp::SSHSession session{virtual_machine->ssh_hostname(), virtual_machine->ssh_port(),
                                    virtual_machine->ssh_username(), key_provider};
 
-            std::lock_guard<decltype(virtual_machine->state_mutex)> lock{virtual_machine->state_mutex};
-            auto ssh_process = session.exec({"[ -e /var/lib/cloud/instance/boot-finished ]"});
-            return ssh_process.exit_code() == 0 ? mp::utils::TimeoutAction::done : mp::utils::TimeoutAction::retry;
+            auto ssh_process = [&session, virtual_machine] {
+                std::lock_guard<decltype(virtual_machine->state_mutex)> lock{virtual_machine->state_mutex};
+                return session.exec(cloud_init_wait_cmd);
+            }();
+
+            auto remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            return ssh_process.exit_code(std::max(remaining, 1ms)) == 0 ? mp::utils::TimeoutAction::done
+                                                                        : mp::utils::TimeoutAction::retry;
         }
         catch (const std::exception& e)
         {
@@ -164,6 +180,27 @@ void mp::Utils::wait_for_cloud_init(mp::VirtualMachine* virtual_machine, std::ch
     mp::utils::try_action_for(on_timeout, timeout, action);
 }
 
+bool mp::Utils::is_ssh_answering(const std::string& hostname, int port, std::chrono::milliseconds timeout) const
+{
+    QDeadlineTimer deadline{timeout.count()};
+    QTcpSocket socket;
+
+    socket.connectToHost(QString::fromStdString(hostname), port);
+    if (!socket.waitForConnected(deadline.remainingTime()))
+        return false;
+
+    // The server sends its identification string as soon as it accepts the connection, possibly after other lines
+    while (true)
+    {
+        while (!socket.canReadLine())
+            if (deadline.hasExpired() || !socket.waitForReadyRead(deadline.remainingTime()))
+                return false;
+
+        if (socket.readLine().startsWith("SSH-"))
+            return true;
+    }
+}
+
 std::string mp::Utils::get_kernel_version() const
 {
     return QSysInfo::kernelVersion().toStdString();
@@ -303,7 +340,10 @@ void mp::utils::wait_until_ssh_up(VirtualMachine* virtual_machine, std::chrono::
         ensure_vm_is_running();
         try
         {
-            mp::SSHSession session{virtual_machine->ssh_hostname(1ms), virtual_machine->ssh_port()};
+            // Seeing the server's identification string is enough, there is no need for a whole SSH handshake
+            if (!MP_UTILS.is_ssh_answering(virtual_machine->ssh_hostname(1ms), virtual_machine->ssh_port(),
+                                           ssh_probe_timeout))
+                return mp::utils::TimeoutAction::retry;
 
             std::lock_guard<decltype(virtual_machine->state_mutex)> lock{virtual_machine->state_mutex};
             virtual_machine->state = VirtualMachine::State::running;
@@ -322,7 +362,8 @@ void mp::utils::wait_until_ssh_up(VirtualMachine* virtual_machine, std::chrono::
         throw std::runtime_error(fmt::format("{}: timed out waiting for response", virtual_machine->vm_name));
     };
 
-    mp::utils::try_action_for(on_timeout, timeout, action);
+    // Probing is cheap and refused connections come back straight away, so retry often to notice sshd promptly
+    mp::utils::try_action_every(ssh_probe_interval, on_timeout, timeout, action);
 }
 
 // Executes a given command on the given session. Returns the output of the command, with spaces and feeds trimmed.
@@ -25,8 +25,54 @@
 
 #include <stdexcept>
 
+#ifdef MULTIPASS_PLATFORM_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(MULTIPASS_PLATFORM_APPLE)
+#include <sys/clonefile.h>
+#endif
+
 namespace mp = multipass;
 
+namespace
+{
+// Makes target share source's data where the filesystem allows (btrfs and XFS on Linux, APFS on macOS), so that only
+// what changes afterwards takes up space. Returns false, leaving nothing behind, when that isn't possible
+bool clone_file(const QString& source, const QString& target)
+{
+#ifdef MULTIPASS_PLATFORM_LINUX
+    const auto source_fd = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (source_fd < 0)
+        return false;
+
+    struct stat source_stat;
+    auto target_fd = -1;
+    if (fstat(source_fd, &source_stat) == 0)
+        target_fd = ::open(QFile::encodeName(target).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                           source_stat.st_mode & 07777);
+
+    const auto cloned = target_fd >= 0 && ioctl(target_fd, FICLONE, source_fd) == 0;
+
+    if (target_fd >= 0)
+    {
+        close(target_fd);
+        if (!cloned)
+            unlink(QFile::encodeName(target).constData());
+    }
+    close(source_fd);
+
+    return cloned;
+#elif defined(MULTIPASS_PLATFORM_APPLE)
+    return clonefile(QFile::encodeName(source).constData(), QFile::encodeName(target).constData(), 0) == 0;
+#else
+    return false;
+#endif
+}
+} // namespace
+
 QString mp::vault::filename_for(const mp::Path& path)
 {
     QFileInfo file_info(path);
@@ -44,7 +90,8 @@ QString mp::vault::copy(const QString& file_name, const QDir& output_dir)
     QFileInfo info{file_name};
     const auto source_name = info.fileName();
     auto new_path = output_dir.filePath(source_name);
-    QFile::copy(file_name, new_path);
+    if (!clone_file(file_name, new_path))
+        QFile::copy(file_name, new_path);
     return new_path;
 }
 
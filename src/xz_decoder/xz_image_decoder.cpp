@@ -21,12 +21,27 @@
 
 #include <multipass/format.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace mp = multipass;
 
 namespace
 {
+constexpr auto write_size = 4u * 1024 * 1024;
+// Zero runs at least this long are skipped over rather than written, leaving holes in the decoded file
+constexpr auto sparse_granularity = 4096u;
+constexpr auto stream_header_size = 12;
+constexpr auto stream_footer_size = 12;
+// Each worker may hold a whole compressed block, a 64 MiB dictionary and its output buffer, so more cores than this
+// would mostly add memory use; writing the image out soon becomes the bottleneck anyway
+constexpr auto max_decode_workers = 4u;
+
 bool verify_decode(const xz_ret& ret)
 {
     switch (ret)
@@ -52,64 +67,387 @@ bool verify_decode(const xz_ret& ret)
 
     return true;
 }
+
+bool all_zeros(const char* data, std::size_t size)
+{
+    return std::all_of(data, data + size, [](char c) { return c == 0; });
+}
+
+// Writes data at offset, skipping the aligned runs of zeros. The file must be sized beforehand, or after, for the
+// skipped parts to read back as zeros
+void write_sparse(QFile& file, qint64 offset, const char* data, std::size_t size)
+{
+    std::size_t pos = 0;
+    while (pos < size)
+    {
+        // Find the next stretch of data worth writing, in whole granules
+        auto start = pos;
+        while (start < size && all_zeros(data + start, std::min<std::size_t>(sparse_granularity, size - start)))
+            start += sparse_granularity;
+
+        if (start >= size)
+            return;
+
+        auto end = start;
+        while (end < size && !all_zeros(data + end, std::min<std::size_t>(sparse_granularity, size - end)))
+            end += sparse_granularity;
+        end = std::min(end, size);
+
+        const auto length = static_cast<qint64>(end - start);
+        if (!file.seek(offset + start) || file.write(data + start, length) != length)
+            throw std::runtime_error(fmt::format("failed to write to {}", file.fileName()));
+
+        pos = end;
+    }
+}
+
+// Reads an xz variable-length integer, returning false if it doesn't fit
+bool read_varint(const QByteArray& data, int& pos, qint64& value)
+{
+    value = 0;
+    for (auto shift = 0; shift < 63 && pos < data.size(); shift += 7)
+    {
+        const auto byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<qint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+void append_varint(QByteArray& data, qint64 value)
+{
+    while (value >= 0x80)
+    {
+        data.append(static_cast<char>(0x80 | (value & 0x7f)));
+        value >>= 7;
+    }
+    data.append(static_cast<char>(value));
+}
+
+quint32 read_u32(const char* data)
+{
+    const auto bytes = reinterpret_cast<const unsigned char*>(data);
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<quint32>(bytes[3]) << 24;
+}
+
+void append_u32(QByteArray& data, quint32 value)
+{
+    for (auto i = 0; i < 4; ++i)
+        data.append(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+quint32 crc32_of(const QByteArray& data)
+{
+    return xz_crc32(reinterpret_cast<const uint8_t*>(data.constData()), data.size(), 0);
+}
+
+// An index and footer describing nothing but the given block, so that it decodes as a complete stream of its own and
+// the decoder gets to verify the block's check
+QByteArray stream_trailer_for(qint64 unpadded_size, qint64 decoded_size, const QByteArray& stream_header)
+{
+    QByteArray index(1, '\0');
+    append_varint(index, 1);
+    append_varint(index, unpadded_size);
+    append_varint(index, decoded_size);
+    while (index.size() % 4)
+        index.append('\0');
+    append_u32(index, crc32_of(index));
+
+    QByteArray footer_fields;
+    append_u32(footer_fields, index.size() / 4 - 1);
+    footer_fields.append(stream_header.mid(6, 2));
+
+    QByteArray trailer{index};
+    append_u32(trailer, crc32_of(footer_fields));
+    trailer.append(footer_fields);
+    trailer.append("YZ");
+
+    return trailer;
+}
+
+// The decoder's CRC tables are global and must be filled in before any decoding
+void init_crc_tables()
+{
+    static std::once_flag once;
+    std::call_once(once, [] {
+        xz_crc32_init();
+        xz_crc64_init();
+    });
+}
 } // namespace
 
-mp::XzImageDecoder::XzImageDecoder(const Path& xz_file_path)
-    : xz_file{xz_file_path}, xz_decoder{xz_dec_init(XZ_DYNALLOC, 1u << 26), xz_dec_end}
+mp::XzImageDecoder::XzImageDecoder(const Path& xz_file_path) : xz_file{xz_file_path}
 {
-    xz_crc32_init();
-    xz_crc64_init();
+    init_crc_tables();
 }
 
 void mp::XzImageDecoder::decode_to(const Path& decoded_image_path, const ProgressMonitor& monitor)
 {
-    if (!xz_file.open(QIODevice::ReadOnly))
+    // Blocks can only be decoded independently of each other when there are several to begin with
+    if (const auto blocks = this->blocks(); blocks.size() > 1 && std::thread::hardware_concurrency() > 1)
+        decode_blocks_to(decoded_image_path, blocks, monitor);
+    else
+        decode_stream_to(decoded_image_path, monitor);
+}
+
+auto mp::XzImageDecoder::blocks() -> std::vector<Block>
+{
+    if (!xz_file.isOpen() && !xz_file.open(QIODevice::ReadOnly))
         throw std::runtime_error(fmt::format("failed to open {} for reading", xz_file.fileName()));
 
+    return read_blocks();
+}
+
+// Finds the blocks from the index at the end of the file. Anything other than a single plain stream yields no blocks
+std::vector<mp::XzImageDecoder::Block> mp::XzImageDecoder::read_blocks()
+{
+    const auto file_size = xz_file.size();
+    if (file_size < stream_header_size + stream_footer_size)
+        return {};
+
+    stream_header = xz_file.read(stream_header_size);
+    xz_file.seek(file_size - stream_footer_size);
+    const auto footer = xz_file.read(stream_footer_size);
+    if (stream_header.size() != stream_header_size || footer.size() != stream_footer_size || !footer.endsWith("YZ"))
+        return {};
+
+    const auto index_size = (static_cast<qint64>(read_u32(footer.constData() + 4)) + 1) * 4;
+    const auto index_offset = file_size - stream_footer_size - index_size;
+    if (index_offset < stream_header_size || !xz_file.seek(index_offset))
+        return {};
+
+    const auto index = xz_file.read(index_size);
+    auto pos = 1;
+    qint64 num_records;
+    if (index.size() != index_size || index[0] != 0 || !read_varint(index, pos, num_records))
+        return {};
+
+    std::vector<Block> blocks;
+    qint64 offset = stream_header_size, decoded_offset = 0;
+    for (qint64 i = 0; i < num_records; ++i)
+    {
+        qint64 unpadded_size, decoded_size;
+        if (!read_varint(index, pos, unpadded_size) || !read_varint(index, pos, decoded_size))
+            return {};
+
+        const auto size = (unpadded_size + 3) & ~qint64{3};
+        blocks.push_back({offset, size, unpadded_size, decoded_offset, decoded_size});
+        offset += size;
+        decoded_offset += decoded_size;
+    }
+
+    // Make sure the blocks account for everything between the header and the index
+    if (offset != index_offset)
+        return {};
+
+    return blocks;
+}
+
+void mp::XzImageDecoder::decode_blocks_to(const Path& decoded_image_path, const std::vector<Block>& blocks,
+                                          const ProgressMonitor& monitor)
+{
     QFile decoded_file{decoded_image_path};
-    if (!decoded_file.open(QIODevice::WriteOnly))
+    if (!decoded_file.open(QIODevice::WriteOnly) || !decoded_file.resize(blocks.back().decoded_offset +
+                                                                          blocks.back().decoded_size))
         throw std::runtime_error(fmt::format("failed to open {} for writing", decoded_file.fileName()));
+    decoded_file.close();
 
-    struct xz_buf decode_buf
-    {
+    std::mutex mutex;
+    std::condition_variable blocks_done;
+    std::size_t num_done{0};
+    std::exception_ptr error;
+    std::atomic_size_t next_block{0};
+
+    auto decode_blocks = [&] {
+        try
+        {
+            QFile input{xz_file.fileName()}, output{decoded_image_path};
+            if (!input.open(QIODevice::ReadOnly) || !output.open(QIODevice::ReadWrite))
+                throw std::runtime_error(fmt::format("failed to open {} for decoding", xz_file.fileName()));
+
+            XzDecoderUPtr xz_decoder{xz_dec_init(XZ_DYNALLOC, 1u << 26), xz_dec_end};
+            std::vector<char> decoded(write_size);
+
+            for (auto i = next_block++; i < blocks.size(); i = next_block++)
+            {
+                const auto& block = blocks[i];
+
+                // Each block goes in as a stream of its own, between a copy of the stream header and an index and
+                // footer made up for it
+                auto data = stream_header;
+                if (input.seek(block.offset))
+                    data += input.read(block.size);
+                if (data.size() != stream_header_size + block.size)
+                    throw std::runtime_error("xz file is truncated");
+                data += stream_trailer_for(block.unpadded_size, block.decoded_size, stream_header);
+
+                xz_dec_reset(xz_decoder.get());
+                struct xz_buf decode_buf
+                {
+                };
+                decode_buf.in = reinterpret_cast<const unsigned char*>(data.constData());
+                decode_buf.in_size = data.size();
+                decode_buf.out = reinterpret_cast<unsigned char*>(decoded.data());
+                decode_buf.out_size = decoded.size();
+
+                // Run until the end of the made up stream, even once all the data is out, so the check gets verified
+                qint64 written{0};
+                for (auto stream_ended = false; !stream_ended;)
+                {
+                    stream_ended = !verify_decode(xz_dec_run(xz_decoder.get(), &decode_buf));
+
+                    if (stream_ended || decode_buf.out_pos == decode_buf.out_size)
+                    {
+                        if (written + static_cast<qint64>(decode_buf.out_pos) > block.decoded_size)
+                            throw std::runtime_error("xz file is corrupt");
+
+                        write_sparse(output, block.decoded_offset + written, decoded.data(), decode_buf.out_pos);
+                        written += decode_buf.out_pos;
+                        decode_buf.out_pos = 0;
+                    }
+                    else if (decode_buf.in_pos == decode_buf.in_size)
+                    {
+                        throw std::runtime_error("xz file is corrupt");
+                    }
+                }
+
+                if (written != block.decoded_size)
+                    throw std::runtime_error("xz file is corrupt");
+
+                std::lock_guard<std::mutex> lock{mutex};
+                ++num_done;
+                blocks_done.notify_one();
+            }
+        }
+        catch (...)
+        {
+            next_block = blocks.size();
+
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!error)
+                error = std::current_exception();
+            blocks_done.notify_one();
+        }
     };
-    const auto max_size = 65536u;
 
-    std::vector<char> read_data, write_data;
-    read_data.reserve(max_size);
-    write_data.reserve(max_size);
+    std::vector<std::thread> workers;
+    const auto num_workers =
+        std::min<std::size_t>({std::thread::hardware_concurrency(), max_decode_workers, blocks.size()});
+    for (std::size_t i = 0; i < num_workers; ++i)
+        workers.emplace_back(decode_blocks);
 
-    decode_buf.in = reinterpret_cast<unsigned char*>(read_data.data());
-    decode_buf.in_pos = 0;
-    decode_buf.in_size = 0;
-    decode_buf.out = reinterpret_cast<unsigned char*>(write_data.data());
-    decode_buf.out_pos = 0;
-    decode_buf.out_size = max_size;
+    // Progress is reported from here, as the monitor isn't meant to be called from several threads
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        for (std::size_t reported = 0;;)
+        {
+            blocks_done.wait(lock, [&] { return num_done != reported || error; });
+            if (error || num_done == blocks.size())
+                break;
+
+            reported = num_done;
+            lock.unlock();
+            monitor(LaunchProgress::EXTRACT, 100 * reported / blocks.size());
+            lock.lock();
+        }
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    monitor(LaunchProgress::EXTRACT, 100);
+}
+
+void mp::XzImageDecoder::decode_stream_to(const Path& decoded_image_path, const ProgressMonitor& monitor)
+{
+    if (!xz_file.seek(0))
+        throw std::runtime_error(fmt::format("failed to read {}", xz_file.fileName()));
 
+    XzStreamDecoder decoder{decoded_image_path};
+
+    std::vector<char> read_data(write_size);
     const auto file_size = xz_file.size();
     qint64 total_bytes_extracted{0};
+    auto last_progress = -1;
 
     while (true)
     {
-        if (decode_buf.in_pos == decode_buf.in_size)
+        const auto bytes_read = xz_file.read(read_data.data(), read_data.size());
+        if (bytes_read <= 0)
+            break;
+
+        total_bytes_extracted += bytes_read;
+        if (const auto progress = static_cast<int>(total_bytes_extracted * 100 / file_size); progress != last_progress)
         {
-            decode_buf.in_size = xz_file.read(read_data.data(), max_size);
-            decode_buf.in_pos = 0;
-            total_bytes_extracted += decode_buf.in_size;
-            auto progress = (total_bytes_extracted / (float)file_size) * 100;
             monitor(LaunchProgress::EXTRACT, progress);
+            last_progress = progress;
         }
 
-        if (!verify_decode(xz_dec_run(xz_decoder.get(), &decode_buf)))
-        {
-            decoded_file.write(write_data.data(), decode_buf.out_pos);
-            return;
-        }
+        if (decoder.decode(read_data.data(), bytes_read))
+            break;
+    }
+
+    decoder.finish();
+}
+
+mp::XzStreamDecoder::XzStreamDecoder(const Path& decoded_file_path)
+    : decoded_file{decoded_file_path},
+      xz_decoder{xz_dec_init(XZ_DYNALLOC, 1u << 26), xz_dec_end},
+      write_data(write_size)
+{
+    init_crc_tables();
+
+    if (!decoded_file.open(QIODevice::WriteOnly))
+        throw std::runtime_error(fmt::format("failed to open {} for writing", decoded_file.fileName()));
+}
+
+bool mp::XzStreamDecoder::decode(const char* data, std::size_t size)
+{
+    if (stream_ended || size == 0)
+        return stream_ended;
 
-        if (decode_buf.out_pos == max_size)
+    struct xz_buf decode_buf
+    {
+    };
+
+    decode_buf.in = reinterpret_cast<const unsigned char*>(data);
+    decode_buf.in_pos = 0;
+    decode_buf.in_size = size;
+    decode_buf.out = write_data.data();
+    decode_buf.out_pos = 0;
+    decode_buf.out_size = write_data.size();
+
+    while (true)
+    {
+        stream_ended = !verify_decode(xz_dec_run(xz_decoder.get(), &decode_buf));
+
+        // Flush whenever the output fills up, and before asking for more input. With a full output buffer, there may
+        // be more to come out even when all the input is in
+        const auto output_full = decode_buf.out_pos == decode_buf.out_size;
+        if (stream_ended || output_full || decode_buf.in_pos == decode_buf.in_size)
         {
-            decoded_file.write(write_data.data(), decode_buf.out_pos);
+            write_sparse(decoded_file, decoded_size, reinterpret_cast<const char*>(write_data.data()),
+                         decode_buf.out_pos);
+            decoded_size += decode_buf.out_pos;
             decode_buf.out_pos = 0;
         }
+
+        if (stream_ended || (!output_full && decode_buf.in_pos == decode_buf.in_size))
+            return stream_ended;
     }
 }
+
+void mp::XzStreamDecoder::finish()
+{
+    if (!stream_ended)
+        throw std::runtime_error("xz file is truncated");
+
+    // Trailing zeros were skipped, so the size has to be set explicitly
+    if (!decoded_file.resize(decoded_size) || !decoded_file.flush())
+        throw std::runtime_error(fmt::format("failed to write to {}", decoded_file.fileName()));
+}
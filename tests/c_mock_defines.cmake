@@ -42,13 +42,15 @@ add_c_mocks(
   ssh_channel_request_shell
   ssh_channel_request_pty
   ssh_channel_change_pty_size
+  ssh_channel_read
   ssh_channel_read_timeout
+  ssh_channel_poll
+  ssh_channel_write
   ssh_channel_get_exit_status
   ssh_event_dopoll
   ssh_add_channel_callbacks
   sftp_server_new
   sftp_free
-  sftp_server_init
   sftp_reply_status
   sftp_reply_attr
   sftp_reply_data
@@ -68,6 +70,8 @@ add_c_mocks(
   sftp_open
   sftp_write
   sftp_read
+  sftp_async_read_begin
+  sftp_async_read
   sftp_free
   sftp_get_error
   sftp_close
@@ -82,5 +86,7 @@ add_c_mocks(
   sftp_setstat
   sftp_dir_eof
   sftp_chmod
+  sftp_utimes
+  sftp_rmdir
   ssh_get_error
 )
@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 namespace mpt = multipass::test;
 
@@ -53,6 +54,34 @@ int virConnectGetVersion(virConnectPtr /*conn*/, unsigned long* hvVer)
     return 0;
 }
 
+int virConnectRef(virConnectPtr /*conn*/)
+{
+    return 0;
+}
+
+int virConnectIsAlive(virConnectPtr /*conn*/)
+{
+    return 1;
+}
+
+int virConnectSetKeepAlive(virConnectPtr /*conn*/, int /*interval*/, unsigned int /*count*/)
+{
+    return 0;
+}
+
+// Events are not delivered by default, so states are always asked for
+int virConnectDomainEventRegisterAny(virConnectPtr /*conn*/, virDomainPtr /*dom*/, int /*eventID*/,
+                                     virConnectDomainEventGenericCallback /*cb*/, void* /*opaque*/,
+                                     virFreeCallback /*freecb*/)
+{
+    return -1;
+}
+
+int virConnectDomainEventDeregisterAny(virConnectPtr /*conn*/, int /*callbackID*/)
+{
+    return 0;
+}
+
 int virDomainCreate(virDomainPtr /*domain*/)
 {
     return 0;
@@ -95,6 +124,11 @@ virDomainPtr virDomainLookupByName(virConnectPtr /*conn*/, const char* /*name*/)
     return mpt::fake_handle<virDomainPtr>();
 }
 
+const char* virDomainGetName(virDomainPtr /*domain*/)
+{
+    return "pied-piper-valley";
+}
+
 int virDomainManagedSave(virDomainPtr /*domain*/, unsigned int /*flags*/)
 {
     return 0;
@@ -171,3 +205,28 @@ int virDomainSetMemoryFlags(virDomainPtr /*domain*/, unsigned long /*memory*/, u
 {
     return 1;
 }
+
+int virEventRegisterDefaultImpl()
+{
+    return 0;
+}
+
+int virEventRunDefaultImpl()
+{
+    usleep(10000);
+    return 0;
+}
+
+int virEventAddTimeout(int /*timeout*/, virEventTimeoutCallback /*cb*/, void* /*opaque*/, virFreeCallback /*ff*/)
+{
+    return 1;
+}
+
+void virEventUpdateTimeout(int /*timer*/, int /*timeout*/)
+{
+}
+
+int virEventRemoveTimeout(int /*timer*/)
+{
+    return 0;
+}
@@ -20,6 +20,7 @@
 #include "tests/mock_backend_utils.h"
 #include "tests/mock_ssh.h"
 #include "tests/mock_status_monitor.h"
+#include "tests/mock_utils.h"
 #include "tests/stub_ssh_key_provider.h"
 #include "tests/stub_status_monitor.h"
 #include "tests/temp_dir.h"
@@ -35,6 +36,7 @@
 #include <multipass/virtual_machine_description.h>
 
 #include <cstdlib>
+#include <utility>
 
 namespace mp = multipass;
 namespace mpt = multipass::test;
@@ -99,6 +101,7 @@ TEST_F(LibVirtBackend, health_check_failed_connection_throws)
 
     mp::LibVirtVirtualMachineFactory backend(data_dir.path(), fake_libvirt_path);
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
     backend.libvirt_wrapper->virGetLastErrorMessage = [] { return static_virGetLastErrorMessage(); };
 
     MP_EXPECT_THROW_THAT(
@@ -154,7 +157,12 @@ TEST_F(LibVirtBackend, machine_sends_monitoring_events)
         return 0;
     };
 
-    machine->wait_until_ssh_up(2min);
+    {
+        auto [mock_utils, guard] = mpt::MockUtils::inject();
+        EXPECT_CALL(*mock_utils, is_ssh_answering(_, _, _)).WillOnce(Return(true));
+
+        machine->wait_until_ssh_up(2min);
+    }
 
     EXPECT_CALL(mock_monitor, on_shutdown());
     machine->shutdown();
@@ -228,6 +236,7 @@ TEST_F(LibVirtBackend, start_with_broken_libvirt_connection_throws)
 {
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
 
     NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
     auto machine = backend.create_virtual_machine(default_description, mock_monitor);
@@ -241,6 +250,7 @@ TEST_F(LibVirtBackend, shutdown_with_broken_libvirt_connection_throws)
 {
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
 
     NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
     auto machine = backend.create_virtual_machine(default_description, mock_monitor);
@@ -254,6 +264,7 @@ TEST_F(LibVirtBackend, suspend_with_broken_libvirt_connection_throws)
 {
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
 
     NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
     auto machine = backend.create_virtual_machine(default_description, mock_monitor);
@@ -267,6 +278,7 @@ TEST_F(LibVirtBackend, current_state_with_broken_libvirt_unknown)
 {
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
 
     NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
     auto machine = backend.create_virtual_machine(default_description, mock_monitor);
@@ -315,6 +327,49 @@ TEST_F(LibVirtBackend, current_state_off_domain_starts_running)
     EXPECT_THAT(machine->current_state(), Eq(mp::VirtualMachine::State::running));
 }
 
+TEST_F(LibVirtBackend, current_state_is_kept_until_domain_event)
+{
+    static int alive, get_state_calls, domain_state;
+    static virConnectDomainEventGenericCallback event_callback;
+    static void* event_opaque;
+    alive = 0;
+    domain_state = VIR_DOMAIN_SHUTOFF;
+    event_callback = nullptr;
+
+    mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
+
+    // Make the next connection follow events
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return std::exchange(alive, 1); };
+    backend.libvirt_wrapper->virConnectDomainEventRegisterAny = [](auto, auto, auto, auto callback, auto opaque,
+                                                                   auto) {
+        event_callback = callback;
+        event_opaque = opaque;
+        return 1;
+    };
+    backend.libvirt_wrapper->virDomainGetState = [](auto, auto state, auto, auto) {
+        ++get_state_calls;
+        *state = domain_state;
+        return 0;
+    };
+
+    NiceMock<mpt::MockVMStatusMonitor> mock_monitor;
+    auto machine = backend.create_virtual_machine(default_description, mock_monitor);
+    ASSERT_NE(event_callback, nullptr);
+
+    get_state_calls = 0;
+    EXPECT_THAT(machine->current_state(), Eq(mp::VirtualMachine::State::off));
+    EXPECT_THAT(machine->current_state(), Eq(mp::VirtualMachine::State::off));
+    EXPECT_EQ(get_state_calls, 1);
+
+    domain_state = VIR_DOMAIN_RUNNING;
+    reinterpret_cast<virConnectDomainEventCallback>(event_callback)(mpt::fake_handle<virConnectPtr>(),
+                                                                    mpt::fake_handle<virDomainPtr>(),
+                                                                    VIR_DOMAIN_EVENT_STARTED, 0, event_opaque);
+
+    EXPECT_THAT(machine->current_state(), Eq(mp::VirtualMachine::State::running));
+    EXPECT_EQ(get_state_calls, 2);
+}
+
 TEST_F(LibVirtBackend, returns_version_string)
 {
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
@@ -355,6 +410,7 @@ TEST_F(LibVirtBackend, returns_version_string_when_failed_connecting)
 
     mp::LibVirtVirtualMachineFactory backend{data_dir.path(), fake_libvirt_path};
     backend.libvirt_wrapper->virConnectOpen = [](auto...) -> virConnectPtr { return nullptr; };
+    backend.libvirt_wrapper->virConnectIsAlive = [](auto...) { return 0; };
     backend.libvirt_wrapper->virConnectGetVersion = [](virConnectPtr conn, long unsigned int* hwVer) {
         return static_virConnectGetVersion(conn, hwVer);
     };
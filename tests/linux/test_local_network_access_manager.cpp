@@ -30,9 +30,12 @@
 
 #include <QBuffer>
 #include <QEventLoop>
+#include <QLocalServer>
+#include <QLocalSocket>
 #include <QNetworkReply>
 #include <QTimer>
 
+#include <memory>
 #include <random>
 
 namespace mp = multipass;
@@ -204,10 +207,9 @@ TEST_F(LocalNetworkAccessManager, client_posts_correct_data)
     QByteArray expected_data{"POST /1.0 HTTP/1.1\r\n"
                              "Host: test\r\n"
                              "User-Agent: Test\r\n"
-                             "Connection: close\r\n"
                              "Content-Type: application/x-www-form-urlencoded\r\n"
                              "Content-Length: 11\r\n\r\n"
-                             "Hello World\r\n"};
+                             "Hello World"};
 
     QByteArray http_response{"HTTP/1.1 200 OK\r\n\r\n"};
 
@@ -221,6 +223,106 @@ TEST_F(LocalNetworkAccessManager, client_posts_correct_data)
     handle_request(base_url, "POST", "Hello World");
 }
 
+TEST_F(LocalNetworkAccessManager, reuses_connection_kept_open_by_server)
+{
+    const QString keep_alive_socket_path{QString("%1/keep_alive_socket").arg(temp_dir.path())};
+    QUrl keep_alive_url{QString("unix://%1@1.0").arg(keep_alive_socket_path)};
+    keep_alive_url.setHost("test");
+
+    auto connections{0};
+    QLocalServer server;
+    server.listen(keep_alive_socket_path);
+    QObject::connect(&server, &QLocalServer::newConnection, [&server, &connections] {
+        ++connections;
+        auto client_connection = server.nextPendingConnection();
+
+        auto request = std::make_shared<QByteArray>();
+        QObject::connect(client_connection, &QLocalSocket::readyRead, [client_connection, request] {
+            request->append(client_connection->readAll());
+            if (!request->endsWith("\r\n\r\n"))
+                return;
+
+            request->clear();
+            client_connection->write("HTTP/1.1 200 OK\r\n"
+                                     "Content-Length: 2\r\n"
+                                     "\r\n"
+                                     "ok");
+        });
+    });
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        auto reply = handle_request(keep_alive_url, "GET");
+
+        ASSERT_EQ(reply->error(), QNetworkReply::NoError);
+        EXPECT_EQ(reply->readAll(), "ok");
+
+        download_timeout.stop();
+        QObject::disconnect(&download_timeout, nullptr, nullptr, nullptr);
+    }
+
+    EXPECT_EQ(connections, 1);
+}
+
+TEST_F(LocalNetworkAccessManager, retries_on_fresh_connection_when_reused_one_closes_before_answering)
+{
+    const QString keep_alive_socket_path{QString("%1/keep_alive_socket").arg(temp_dir.path())};
+    QUrl keep_alive_url{QString("unix://%1@1.0").arg(keep_alive_socket_path)};
+    keep_alive_url.setHost("test");
+
+    auto connections{0};
+    QLocalServer server;
+    server.listen(keep_alive_socket_path);
+    QObject::connect(&server, &QLocalServer::newConnection, [&server, &connections] {
+        ++connections;
+        auto client_connection = server.nextPendingConnection();
+
+        // The first connection answers one request and then goes away instead of answering the next
+        auto answers_left = std::make_shared<int>(connections == 1 ? 1 : 2);
+        auto request = std::make_shared<QByteArray>();
+        QObject::connect(client_connection, &QLocalSocket::readyRead, [client_connection, request, answers_left] {
+            request->append(client_connection->readAll());
+            if (!request->endsWith("\r\n\r\n"))
+                return;
+
+            request->clear();
+            if ((*answers_left)-- == 0)
+            {
+                client_connection->disconnectFromServer();
+                return;
+            }
+
+            client_connection->write("HTTP/1.1 200 OK\r\n"
+                                     "Content-Length: 2\r\n"
+                                     "\r\n"
+                                     "ok");
+        });
+    });
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        auto reply = handle_request(keep_alive_url, "GET");
+
+        ASSERT_EQ(reply->error(), QNetworkReply::NoError);
+        EXPECT_EQ(reply->readAll(), "ok");
+
+        download_timeout.stop();
+        QObject::disconnect(&download_timeout, nullptr, nullptr, nullptr);
+    }
+
+    EXPECT_EQ(connections, 2);
+}
+
+TEST_F(LocalNetworkAccessManager, connection_closed_before_answering_has_error)
+{
+    auto server_response = [](auto...) { return QByteArray{}; };
+    test_server.local_socket_server_handler(server_response);
+
+    auto reply = handle_request(base_url, "GET");
+
+    EXPECT_EQ(reply->error(), QNetworkReply::RemoteHostClosedError);
+}
+
 TEST_F(LocalNetworkAccessManager, bad_http_server_response_has_error)
 {
     QByteArray malformed_http_response{"FOO/1.4 42 Yo\r\n"};
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tests/common.h"
+#include "tests/temp_dir.h"
+
+#include <src/sshfs_mount/sftp_attribute_cache.h>
+
+#include <QDir>
+#include <QFile>
+
+#include <chrono>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+struct SftpAttributeCache : public Test
+{
+    std::string path_of(const QString& name)
+    {
+        return temp_dir.filePath(name).toStdString();
+    }
+
+    mpt::TempDir temp_dir;
+    const std::string dir{temp_dir.path().toStdString()};
+    mp::SftpAttributeCache cache{100};
+    const mp::SftpStat stat{true, {}};
+};
+
+void make_file(const QString& path)
+{
+    QFile file{path};
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+}
+} // namespace
+
+TEST_F(SftpAttributeCache, returns_inserted_stat)
+{
+    const auto path = path_of("file");
+
+    EXPECT_FALSE(cache.find_stat(path, false));
+
+    auto generation = cache.watch(dir);
+    ASSERT_TRUE(generation);
+    cache.insert_stat(path, false, stat, *generation);
+
+    EXPECT_TRUE(cache.find_stat(path, false));
+    EXPECT_FALSE(cache.find_stat(path, true));
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST_F(SftpAttributeCache, ignores_insert_with_stale_generation)
+{
+    const auto path = path_of("file");
+
+    auto generation = cache.watch(dir);
+    ASSERT_TRUE(generation);
+    cache.invalidate(path);
+    cache.insert_stat(path, false, stat, *generation);
+
+    EXPECT_FALSE(cache.find_stat(path, false));
+}
+
+TEST_F(SftpAttributeCache, invalidate_drops_entry_and_parent_listing)
+{
+    const auto path = path_of("file");
+
+    auto generation = cache.watch(dir);
+    ASSERT_TRUE(generation);
+    cache.insert_listing(dir, std::make_shared<mp::SftpDirEntries>(), *generation);
+    cache.insert_stat(path, false, stat, *cache.watch(dir));
+
+    cache.invalidate(path);
+
+    EXPECT_FALSE(cache.find_stat(path, false));
+    EXPECT_FALSE(cache.find_listing(dir));
+}
+
+TEST_F(SftpAttributeCache, invalidate_drops_stat_of_parent_gathered_before)
+{
+    const auto subdir = path_of("subdir");
+    ASSERT_TRUE(QDir{temp_dir.path()}.mkdir("subdir"));
+
+    auto generation = cache.watch(dir);
+    ASSERT_TRUE(generation);
+    cache.insert_stat(subdir, false, stat, *generation);
+
+    cache.invalidate(subdir + "/file");
+    EXPECT_FALSE(cache.find_stat(subdir, false));
+
+    cache.insert_stat(subdir, false, stat, *generation);
+    EXPECT_FALSE(cache.find_stat(subdir, false));
+}
+
+TEST_F(SftpAttributeCache, drops_listing_on_external_change)
+{
+    auto generation = cache.watch(dir);
+    ASSERT_TRUE(generation);
+    cache.insert_listing(dir, std::make_shared<mp::SftpDirEntries>(), *generation);
+    ASSERT_TRUE(cache.find_listing(dir));
+
+    make_file(temp_dir.filePath("new_file"));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (cache.find_listing(dir) && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_FALSE(cache.find_listing(dir));
+}
+
+TEST_F(SftpAttributeCache, starts_over_when_full)
+{
+    mp::SftpAttributeCache small_cache{1};
+
+    auto generation = small_cache.watch(dir);
+    ASSERT_TRUE(generation);
+    small_cache.insert_stat(path_of("a"), false, stat, *generation);
+    small_cache.insert_stat(path_of("b"), false, stat, *generation);
+
+    EXPECT_FALSE(small_cache.find_stat(path_of("a"), false));
+    EXPECT_FALSE(small_cache.find_stat(path_of("b"), false));
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tests/common.h"
+#include "tests/temp_dir.h"
+
+#include <src/platform/backends/lxd/lxd_event_monitor.h>
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUrl>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct LXDEventMonitor : public Test
+{
+    LXDEventMonitor()
+    {
+        server.listen(socket_path);
+    }
+
+    // Plays LXD's part in upgrading the connection to a websocket
+    QLocalSocket* accept_events_connection()
+    {
+        EXPECT_TRUE(server.waitForNewConnection(5000));
+        auto socket = server.nextPendingConnection();
+        if (!socket)
+            return nullptr;
+
+        QByteArray request;
+        while (!request.contains("\r\n\r\n") && socket->waitForReadyRead(5000))
+            request.append(socket->readAll());
+
+        EXPECT_THAT(request.toStdString(), HasSubstr("GET /1.0/events?type=lifecycle,operation&project=multipass HTTP/1.1"));
+
+        socket->write("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n");
+        socket->waitForBytesWritten(5000);
+
+        return socket;
+    }
+
+    void send_lifecycle_event(QLocalSocket* socket, const QString& name)
+    {
+        send_event(socket, QString(R"({"type":"lifecycle","metadata":{"action":"instance-stopped",)"
+                                   R"("source":"/1.0/instances/%1?project=multipass"}})")
+                               .arg(name)
+                               .toUtf8());
+    }
+
+    void send_operation_event(QLocalSocket* socket, const QString& id, int status_code)
+    {
+        send_event(socket, QString(R"({"type":"operation","metadata":{"id":"%1","status_code":%2}})")
+                               .arg(id)
+                               .arg(status_code)
+                               .toUtf8());
+    }
+
+    void send_event(QLocalSocket* socket, const QByteArray& payload)
+    {
+        QByteArray frame;
+        frame.append(static_cast<char>(0x81));
+        frame.append(static_cast<char>(payload.size()));
+        frame.append(payload);
+
+        socket->write(frame);
+        socket->waitForBytesWritten(5000);
+    }
+
+    bool eventually(const std::function<bool()>& predicate)
+    {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!predicate() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(10ms);
+
+        return predicate();
+    }
+
+    mpt::TempDir temp_dir;
+    const QString socket_path{temp_dir.filePath("unix.socket")};
+    const QUrl base_url{QString("unix://%1@1.0").arg(socket_path)};
+    QLocalServer server;
+};
+} // namespace
+
+TEST_F(LXDEventMonitor, keeps_states_while_following_events)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.generation().has_value(); }));
+    monitor.insert_state("foo", mp::VirtualMachine::State::running, *monitor.generation());
+
+    EXPECT_EQ(monitor.state_for("foo"), mp::VirtualMachine::State::running);
+    EXPECT_FALSE(monitor.state_for("bar"));
+}
+
+TEST_F(LXDEventMonitor, drops_state_of_instance_with_lifecycle_event)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.generation().has_value(); }));
+    monitor.insert_state("foo", mp::VirtualMachine::State::running, *monitor.generation());
+    monitor.insert_state("bar", mp::VirtualMachine::State::running, *monitor.generation());
+
+    send_lifecycle_event(socket, "foo");
+
+    EXPECT_TRUE(eventually([&monitor] { return !monitor.state_for("foo"); }));
+    EXPECT_EQ(monitor.state_for("bar"), mp::VirtualMachine::State::running);
+}
+
+TEST_F(LXDEventMonitor, ignores_states_from_stale_generation)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.generation().has_value(); }));
+    auto generation = *monitor.generation();
+
+    send_lifecycle_event(socket, "bar");
+    ASSERT_TRUE(eventually([&monitor, generation] { return monitor.generation() != generation; }));
+
+    monitor.insert_state("foo", mp::VirtualMachine::State::running, generation);
+    EXPECT_FALSE(monitor.state_for("foo"));
+}
+
+TEST_F(LXDEventMonitor, forgets_states_when_disconnected)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.generation().has_value(); }));
+    monitor.insert_state("foo", mp::VirtualMachine::State::running, *monitor.generation());
+
+    server.close();
+    socket->disconnectFromServer();
+
+    EXPECT_TRUE(eventually([&monitor] { return !monitor.generation(); }));
+    EXPECT_FALSE(monitor.state_for("foo"));
+}
+
+TEST_F(LXDEventMonitor, keeps_nothing_without_lxd)
+{
+    server.close();
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+
+    monitor.insert_state("foo", mp::VirtualMachine::State::running, 0);
+
+    EXPECT_FALSE(monitor.generation());
+    EXPECT_FALSE(monitor.state_for("foo"));
+}
+
+TEST_F(LXDEventMonitor, returns_outcome_of_watched_operation)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.watch_operation("foo"); }));
+
+    send_operation_event(socket, "foo", 103);
+    send_operation_event(socket, "bar", 200);
+    send_operation_event(socket, "foo", 200);
+
+    auto metadata = monitor.wait_for_operation("foo", 5s);
+    ASSERT_TRUE(metadata);
+    EXPECT_EQ((*metadata)["status_code"].toInt(), 200);
+}
+
+TEST_F(LXDEventMonitor, stops_waiting_for_operation_when_disconnected)
+{
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+    auto socket = accept_events_connection();
+    ASSERT_TRUE(socket);
+
+    ASSERT_TRUE(eventually([&monitor] { return monitor.watch_operation("foo"); }));
+
+    server.close();
+    socket->disconnectFromServer();
+
+    EXPECT_FALSE(monitor.wait_for_operation("foo", 5s));
+}
+
+TEST_F(LXDEventMonitor, cannot_watch_operations_without_lxd)
+{
+    server.close();
+    mp::LXDEventMonitor monitor{base_url, 10ms};
+
+    EXPECT_FALSE(monitor.watch_operation("foo"));
+    EXPECT_FALSE(monitor.wait_for_operation("foo", 10ms));
+}
@@ -837,24 +837,6 @@ TEST_F(LXDImageVault, custom_image_downloads_and_creates_correct_upload)
     const std::string content{"This is a fake image!"};
     mpt::TrackingURLDownloader url_downloader{content};
     auto factory = mpt::MockProcessFactory::Inject();
-    factory->register_callback([](mpt::MockProcess* process) {
-        if (process->program().startsWith("tar"))
-        {
-            auto tar_args = process->arguments();
-
-            EXPECT_EQ(tar_args.size(), 5);
-            QFile output_file{tar_args[1]}, input_file{tar_args[3] + "/" + tar_args[4]};
-
-            output_file.open(QIODevice::WriteOnly);
-            input_file.open(QIODevice::ReadOnly);
-
-            output_file.write(input_file.readAll());
-
-            mp::ProcessState exit_state;
-            exit_state.exit_code = 0;
-            ON_CALL(*process, execute(_)).WillByDefault(Return(exit_state));
-        }
-    });
 
     ON_CALL(*mock_network_access_manager.get(), createRequest(_, _, _))
         .WillByDefault([](auto, auto request, auto outgoingData) {
@@ -985,24 +967,6 @@ TEST_F(LXDImageVault, http_based_image_downloads_and_creates_correct_upload)
     const std::string content{"This is a fake image!"};
     mpt::TrackingURLDownloader url_downloader{content};
     auto factory = mpt::MockProcessFactory::Inject();
-    factory->register_callback([](mpt::MockProcess* process) {
-        if (process->program().startsWith("tar"))
-        {
-            auto tar_args = process->arguments();
-
-            EXPECT_EQ(tar_args.size(), 5);
-            QFile output_file{tar_args[1]}, input_file{tar_args[3] + "/" + tar_args[4]};
-
-            output_file.open(QIODevice::WriteOnly);
-            input_file.open(QIODevice::ReadOnly);
-
-            output_file.write(input_file.readAll());
-
-            mp::ProcessState exit_state;
-            exit_state.exit_code = 0;
-            ON_CALL(*process, execute(_)).WillByDefault(Return(exit_state));
-        }
-    });
 
     ON_CALL(*mock_network_access_manager, createRequest(_, _, _))
         .WillByDefault([](auto, auto request, auto outgoingData) {
@@ -1016,6 +980,12 @@ TEST_F(LXDImageVault, http_based_image_downloads_and_creates_correct_upload)
                 EXPECT_TRUE(content_header.contains("multipart/form-data"));
                 EXPECT_TRUE(content_header.contains("boundary"));
 
+                auto upload = outgoingData->readAll();
+
+                EXPECT_TRUE(upload.contains("metadata.yaml"));
+                EXPECT_TRUE(upload.contains("ustar"));
+                EXPECT_TRUE(upload.contains("This is a fake image!"));
+
                 return new mpt::MockLocalSocketReply(mpt::image_upload_task_data);
             }
             else if (op == "GET" && url.contains("1.0/operations/dcce4fda-aab9-4117-89c1-9f42b8e3f4a8"))
@@ -1041,7 +1011,7 @@ TEST_F(LXDImageVault, http_based_image_downloads_and_creates_correct_upload)
 
     EXPECT_TRUE(image_time >= current_time);
 
-    EXPECT_EQ(url_downloader.downloaded_files.size(), 1);
+    EXPECT_TRUE(url_downloader.downloaded_files.isEmpty());
     EXPECT_EQ(url_downloader.downloaded_urls.size(), 1);
     EXPECT_EQ(url_downloader.downloaded_urls.front().toStdString(), download_url);
 }
@@ -1051,24 +1021,6 @@ TEST_F(LXDImageVault, file_based_fetch_copies_image_and_returns_expected_info)
     mpt::TempFile file;
 
     auto factory = mpt::MockProcessFactory::Inject();
-    factory->register_callback([](mpt::MockProcess* process) {
-        if (process->program().startsWith("tar"))
-        {
-            auto tar_args = process->arguments();
-
-            EXPECT_EQ(tar_args.size(), 5);
-            QFile output_file{tar_args[1]}, input_file{tar_args[3] + "/" + tar_args[4]};
-
-            output_file.open(QIODevice::WriteOnly);
-            input_file.open(QIODevice::ReadOnly);
-
-            output_file.write(input_file.readAll());
-
-            mp::ProcessState exit_state;
-            exit_state.exit_code = 0;
-            ON_CALL(*process, execute(_)).WillByDefault(Return(exit_state));
-        }
-    });
 
     ON_CALL(*mock_network_access_manager, createRequest(_, _, _))
         .WillByDefault([](auto, auto request, auto outgoingData) {
@@ -65,6 +65,8 @@ public:
     MOCK_METHOD(fs::path, read_symlink, (const fs::path& path, std::error_code& err), (override, const));
     MOCK_METHOD(void, permissions, (const fs::path& path, fs::perms perms, std::error_code& err), (override, const));
     MOCK_METHOD(fs::file_status, status, (const fs::path& path, std::error_code& err), (override, const));
+    MOCK_METHOD(std::uintmax_t, file_size, (const fs::path& path, std::error_code& err), (override, const));
+    MOCK_METHOD(fs::file_time_type, last_write_time, (const fs::path& path, std::error_code& err), (override, const));
     MOCK_METHOD(std::unique_ptr<multipass::RecursiveDirIterator>, recursive_dir_iterator,
                 (const fs::path& path, std::error_code& err), (override, const));
 
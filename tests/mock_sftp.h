@@ -28,6 +28,9 @@ DECL_MOCK(sftp_init);
 DECL_MOCK(sftp_open);
 DECL_MOCK(sftp_write);
 DECL_MOCK(sftp_read);
+DECL_MOCK(sftp_async_read_begin);
+DECL_MOCK(sftp_async_read);
+DECL_MOCK(sftp_seek64);
 DECL_MOCK(sftp_get_error);
 DECL_MOCK(sftp_close);
 DECL_MOCK(sftp_stat);
@@ -41,5 +44,7 @@ DECL_MOCK(sftp_unlink);
 DECL_MOCK(sftp_setstat);
 DECL_MOCK(sftp_dir_eof);
 DECL_MOCK(sftp_chmod);
+DECL_MOCK(sftp_utimes);
+DECL_MOCK(sftp_rmdir);
 
 #endif // MULTIPASS_MOCK_SFTP_H
@@ -31,6 +31,7 @@ struct MockURLDownloader : public multipass::URLDownloader
     MOCK_METHOD1(download, QByteArray(const QUrl&));
     MOCK_METHOD1(last_modified, QDateTime(const QUrl&));
     MOCK_METHOD5(download_to, void(const QUrl&, const QString&, int64_t, const int, const ProgressMonitor&));
+    MOCK_METHOD5(stream_to, void(const QUrl&, const DataSink&, int64_t, const int, const ProgressMonitor&));
 };
 } // namespace test
 } // namespace multipass
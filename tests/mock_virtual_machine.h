@@ -53,7 +53,7 @@ struct MockVirtualMachine : public multipass::VirtualMachine
     MOCK_METHOD1(ssh_hostname, std::string(std::chrono::milliseconds));
     MOCK_METHOD0(ssh_username, std::string());
     MOCK_METHOD0(management_ipv4, std::string());
-    MOCK_METHOD1(get_all_ipv4, std::vector<std::string>(const SSHKeyProvider&));
+    MOCK_METHOD1(get_all_ipv4, std::vector<std::string>(SSHSessionPool&));
     MOCK_METHOD0(ipv6, std::string());
     MOCK_METHOD0(ensure_vm_is_running, void());
     MOCK_METHOD1(wait_until_ssh_up, void(std::chrono::milliseconds));
@@ -116,6 +116,20 @@ TEST_F(DNSMasqServer, finds_ip)
     EXPECT_EQ(host, "dummy_name");
 }
 
+TEST_F(DNSMasqServer, picks_up_changes_to_leases_file)
+{
+    auto dns = make_default_dnsmasq_server();
+    make_lease_entry("00:01:02:03:04:99");
+
+    EXPECT_FALSE(dns.get_ip_and_host_for(hw_addr));
+
+    make_lease_entry();
+    auto ip_and_host = dns.get_ip_and_host_for(hw_addr);
+
+    ASSERT_TRUE(ip_and_host);
+    EXPECT_EQ(ip_and_host->first, mp::IPAddress(expected_ip));
+}
+
 TEST_F(DNSMasqServer, returns_null_ip_when_leases_file_does_not_exist)
 {
     auto dns = make_default_dnsmasq_server();
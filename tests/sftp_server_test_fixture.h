@@ -23,6 +23,9 @@
 #include "mock_sftpserver.h"
 #include "mock_ssh_test_fixture.h"
 
+#include <algorithm>
+#include <array>
+
 namespace multipass
 {
 namespace test
@@ -30,23 +33,35 @@ namespace test
 struct SftpServerTest : public testing::Test
 {
     SftpServerTest()
-        : free_sftp{mock_sftp_free, [](sftp_session sftp) {
+        : free_sftp{mock_sftp_free,
+                    [](sftp_session sftp) {
                         std::free(sftp->handles);
                         std::free(sftp);
-                    }}
+                    }},
+          // Plays the client's part in the handshake, every time a session is made
+          read_init{mock_ssh_channel_read,
+                    [sent = std::size_t{0}](ssh_channel, void* dest, uint32_t count, int) mutable {
+                        const std::array<unsigned char, 9> init{0, 0, 0, 5, SSH_FXP_INIT, 0, 0, 0, LIBSFTP_VERSION};
+                        const auto num_to_copy = std::min<std::size_t>(count, init.size() - sent);
+                        std::copy_n(init.begin() + sent, num_to_copy, static_cast<unsigned char*>(dest));
+                        sent = (sent + num_to_copy) % init.size();
+                        return static_cast<int>(num_to_copy);
+                    }},
+          write_version{mock_ssh_channel_write,
+                        [](ssh_channel, const void*, uint32_t len) { return static_cast<int>(len); }}
     {
-        init_sftp.returnValue(SSH_OK);
         reply_status.returnValue(SSH_OK);
         get_client_msg.returnValue(nullptr);
         handle_sftp.returnValue(nullptr);
     }
 
-    decltype(MOCK(sftp_server_init)) init_sftp{MOCK(sftp_server_init)};
     decltype(MOCK(sftp_reply_status)) reply_status{MOCK(sftp_reply_status)};
     decltype(MOCK(sftp_get_client_message)) get_client_msg{MOCK(sftp_get_client_message)};
     decltype(MOCK(sftp_client_message_free)) msg_free{MOCK(sftp_client_message_free)};
     decltype(MOCK(sftp_handle)) handle_sftp{MOCK(sftp_handle)};
     MockScope<decltype(mock_sftp_free)> free_sftp;
+    MockScope<decltype(mock_ssh_channel_read)> read_init;
+    MockScope<decltype(mock_ssh_channel_write)> write_version;
 
     MockSSHTestFixture mock_ssh_test_fixture;
 };
@@ -23,6 +23,7 @@
 
 #include <multipass/exceptions/ssh_exception.h>
 #include <multipass/ssh/ssh_session.h>
+#include <multipass/ssh/ssh_session_pool.h>
 #include <multipass/vm_mount.h>
 
 namespace mp = multipass;
@@ -119,6 +120,7 @@ struct BaseVM : public Test
 {
     mpt::MockSSHTestFixture mock_ssh_test_fixture;
     const mpt::DummyKeyProvider key_provider{"keeper of the seven keys"};
+    mp::SSHSessionPool session_pool{key_provider};
 };
 
 TEST_F(BaseVM, get_all_ipv4_works_when_ssh_throws_opening_a_session)
@@ -127,7 +129,7 @@ TEST_F(BaseVM, get_all_ipv4_works_when_ssh_throws_opening_a_session)
 
     REPLACE(ssh_new, []() { return nullptr; }); // This makes SSH throw when opening a new session.
 
-    auto ip_list = base_vm.get_all_ipv4(key_provider);
+    auto ip_list = base_vm.get_all_ipv4(session_pool);
     EXPECT_EQ(ip_list.size(), 0u);
 }
 
@@ -138,7 +140,7 @@ TEST_F(BaseVM, get_all_ipv4_works_when_ssh_throws_executing)
     // Make SSH throw when trying to execute something.
     mock_ssh_test_fixture.request_exec.returnValue(SSH_ERROR);
 
-    auto ip_list = base_vm.get_all_ipv4(key_provider);
+    auto ip_list = base_vm.get_all_ipv4(session_pool);
     EXPECT_EQ(ip_list.size(), 0u);
 }
 
@@ -146,7 +148,7 @@ TEST_F(BaseVM, get_all_ipv4_works_when_instance_is_off)
 {
     StubBaseVirtualMachine base_vm(mp::VirtualMachine::State::off);
 
-    EXPECT_EQ(base_vm.get_all_ipv4(key_provider).size(), 0u);
+    EXPECT_EQ(base_vm.get_all_ipv4(session_pool).size(), 0u);
 }
 
 TEST_F(BaseVM, addMountDoesNotFail)
@@ -204,7 +206,7 @@ TEST_P(IpExecution, get_all_ipv4_works_when_ssh_works)
     };
     REPLACE(ssh_channel_read_timeout, channel_read);
 
-    auto ip_list = base_vm.get_all_ipv4(key_provider);
+    auto ip_list = base_vm.get_all_ipv4(session_pool);
     EXPECT_EQ(ip_list, test_params.expected_ips);
 }
 
@@ -600,6 +600,18 @@ TEST_F(Client, transfer_cmd_local_target_not_all_instance_sources_fails)
     EXPECT_THAT(send_command({"transfer", "aaa", "test-vm1:foo", "bbb"}), Eq(mp::ReturnCode::CommandLineError));
 }
 
+TEST_F(Client, transfer_cmd_delete_without_sync_fails)
+{
+    EXPECT_THAT(send_command({"transfer", "-r", "--delete", "foo", "test-vm1:bar"}),
+                Eq(mp::ReturnCode::CommandLineError));
+}
+
+TEST_F(Client, transfer_cmd_sync_into_host_fails)
+{
+    EXPECT_THAT(send_command({"transfer", "--sync", "test-vm1:foo", "bar"}), Eq(mp::ReturnCode::CommandLineError));
+    EXPECT_THAT(send_command({"transfer", "--sync", "-", "test-vm1:foo"}), Eq(mp::ReturnCode::CommandLineError));
+}
+
 TEST_F(Client, transfer_cmd_stdin_good_destination_ok)
 {
     auto [mocked_sftp_utils, mocked_sftp_utils_guard] = mpt::MockSFTPUtils::inject();
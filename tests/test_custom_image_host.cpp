@@ -289,7 +289,7 @@ TEST_F(CustomImageHost, handles_and_recovers_from_initial_network_failure)
     EXPECT_TRUE(host.info_for(query));
 }
 
-TEST_F(CustomImageHost, handles_and_recovers_from_later_network_failure)
+TEST_F(CustomImageHost, keeps_serving_cached_manifests_through_later_network_failure)
 {
     const auto ttl = 0s; // to ensure updates are always retried
     mp::CustomVMImageHost host{"x86_64", &mock_url_downloader, ttl};
@@ -297,24 +297,19 @@ TEST_F(CustomImageHost, handles_and_recovers_from_later_network_failure)
     const auto query = make_query("core20", "snapcraft");
     EXPECT_TRUE(host.info_for(query));
 
-    EXPECT_CALL(mock_url_downloader, last_modified(_))
-        .WillOnce(Throw(mp::DownloadException{"", ""}))
-        .WillRepeatedly(DoDefault());
-    EXPECT_CALL(mock_url_downloader, download(_))
-        .WillOnce(Throw(mp::DownloadException{"", ""}))
-        .WillRepeatedly(DoDefault());
-
-    EXPECT_THROW(host.info_for(query), std::runtime_error);
+    EXPECT_CALL(mock_url_downloader, last_modified(_)).WillRepeatedly(Throw(mp::DownloadException{"", ""}));
+    EXPECT_CALL(mock_url_downloader, download(_)).WillRepeatedly(Throw(mp::DownloadException{"", ""}));
 
     EXPECT_TRUE(host.info_for(query));
+    EXPECT_TRUE(host.info_for(query));
 }
 
 TEST_F(CustomImageHost, handles_and_recovers_from_independent_server_failures)
 {
-    const auto ttl = 0h;
-    mp::CustomVMImageHost host{"x86_64", &mock_url_downloader, ttl};
-
-    const auto num_remotes = mpt::count_remotes(host);
+    const auto num_remotes = [this] {
+        mp::CustomVMImageHost host{"x86_64", &mock_url_downloader, default_ttl};
+        return mpt::count_remotes(host);
+    }();
     EXPECT_GT(num_remotes, 0u);
 
     for (size_t i = 0; i < num_remotes; ++i)
@@ -329,7 +324,10 @@ TEST_F(CustomImageHost, handles_and_recovers_from_independent_server_failures)
         }
         EXPECT_CALL(mock_url_downloader, last_modified(_)).Times(AnyNumber()).InSequence(seq);
 
-        EXPECT_EQ(mpt::count_remotes(host), num_remotes - i);
+        {
+            mp::CustomVMImageHost host{"x86_64", &mock_url_downloader, default_ttl};
+            EXPECT_EQ(mpt::count_remotes(host), num_remotes - i);
+        }
         EXPECT_TRUE(Mock::VerifyAndClearExpectations(&mock_url_downloader));
     }
 }
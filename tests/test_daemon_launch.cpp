@@ -102,3 +102,105 @@ TEST_F(TestDaemonLaunch, blueprintFoundMountsWorkspaceWithNameOverride)
     EXPECT_EQ(reply.workspaces_to_be_created_size(), 1);
     EXPECT_EQ(reply.workspaces_to_be_created(0), command_line_name);
 }
+
+TEST_F(TestDaemonLaunch, batchLaunchTagsRepliesWithInstanceNames)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(_, _)).Times(3);
+    EXPECT_CALL(*mock_factory, prepare_instance_image(_, _)).Times(3);
+
+    mp::Daemon daemon{config_builder.build()};
+
+    mp::LaunchRequest request;
+    request.set_instance_name("ci");
+    request.set_num_instances(3);
+    request.set_max_parallel(2);
+
+    std::mutex mutex;
+    std::map<std::string, std::string> launched;
+    NiceMock<mpt::MockServerReaderWriter<mp::LaunchReply, mp::LaunchRequest>> writer{};
+
+    EXPECT_CALL(writer, Write(_, _)).WillRepeatedly([&](const mp::LaunchReply& written_reply, auto) -> bool {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!written_reply.vm_instance_name().empty())
+            launched[written_reply.vm_instance_name()] = written_reply.instance_name();
+        return true;
+    });
+
+    auto status = call_daemon_slot(daemon, &mp::Daemon::launch, request, writer);
+
+    EXPECT_TRUE(status.ok());
+    EXPECT_THAT(launched, ElementsAre(Pair("ci-1", "ci-1"), Pair("ci-2", "ci-2"), Pair("ci-3", "ci-3")));
+}
+
+TEST_F(TestDaemonLaunch, batchLaunchRefusesRepeatedNames)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(_, _)).Times(0);
+
+    mp::Daemon daemon{config_builder.build()};
+
+    mp::LaunchRequest request;
+    request.add_instance_names("ci");
+    request.add_instance_names("ci");
+
+    NiceMock<mpt::MockServerReaderWriter<mp::LaunchReply, mp::LaunchRequest>> writer{};
+    auto status = call_daemon_slot(daemon, &mp::Daemon::launch, request, writer);
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::INVALID_ARGUMENT);
+    EXPECT_THAT(status.error_message(), HasSubstr("instance \"ci\" already exists"));
+}
+
+TEST_F(TestDaemonLaunch, batchLaunchRefusesTooManyInstances)
+{
+    auto mock_factory = use_a_mock_vm_factory();
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(_, _)).Times(0);
+
+    mp::Daemon daemon{config_builder.build()};
+
+    mp::LaunchRequest request;
+    request.set_instance_name("ci");
+    request.set_num_instances(1000);
+
+    NiceMock<mpt::MockServerReaderWriter<mp::LaunchReply, mp::LaunchRequest>> writer{};
+    auto status = call_daemon_slot(daemon, &mp::Daemon::launch, request, writer);
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::INVALID_ARGUMENT);
+    EXPECT_THAT(status.error_message(), HasSubstr("cannot launch more than"));
+}
+
+TEST_F(TestDaemonLaunch, batchLaunchRefusesBlueprintWithAliases)
+{
+    const std::string name{"ultimo-blueprint"};
+    static constexpr int num_cores = 4;
+    const auto mem_size = mp::MemorySize("4G");
+    const auto disk_space = mp::MemorySize("25G");
+    const std::string remote{"release"};
+    const std::string release{"focal"};
+    const std::pair<std::string, mp::AliasDefinition> alias{"an_alias", {name, "a_command", "map"}};
+
+    auto mock_factory = use_a_mock_vm_factory();
+    auto mock_blueprint_provider = std::make_unique<NiceMock<mpt::MockVMBlueprintProvider>>();
+
+    EXPECT_CALL(*mock_factory, create_virtual_machine(_, _)).Times(0);
+    EXPECT_CALL(*mock_blueprint_provider, name_from_blueprint(_)).WillRepeatedly(Return(name));
+    EXPECT_CALL(*mock_blueprint_provider, fetch_blueprint_for(_, _, _))
+        .WillRepeatedly(mpt::fetch_blueprint_for_lambda(num_cores, mem_size, disk_space, release, remote, alias));
+
+    config_builder.blueprint_provider = std::move(mock_blueprint_provider);
+
+    mp::Daemon daemon{config_builder.build()};
+
+    mp::LaunchRequest request;
+    request.set_image(name);
+    request.set_num_instances(2);
+
+    NiceMock<mpt::MockServerReaderWriter<mp::LaunchReply, mp::LaunchRequest>> writer{};
+    auto status = call_daemon_slot(daemon, &mp::Daemon::launch, request, writer);
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::INVALID_ARGUMENT);
+    EXPECT_THAT(status.error_message(), HasSubstr("defines aliases"));
+}
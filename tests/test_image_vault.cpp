@@ -20,6 +20,7 @@
 #include "file_operations.h"
 #include "mock_image_host.h"
 #include "mock_process_factory.h"
+#include "mock_url_downloader.h"
 #include "path.h"
 #include "stub_url_downloader.h"
 #include "temp_dir.h"
@@ -30,6 +31,7 @@
 
 #include <multipass/exceptions/aborted_download_exception.h>
 #include <multipass/exceptions/create_image_exception.h>
+#include <multipass/exceptions/download_exception.h>
 #include <multipass/format.h>
 #include <multipass/query.h>
 #include <multipass/url_downloader.h>
@@ -59,6 +61,12 @@ struct BadURLDownloader : public mp::URLDownloader
         mpt::make_file_with_content(file_name, "Bad hash");
     }
 
+    void stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                   const mp::ProgressMonitor&) override
+    {
+        sink("Bad hash");
+    }
+
     QByteArray download(const QUrl& url) override
     {
         return {};
@@ -78,6 +86,12 @@ struct HttpURLDownloader : public mp::URLDownloader
         downloaded_files << file_name;
     }
 
+    void stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                   const mp::ProgressMonitor&) override
+    {
+        downloaded_urls << url.toString();
+    }
+
     QByteArray download(const QUrl& url) override
     {
         return {};
@@ -106,6 +120,12 @@ struct RunningURLDownloader : public mp::URLDownloader
         throw mp::AbortedDownloadException("Aborted!");
     }
 
+    void stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                   const mp::ProgressMonitor& monitor) override
+    {
+        download_to(url, {}, size, download_type, monitor);
+    }
+
     QByteArray download(const QUrl& url) override
     {
         return {};
@@ -174,7 +194,7 @@ TEST_F(ImageVault, downloads_image)
     mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
     auto vm_image = vault.fetch_image(mp::FetchType::ImageOnly, default_query, stub_prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_TRUE(url_downloader.downloaded_urls.contains(host.image.url()));
 }
 
@@ -191,7 +211,7 @@ TEST_F(ImageVault, downloads_kernel_and_initrd)
     mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
     auto vm_image = vault.fetch_image(mp::FetchType::ImageKernelAndInitrd, default_query, stub_prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(3));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(3));
     EXPECT_TRUE(url_downloader.downloaded_urls.contains(host.image.url()));
     EXPECT_TRUE(url_downloader.downloaded_urls.contains(host.kernel.url()));
     EXPECT_TRUE(url_downloader.downloaded_urls.contains(host.initrd.url()));
@@ -225,7 +245,7 @@ TEST_F(ImageVault, records_instanced_images)
     auto vm_image1 = vault.fetch_image(mp::FetchType::ImageOnly, default_query, prepare, stub_monitor);
     auto vm_image2 = vault.fetch_image(mp::FetchType::ImageOnly, default_query, prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_THAT(prepare_called_count, Eq(1));
     EXPECT_THAT(vm_image1.image_path, Eq(vm_image2.image_path));
     EXPECT_THAT(vm_image1.id, Eq(vm_image2.id));
@@ -245,7 +265,7 @@ TEST_F(ImageVault, caches_prepared_images)
     another_query.name = "valley-pied-piper-chat";
     auto vm_image2 = vault.fetch_image(mp::FetchType::ImageOnly, another_query, prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_THAT(prepare_called_count, Eq(1));
 
     EXPECT_THAT(vm_image1.image_path, Ne(vm_image2.image_path));
@@ -266,7 +286,7 @@ TEST_F(ImageVault, remembers_instance_images)
     mp::DefaultVMImageVault another_vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
     auto vm_image2 = another_vault.fetch_image(mp::FetchType::ImageOnly, default_query, prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_THAT(prepare_called_count, Eq(1));
     EXPECT_THAT(vm_image1.image_path, Eq(vm_image2.image_path));
 }
@@ -287,7 +307,7 @@ TEST_F(ImageVault, remembers_prepared_images)
     mp::DefaultVMImageVault another_vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
     auto vm_image2 = another_vault.fetch_image(mp::FetchType::ImageOnly, another_query, prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_THAT(prepare_called_count, Eq(1));
     EXPECT_THAT(vm_image1.image_path, Ne(vm_image2.image_path));
     EXPECT_THAT(vm_image1.id, Eq(vm_image2.id));
@@ -385,6 +405,38 @@ TEST_F(ImageVault, DISABLE_ON_WINDOWS_AND_MACOS(file_based_fetch_copies_image_an
     EXPECT_EQ(vm_image.id, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
 }
 
+TEST_F(ImageVault, DISABLE_ON_WINDOWS_AND_MACOS(backfills_missing_release_in_background_and_remembers_it))
+{
+    mpt::TempFile file;
+    auto query = default_query;
+    query.release = file.url().toStdString();
+    query.query_type = mp::Query::Type::LocalFile;
+
+    std::string id;
+    {
+        mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
+        auto vm_image = vault.fetch_image(mp::FetchType::ImageOnly, query, stub_prepare, stub_monitor);
+        ASSERT_TRUE(vm_image.original_release.empty());
+        id = vm_image.id;
+    }
+
+    auto info = host.mock_bionic_image_info;
+    EXPECT_CALL(host, info_for_full_hash(id)).WillOnce(Return(info));
+
+    {
+        // Loading starts the lookup and destruction waits for it
+        mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
+        vault.fetch_image(mp::FetchType::ImageOnly, query, stub_prepare, stub_monitor);
+    }
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
+        auto vm_image = vault.fetch_image(mp::FetchType::ImageOnly, query, stub_prepare, stub_monitor);
+        EXPECT_EQ(vm_image.original_release, info.release_title.toStdString());
+    }
+}
+
 TEST_F(ImageVault, invalid_custom_image_file_throws)
 {
     mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
@@ -406,18 +458,43 @@ TEST_F(ImageVault, DISABLE_ON_WINDOWS_AND_MACOS(custom_image_url_downloads))
 
     vault.fetch_image(mp::FetchType::ImageOnly, query, stub_prepare, stub_monitor);
 
-    EXPECT_THAT(url_downloader.downloaded_files.size(), Eq(1));
+    EXPECT_THAT(url_downloader.downloaded_urls.size(), Eq(1));
     EXPECT_TRUE(url_downloader.downloaded_urls.contains(QString::fromStdString(query.release)));
 }
 
-TEST_F(ImageVault, missing_downloaded_image_throws)
+TEST_F(ImageVault, failed_download_throws)
 {
-    mpt::StubURLDownloader stub_url_downloader;
-    mp::DefaultVMImageVault vault{hosts, &stub_url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
+    NiceMock<mpt::MockURLDownloader> mock_url_downloader;
+    EXPECT_CALL(mock_url_downloader, stream_to)
+        .WillOnce(Throw(mp::DownloadException{host.image.url().toStdString(), "failed"}));
+
+    mp::DefaultVMImageVault vault{hosts, &mock_url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
     EXPECT_THROW(vault.fetch_image(mp::FetchType::ImageOnly, default_query, stub_prepare, stub_monitor),
                  mp::CreateImageException);
 }
 
+TEST_F(ImageVault, decompresses_xz_image_while_downloading)
+{
+    const std::string xz_image{"\xfd\x37\x7a\x58\x5a\x00\x00\x04\xe6\xd6\xb4\x46\x02\x00\x21\x01\x16\x00\x00\x00\x74"
+                               "\x2f\xe5\xa3\x01\x00\x11\x64\x65\x63\x6f\x6d\x70\x72\x65\x73\x73\x65\x64\x20\x69\x6d"
+                               "\x61\x67\x65\x00\x00\x00\x46\x06\x64\xb2\x9a\x81\xc4\x52\x00\x01\x2a\x12\x4b\x08\x54"
+                               "\xbc\x1f\xb6\xf3\x7d\x01\x00\x00\x00\x00\x04\x59\x5a",
+                               76};
+    mpt::TrackingURLDownloader xz_url_downloader{xz_image};
+    host.mock_bionic_image_info.image_location += ".xz";
+    host.mock_bionic_image_info.id = "f6aa682d92477763117ef76507dbde571b640dd504324c6f4c0ce45038e9d1f9";
+
+    mp::DefaultVMImageVault vault{hosts, &xz_url_downloader, cache_dir.path(), data_dir.path(), mp::days{0}};
+    auto vm_image = vault.fetch_image(mp::FetchType::ImageOnly, default_query, stub_prepare, stub_monitor);
+
+    EXPECT_FALSE(vm_image.image_path.endsWith(".xz"));
+    EXPECT_FALSE(QFileInfo::exists(vm_image.image_path + ".xz"));
+
+    QFile image_file{vm_image.image_path};
+    ASSERT_TRUE(image_file.open(QIODevice::ReadOnly));
+    EXPECT_EQ(image_file.readAll(), "decompressed image");
+}
+
 TEST_F(ImageVault, hash_mismatch_throws)
 {
     BadURLDownloader bad_url_downloader;
@@ -482,10 +559,16 @@ TEST_F(ImageVault, DISABLE_ON_WINDOWS_AND_MACOS(http_download_returns_expected_i
 
 TEST_F(ImageVault, image_update_creates_new_dir_and_removes_old)
 {
+    QStringList prepared_files;
+    mp::VMImageVault::PrepareAction recording_prepare = [&prepared_files](const mp::VMImage& source_image) {
+        prepared_files << source_image.image_path;
+        return source_image;
+    };
+
     mp::DefaultVMImageVault vault{hosts, &url_downloader, cache_dir.path(), data_dir.path(), mp::days{1}};
-    vault.fetch_image(mp::FetchType::ImageOnly, default_query, stub_prepare, stub_monitor);
+    vault.fetch_image(mp::FetchType::ImageOnly, default_query, recording_prepare, stub_monitor);
 
-    auto original_file{url_downloader.downloaded_files[0]};
+    auto original_file{prepared_files[0]};
     auto original_absolute_path{QFileInfo(original_file).absolutePath()};
     EXPECT_TRUE(QFileInfo::exists(original_file));
     EXPECT_TRUE(original_absolute_path.contains(mpt::default_version));
@@ -496,9 +579,9 @@ TEST_F(ImageVault, image_update_creates_new_dir_and_removes_old)
     host.mock_bionic_image_info.version = new_date_string;
     host.mock_bionic_image_info.verify = false;
 
-    vault.update_images(mp::FetchType::ImageOnly, stub_prepare, stub_monitor);
+    vault.update_images(mp::FetchType::ImageOnly, recording_prepare, stub_monitor);
 
-    auto updated_file{url_downloader.downloaded_files[1]};
+    auto updated_file{prepared_files[1]};
     EXPECT_TRUE(QFileInfo::exists(updated_file));
     EXPECT_TRUE(QFileInfo(updated_file).absolutePath().contains(new_date_string));
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <src/daemon/instance_metrics.h>
+
+#include <chrono>
+
+namespace mp = multipass;
+
+using namespace testing;
+
+namespace
+{
+struct InstanceMetrics : public Test
+{
+    mp::InstanceMetrics collect()
+    {
+        ++collections;
+
+        mp::InstanceMetrics metrics;
+        metrics.load = std::to_string(collections);
+        return metrics;
+    }
+
+    int collections{0};
+};
+} // namespace
+
+TEST_F(InstanceMetrics, parses_collector_output)
+{
+    const auto output = "load=0.52 0.58 0.59\n"
+                        "memory_total=2079461376\n"
+                        "memory_used=170528768\n"
+                        "disk_total=5019643904\n"
+                        "disk_used=1516052480\n"
+                        "cpu_count=2\n"
+                        "release=Ubuntu 22.04.1 LTS\n";
+
+    auto metrics = mp::parse_instance_metrics(output);
+
+    EXPECT_EQ(metrics.load, "0.52 0.58 0.59");
+    EXPECT_EQ(metrics.memory_total, "2079461376");
+    EXPECT_EQ(metrics.memory_usage, "170528768");
+    EXPECT_EQ(metrics.disk_total, "5019643904");
+    EXPECT_EQ(metrics.disk_usage, "1516052480");
+    EXPECT_EQ(metrics.cpu_count, "2");
+    EXPECT_EQ(metrics.current_release, "Ubuntu 22.04.1 LTS");
+}
+
+TEST_F(InstanceMetrics, leaves_missing_metrics_empty)
+{
+    auto metrics = mp::parse_instance_metrics("garbage\ncpu_count=4\nunknown=1\n");
+
+    EXPECT_EQ(metrics.cpu_count, "4");
+    EXPECT_THAT(metrics.load, IsEmpty());
+    EXPECT_THAT(metrics.current_release, IsEmpty());
+}
+
+TEST_F(InstanceMetrics, cache_reuses_fresh_metrics)
+{
+    mp::InstanceMetricsCache cache{std::chrono::minutes(1)};
+
+    cache.get("foo", [this] { return collect(); });
+    auto metrics = cache.get("foo", [this] { return collect(); });
+
+    EXPECT_EQ(collections, 1);
+    EXPECT_EQ(metrics.load, "1");
+}
+
+TEST_F(InstanceMetrics, cache_keeps_instances_apart)
+{
+    mp::InstanceMetricsCache cache{std::chrono::minutes(1)};
+
+    cache.get("foo", [this] { return collect(); });
+    auto metrics = cache.get("bar", [this] { return collect(); });
+
+    EXPECT_EQ(collections, 2);
+    EXPECT_EQ(metrics.load, "2");
+}
+
+TEST_F(InstanceMetrics, cache_collects_again_when_expired)
+{
+    mp::InstanceMetricsCache cache{std::chrono::milliseconds::zero()};
+
+    cache.get("foo", [this] { return collect(); });
+    auto metrics = cache.get("foo", [this] { return collect(); });
+
+    EXPECT_EQ(collections, 2);
+    EXPECT_EQ(metrics.load, "2");
+}
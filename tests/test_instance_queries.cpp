@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+
+#include <src/daemon/instance_queries.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace mp = multipass;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct InstanceQueries : public Test
+{
+    ~InstanceQueries()
+    {
+        release_blocked.set_value();
+        pool.waitForDone();
+    }
+
+    QThreadPool pool;
+    std::promise<void> release_blocked;
+    std::shared_future<void> blocked{release_blocked.get_future().share()};
+};
+} // namespace
+
+TEST_F(InstanceQueries, returns_all_results_in_order)
+{
+    std::vector<std::string> entries{"foo", "bar", "baz"};
+
+    auto results = mp::query_instances(
+        pool, entries, [](std::string& entry, const std::function<void()>&) { entry += "-done"; }, 5s);
+
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].entry, "foo-done");
+    EXPECT_EQ(results[1].entry, "bar-done");
+    EXPECT_EQ(results[2].entry, "baz-done");
+    EXPECT_TRUE(std::all_of(results.cbegin(), results.cend(), [](const auto& result) { return result.finished; }));
+}
+
+TEST_F(InstanceQueries, reports_query_errors)
+{
+    auto results = mp::query_instances(
+        pool, std::vector<std::string>{"foo"},
+        [](std::string&, const std::function<void()>&) { throw std::runtime_error{"no route to host"}; }, 5s);
+
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].finished);
+    EXPECT_EQ(results[0].error, "no route to host");
+}
+
+TEST_F(InstanceQueries, returns_published_data_when_query_times_out)
+{
+    auto blocked = this->blocked;
+    auto results = mp::query_instances(
+        pool, std::vector<std::string>{"fast", "slow"},
+        [blocked](std::string& entry, const std::function<void()>& publish) {
+            entry += "-partial";
+            publish();
+
+            if (entry == "slow-partial")
+                blocked.wait();
+
+            entry += "-complete";
+        },
+        100ms);
+
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_TRUE(results[0].finished);
+    EXPECT_EQ(results[0].entry, "fast-partial-complete");
+    EXPECT_FALSE(results[1].finished);
+    EXPECT_EQ(results[1].entry, "slow-partial");
+}
+
+TEST_F(InstanceQueries, gives_up_on_queries_that_wait_too_long_for_a_thread)
+{
+    pool.setMaxThreadCount(1);
+
+    auto blocked = this->blocked;
+    std::atomic<int> started{0};
+    auto results = mp::query_instances(
+        pool, std::vector<std::string>{"first", "second"},
+        [blocked, &started](std::string&, const std::function<void()>&) {
+            ++started;
+            blocked.wait();
+        },
+        100ms);
+
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_FALSE(results[0].finished);
+    EXPECT_FALSE(results[1].finished);
+
+    release_blocked.set_value();
+    release_blocked = {};
+    pool.waitForDone();
+
+    EXPECT_EQ(started, 1);
+}
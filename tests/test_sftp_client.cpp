@@ -28,6 +28,8 @@
 #include <multipass/ssh/sftp_client.h>
 #include <multipass/ssh/ssh_session.h>
 
+#include <chrono>
+
 namespace mp = multipass;
 namespace mpt = multipass::test;
 namespace mpl = multipass::logging;
@@ -68,9 +70,9 @@ struct SFTPClient : public testing::Test
         close.returnValue(SSH_OK);
     }
 
-    static mp::SFTPClient make_sftp_client()
+    static mp::SFTPClient make_sftp_client(const mp::SFTPTransferOptions& options = {1, 1})
     {
-        return {std::make_unique<mp::SSHSession>("b", 43)};
+        return {std::make_unique<mp::SSHSession>("b", 43), options};
     }
 
     decltype(MOCK(sftp_close)) close{MOCK(sftp_close)};
@@ -296,6 +298,89 @@ TEST_F(SFTPClient, pull_file_success)
     EXPECT_EQ(static_cast<fs::perms>(perms), written_perms);
 }
 
+TEST_F(SFTPClient, pull_file_keeps_reads_in_flight)
+{
+    std::string test_data(65536 + 10, 'a');
+
+    REPLACE(sftp_init, [](auto...) { return SSH_OK; });
+    EXPECT_CALL(*mock_sftp_utils, get_local_file_target(source_path, target_path, _)).WillOnce(Return(target_path));
+
+    std::stringstream test_file;
+    auto tee_stream = std::make_unique<Poco::TeeOutputStream>();
+    tee_stream->addStream(test_file);
+    EXPECT_CALL(*mock_file_ops, open_write(target_path)).WillOnce(Return(std::move(tee_stream)));
+    REPLACE(sftp_open, [](auto sftp, auto...) { return get_dummy_sftp_file(sftp); });
+
+    int requested = 0, answered = 0;
+    REPLACE(sftp_async_read_begin, [&](auto...) { return requested++; });
+    auto mocked_sftp_async_read = [&](auto, void* data, auto size, auto id) -> int {
+        ++answered;
+        const auto offset = static_cast<size_t>(id) * size;
+        const auto r = offset < test_data.size() ? std::min<size_t>(size, test_data.size() - offset) : 0;
+        memcpy(data, test_data.data() + offset, r);
+        return r;
+    };
+    REPLACE(sftp_async_read, mocked_sftp_async_read);
+
+    REPLACE(sftp_stat, [&](auto...) { return get_dummy_sftp_attr(SSH_FILEXFER_TYPE_REGULAR, "", 0777); });
+    EXPECT_CALL(*mock_file_ops, permissions(target_path, _, _));
+
+    auto sftp_client = make_sftp_client({4, 1});
+
+    EXPECT_TRUE(sftp_client.pull(source_path, target_path));
+    EXPECT_EQ(test_data, test_file.str());
+    EXPECT_EQ(requested, 5);
+    EXPECT_EQ(answered, requested);
+}
+
+TEST_F(SFTPClient, pull_file_reads_the_rest_after_short_read)
+{
+    std::string test_data(3 * 65536, 'a');
+    for (auto i = 0u; i < test_data.size(); ++i)
+        test_data[i] = static_cast<char>('a' + i % 26);
+
+    REPLACE(sftp_init, [](auto...) { return SSH_OK; });
+    EXPECT_CALL(*mock_sftp_utils, get_local_file_target(source_path, target_path, _)).WillOnce(Return(target_path));
+
+    std::stringstream test_file;
+    auto tee_stream = std::make_unique<Poco::TeeOutputStream>();
+    tee_stream->addStream(test_file);
+    EXPECT_CALL(*mock_file_ops, open_write(target_path)).WillOnce(Return(std::move(tee_stream)));
+    REPLACE(sftp_open, [](auto sftp, auto...) { return get_dummy_sftp_file(sftp); });
+
+    // The second chunk comes back short, although the file goes on
+    int requested = 0;
+    REPLACE(sftp_async_read_begin, [&](auto...) { return requested++; });
+    auto mocked_sftp_async_read = [&](auto, void* data, auto size, auto id) -> int {
+        const auto offset = static_cast<size_t>(id) * size;
+        const auto r = id == 1 ? 10 : offset < test_data.size() ? std::min<size_t>(size, test_data.size() - offset) : 0;
+        memcpy(data, test_data.data() + offset, r);
+        return r;
+    };
+    REPLACE(sftp_async_read, mocked_sftp_async_read);
+
+    uint64_t read_offset{0};
+    REPLACE(sftp_seek64, [&](auto, auto offset) {
+        read_offset = offset;
+        return 0;
+    });
+    auto mocked_sftp_read = [&](auto, void* data, auto size) -> ssize_t {
+        const auto r = std::min<size_t>(size, test_data.size() - read_offset);
+        memcpy(data, test_data.data() + read_offset, r);
+        read_offset += r;
+        return r;
+    };
+    REPLACE(sftp_read, mocked_sftp_read);
+
+    REPLACE(sftp_stat, [&](auto...) { return get_dummy_sftp_attr(SSH_FILEXFER_TYPE_REGULAR, "", 0777); });
+    EXPECT_CALL(*mock_file_ops, permissions(target_path, _, _));
+
+    auto sftp_client = make_sftp_client({4, 1});
+
+    EXPECT_TRUE(sftp_client.pull(source_path, target_path));
+    EXPECT_EQ(test_data, test_file.str());
+}
+
 TEST_F(SFTPClient, pull_file_cannot_open_source)
 {
     REPLACE(sftp_init, [](auto...) { return SSH_OK; });
@@ -704,6 +789,125 @@ TEST_F(SFTPClient, push_dir_r_not_specified)
     EXPECT_FALSE(sftp_client.push(source_path, target_path));
 }
 
+TEST_F(SFTPClient, push_sync_skips_unchanged_file)
+{
+    const auto mtime = fs::file_time_type::clock::now();
+
+    REPLACE(sftp_init, [](auto...) { return SSH_OK; });
+    EXPECT_CALL(*mock_file_ops, is_directory(source_path, _)).WillOnce(Return(false));
+    EXPECT_CALL(*mock_sftp_utils, get_remote_file_target(_, source_path, target_path, _)).WillOnce(Return(target_path));
+    EXPECT_CALL(*mock_file_ops, file_size(source_path, _)).WillOnce(Return(9));
+    EXPECT_CALL(*mock_file_ops, last_write_time(source_path, _)).WillOnce(Return(mtime));
+    REPLACE(sftp_stat, [&](auto...) {
+        auto attr = get_dummy_sftp_attr();
+        attr->size = 9;
+        attr->mtime = std::chrono::duration_cast<std::chrono::seconds>(
+                          (mtime - fs::file_time_type::clock::now() + std::chrono::system_clock::now())
+                              .time_since_epoch())
+                          .count();
+        return attr;
+    });
+    REPLACE(sftp_open, [](auto...) {
+        ADD_FAILURE() << "unchanged file was sent";
+        return nullptr;
+    });
+
+    auto sftp_client = make_sftp_client();
+
+    EXPECT_TRUE(sftp_client.push(source_path, target_path, mp::SFTPClient::Flag::Sync));
+}
+
+TEST_F(SFTPClient, push_sync_sends_whole_file_when_instance_lacks_python)
+{
+    std::string test_data = "test_data";
+
+    REPLACE(sftp_init, [](auto...) { return SSH_OK; });
+    EXPECT_CALL(*mock_file_ops, is_directory(source_path, _)).WillOnce(Return(false));
+    EXPECT_CALL(*mock_sftp_utils, get_remote_file_target(_, source_path, target_path, _)).WillOnce(Return(target_path));
+    EXPECT_CALL(*mock_file_ops, file_size(source_path, _)).WillOnce(Return(test_data.size()));
+    EXPECT_CALL(*mock_file_ops, last_write_time(source_path, _)).WillOnce(Return(fs::file_time_type::clock::now()));
+    REPLACE(sftp_stat, [](auto...) {
+        auto attr = get_dummy_sftp_attr();
+        attr->size = 4;
+        return attr;
+    });
+    REPLACE(ssh_channel_get_exit_status, [](auto...) { return 127; });
+
+    EXPECT_CALL(*mock_file_ops, open_read(source_path))
+        .WillOnce(Return(std::make_unique<std::stringstream>(test_data)));
+    REPLACE(sftp_open, [](auto sftp, auto...) { return get_dummy_sftp_file(sftp); });
+    std::string written_data;
+    REPLACE(sftp_write, [&](auto, auto data, auto size) { return written_data.append((char*)data, size).size(); });
+    EXPECT_CALL(*mock_file_ops, status(source_path, _))
+        .WillOnce(Return(fs::file_status{fs::file_type::regular, fs::perms::all}));
+    REPLACE(sftp_chmod, [](auto...) { return SSH_FX_OK; });
+    REPLACE(sftp_utimes, [](auto...) { return SSH_FX_OK; });
+
+    auto sftp_client = make_sftp_client();
+
+    mock_logger->expect_log(mpl::Level::debug, "python3 is not available");
+    EXPECT_TRUE(sftp_client.push(source_path, target_path, mp::SFTPClient::Flag::Sync));
+    EXPECT_EQ(written_data, test_data);
+}
+
+TEST_F(SFTPClient, push_dir_sync_deletes_extraneous_remote_entries)
+{
+    REPLACE(sftp_init, [](auto...) { return SSH_OK; });
+    EXPECT_CALL(*mock_file_ops, is_directory(source_path, _)).WillOnce(Return(true));
+    EXPECT_CALL(*mock_sftp_utils, get_remote_dir_target(_, source_path, target_path, _)).WillOnce(Return(target_path));
+
+    auto local_iter = std::make_unique<mpt::MockRecursiveDirIterator>();
+    auto local_iter_p = local_iter.get();
+    EXPECT_CALL(*mock_file_ops, recursive_dir_iterator(source_path, _)).WillOnce(Return(std::move(local_iter)));
+    EXPECT_CALL(*local_iter_p, hasNext).WillOnce(Return(true)).WillRepeatedly(Return(false));
+
+    mpt::MockDirectoryEntry entry;
+    auto status = fs::file_status{fs::file_type::directory, fs::perms::all};
+    fs::path path{source_path / "dir"};
+    EXPECT_CALL(entry, path).WillRepeatedly(ReturnRef(path));
+    EXPECT_CALL(entry, symlink_status()).WillRepeatedly(Return(status));
+    EXPECT_CALL(*local_iter_p, next).WillOnce(ReturnRef(entry));
+    REPLACE(sftp_mkdir, [](auto...) { return SSH_FX_OK; });
+    REPLACE(sftp_chmod, [](auto...) { return SSH_FX_OK; });
+
+    auto remote_iter = std::make_unique<mpt::MockSFTPDirIterator>();
+    auto remote_iter_p = remote_iter.get();
+    EXPECT_CALL(*mock_sftp_utils, make_SFTPDirIterator(_, target_path)).WillOnce(Return(std::move(remote_iter)));
+    EXPECT_CALL(*remote_iter_p, hasNext)
+        .WillOnce(Return(true))
+        .WillOnce(Return(true))
+        .WillOnce(Return(true))
+        .WillOnce(Return(true))
+        .WillRepeatedly(Return(false));
+    EXPECT_CALL(*remote_iter_p, next)
+        .WillOnce(Return(std::unique_ptr<sftp_attributes_struct>(
+            get_dummy_sftp_attr(SSH_FILEXFER_TYPE_DIRECTORY, target_path / "dir"))))
+        .WillOnce(Return(std::unique_ptr<sftp_attributes_struct>(
+            get_dummy_sftp_attr(SSH_FILEXFER_TYPE_DIRECTORY, target_path / "old_dir"))))
+        .WillOnce(Return(std::unique_ptr<sftp_attributes_struct>(
+            get_dummy_sftp_attr(SSH_FILEXFER_TYPE_REGULAR, target_path / "old_dir" / "file"))))
+        .WillOnce(Return(std::unique_ptr<sftp_attributes_struct>(
+            get_dummy_sftp_attr(SSH_FILEXFER_TYPE_REGULAR, target_path / "stale"))));
+
+    std::vector<std::string> deleted;
+    REPLACE(sftp_unlink, [&](auto, const char* path) {
+        deleted.emplace_back(path);
+        return SSH_FX_OK;
+    });
+    REPLACE(sftp_rmdir, [&](auto, const char* path) {
+        deleted.emplace_back(path);
+        return SSH_FX_OK;
+    });
+
+    auto sftp_client = make_sftp_client();
+
+    EXPECT_TRUE(sftp_client.push(source_path, target_path,
+                                 mp::SFTPClient::Flag::Recursive | mp::SFTPClient::Flag::Sync |
+                                     mp::SFTPClient::Flag::Delete));
+    EXPECT_THAT(deleted, ElementsAre((target_path / "stale").u8string(), (target_path / "old_dir" / "file").u8string(),
+                                     (target_path / "old_dir").u8string()));
+}
+
 TEST_F(SFTPClient, pull_dir_success_regular)
 {
     REPLACE(sftp_init, [](auto...) { return SSH_OK; });
@@ -33,7 +33,14 @@
 #include <multipass/platform.h>
 #include <multipass/ssh/ssh_session.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 namespace mp = multipass;
 namespace mpl = multipass::logging;
@@ -92,8 +99,33 @@ struct SftpServer : public mp::test::SftpServerTest
         return reply_status;
     }
 
+    auto capture_channel_callbacks()
+    {
+        return [this](ssh_channel, ssh_channel_callbacks cb) {
+            channel_cbs = cb;
+            return SSH_OK;
+        };
+    }
+
+    // In worker pool mode messages are only read once libssh has seen them arrive in full. This stands in for the
+    // session taking in data, with the first num_arrived() queued messages there and the start of the next one
+    auto make_channel_data(std::function<std::size_t()> num_arrived)
+    {
+        return [this, num_arrived, num_queued = messages.size()](auto...) {
+            std::vector<unsigned char> buffered;
+            for (auto i = num_queued - messages.size(); i < num_arrived(); ++i)
+                buffered.insert(buffered.end(), {0, 0, 0, 1, SFTP_BAD_MESSAGE});
+            buffered.insert(buffered.end(), {0, 0, 0, 9, SFTP_BAD_MESSAGE});
+
+            channel_cbs->channel_data_function(nullptr, nullptr, buffered.data(),
+                                               static_cast<uint32_t>(buffered.size()), 0, channel_cbs->userdata);
+            return SSH_OK;
+        };
+    }
+
     mpt::ExitStatusMock exit_status_mock;
     std::queue<sftp_client_message> messages;
+    ssh_channel_callbacks channel_cbs{nullptr};
     int default_id{1000};
     mpt::MockLogger::Scope logger_scope = mpt::MockLogger::inject();
 };
@@ -210,6 +242,43 @@ auto make_data(const std::string& in)
     return out;
 }
 
+// Builds libssh's copy of a whole extended request, starting with its id and method name
+struct ExtendedPayload
+{
+    explicit ExtendedPayload(const std::string& method)
+    {
+        u32(0).string(method);
+    }
+
+    ExtendedPayload& string(const std::string& value)
+    {
+        u32(value.size());
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        return *this;
+    }
+
+    ExtendedPayload& u32(uint32_t value)
+    {
+        for (auto shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back(static_cast<unsigned char>(value >> shift));
+        return *this;
+    }
+
+    ExtendedPayload& u64(uint64_t value)
+    {
+        return u32(value >> 32).u32(static_cast<uint32_t>(value));
+    }
+
+    auto buffer() const
+    {
+        std::unique_ptr<ssh_buffer_struct, void (*)(ssh_buffer)> out{ssh_buffer_new(), ssh_buffer_free};
+        ssh_buffer_add_data(out.get(), bytes.data(), bytes.size());
+        return out;
+    }
+
+    std::vector<unsigned char> bytes;
+};
+
 bool content_match(const QString& path, const std::string& data)
 {
     auto content = mpt::load(path);
@@ -260,10 +329,48 @@ bool compare_permission(uint32_t ssh_permissions, const QFileInfo& file, Permiss
 
 TEST_F(SftpServer, throws_when_failed_to_init)
 {
-    REPLACE(sftp_server_init, [](auto...) { return SSH_ERROR; });
+    REPLACE(ssh_channel_read, [](auto...) { return SSH_ERROR; });
     EXPECT_THROW(make_sftpserver(), std::runtime_error);
 }
 
+TEST_F(SftpServer, advertises_handled_extensions)
+{
+    std::vector<std::string> extensions;
+    int num_calls{0};
+    auto channel_write = [&extensions, &num_calls](ssh_channel, const void* data, uint32_t len) {
+        const auto bytes = static_cast<const unsigned char*>(data);
+        auto read_u32 = [bytes](uint32_t pos) {
+            return uint32_t{bytes[pos]} << 24 | uint32_t{bytes[pos + 1]} << 16 | uint32_t{bytes[pos + 2]} << 8 |
+                   uint32_t{bytes[pos + 3]};
+        };
+
+        // length, type and version, followed by name and version pairs
+        EXPECT_THAT(read_u32(0), Eq(len - 4));
+        EXPECT_THAT(bytes[4], Eq(SSH_FXP_VERSION));
+        EXPECT_THAT(read_u32(5), Eq(static_cast<uint32_t>(LIBSFTP_VERSION)));
+
+        for (uint32_t pos = 9, field = 0; pos + 4 <= len; ++field)
+        {
+            const auto size = read_u32(pos);
+            if (field % 2 == 0)
+                extensions.emplace_back(reinterpret_cast<const char*>(bytes + pos + 4), size);
+            pos += 4 + size;
+        }
+
+        ++num_calls;
+        return static_cast<int>(len);
+    };
+
+    REPLACE(ssh_channel_write, channel_write);
+
+    auto sftp = make_sftpserver();
+
+    EXPECT_THAT(num_calls, Eq(1));
+    EXPECT_THAT(extensions, UnorderedElementsAre("posix-rename@openssh.com", "statvfs@openssh.com",
+                                                 "fstatvfs@openssh.com", "hardlink@openssh.com", "fsync@openssh.com",
+                                                 "copy-data"));
+}
+
 TEST_F(SftpServer, throws_when_sshfs_errors_on_start)
 {
     bool invoked{false};
@@ -339,6 +446,226 @@ TEST_F(SftpServer, frees_message)
     msg_free.expectCalled(1).withValues(msg.get());
 }
 
+TEST_F(SftpServer, worker_threads_reply_to_all_messages)
+{
+    mp::SftpServerOptions options;
+    options.worker_threads = 2;
+
+    mp::SSHSession session{"a", 42};
+    mp::SftpServer sftp{std::move(session), "", "", {}, {}, default_id, default_id, "sshfs", options};
+
+    std::vector<std::unique_ptr<sftp_client_message_struct>> msgs;
+    for (auto i = 0; i < 4; ++i)
+        msgs.push_back(make_msg(SFTP_BAD_MESSAGE));
+
+    std::mutex mutex;
+    int num_replies{0}, num_freed{0};
+    REPLACE(ssh_add_channel_callbacks, capture_channel_callbacks());
+    REPLACE(ssh_event_dopoll, make_channel_data([] { return 4u; }));
+    REPLACE(ssh_channel_poll, [](auto...) { return 0; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_status, [&sftp, &mutex, &num_replies](sftp_client_message, uint32_t status, const char*) {
+        EXPECT_THAT(status, Eq(SSH_FX_OP_UNSUPPORTED));
+        std::lock_guard<std::mutex> lock{mutex};
+        if (++num_replies == 4)
+            sftp.stop();
+        return SSH_OK;
+    });
+    REPLACE(sftp_client_message_free, [&mutex, &num_freed](auto...) {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++num_freed;
+    });
+
+    sftp.run();
+
+    EXPECT_THAT(num_replies, Eq(4));
+    EXPECT_THAT(num_freed, Eq(4));
+}
+
+TEST_F(SftpServer, worker_threads_overlap_requests_on_different_handles)
+{
+    mpt::TempDir temp_dir;
+    mp::SftpServerOptions options;
+    options.worker_threads = 2;
+
+    mp::SSHSession session{"a", 42};
+    mp::SftpServer sftp{std::move(session),
+                        temp_dir.path().toStdString(),
+                        temp_dir.path().toStdString(),
+                        {},
+                        {},
+                        default_id,
+                        default_id,
+                        "sshfs",
+                        options};
+
+    // Requests on a handle go to the worker its hash picks, so the handles are chosen to land on different ones
+    const std::string first_handle{"a"};
+    auto second_handle = first_handle;
+    while (std::hash<std::string>{}(second_handle) % 2 == std::hash<std::string>{}(first_handle) % 2)
+        ++second_handle[0];
+
+    const auto first_name = temp_dir.path() + "/first";
+    const auto second_name = temp_dir.path() + "/second";
+    sftp_attributes_struct attr{};
+    attr.permissions = 0777;
+
+    std::vector<std::unique_ptr<sftp_client_message_struct>> opens;
+    std::vector<std::vector<char>> names;
+    for (const auto& file_name : {first_name, second_name})
+    {
+        names.push_back(name_as_char_array(file_name.toStdString()));
+        opens.push_back(make_msg(SFTP_OPEN));
+        opens.back()->id = static_cast<uint32_t>(opens.size());
+        opens.back()->filename = names.back().data();
+        opens.back()->attr = &attr;
+        opens.back()->flags |= SSH_FXF_WRITE | SSH_FXF_TRUNC;
+    }
+
+    auto write_first = make_msg(SFTP_WRITE);
+    StringUPtr first_handle_string{ssh_string_from_char(first_handle.c_str()), ssh_string_free};
+    auto first_data = make_data("first");
+    write_first->id = 3;
+    write_first->handle = first_handle_string.get();
+    write_first->data = first_data.get();
+
+    auto write_second = make_msg(SFTP_WRITE);
+    StringUPtr second_handle_string{ssh_string_from_char(second_handle.c_str()), ssh_string_free};
+    auto second_data = make_data("second");
+    write_second->id = 4;
+    write_second->handle = second_handle_string.get();
+    write_second->data = second_data.get();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, void*> ids;
+    std::vector<uint32_t> replied_ids;
+    std::atomic<std::size_t> num_arrived{2};
+
+    auto [mock_file_ops, guard] = mpt::MockFileOps::inject();
+    EXPECT_CALL(*mock_file_ops, open(_, _)).WillRepeatedly([](QFileDevice& file, QIODevice::OpenMode mode) {
+        return file.open(mode);
+    });
+    EXPECT_CALL(*mock_file_ops, setPermissions(_, _)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock_file_ops, seek(_, _)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock_file_ops, write(A<QFile&>(), _, _))
+        .WillRepeatedly([&mutex, &cv, &replied_ids, &first_name](QFile& file, const char* data, qint64 len) {
+            // The write on the first handle holds out until the one on the second has been answered
+            if (file.fileName() == first_name)
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&replied_ids] {
+                    return std::find(replied_ids.begin(), replied_ids.end(), 4u) != replied_ids.end();
+                }));
+            }
+            return file.write(data, len);
+        });
+
+    auto handle_alloc = [&mutex, &ids, &first_handle, &second_handle, &first_name](sftp_session, void* info) {
+        const auto& handle = static_cast<QFile*>(info)->fileName() == first_name ? first_handle : second_handle;
+        std::lock_guard<std::mutex> lock{mutex};
+        ids[handle] = info;
+        return ssh_string_from_char(handle.c_str());
+    };
+    auto find_id = [&mutex, &ids](sftp_session, ssh_string handle) {
+        std::lock_guard<std::mutex> lock{mutex};
+        return ids[std::string{ssh_string_get_char(handle), ssh_string_len(handle)}];
+    };
+    auto reply_handle = [&mutex, &replied_ids, &num_arrived](sftp_client_message msg, ssh_string) {
+        std::lock_guard<std::mutex> lock{mutex};
+        replied_ids.push_back(msg->id);
+        if (replied_ids.size() == 2)
+            num_arrived = 4;
+        return SSH_OK;
+    };
+    auto reply_status = [&sftp, &mutex, &cv, &replied_ids](sftp_client_message msg, uint32_t status, const char*) {
+        EXPECT_THAT(status, Eq(SSH_FX_OK));
+        std::lock_guard<std::mutex> lock{mutex};
+        replied_ids.push_back(msg->id);
+        cv.notify_all();
+        if (replied_ids.size() == 4)
+            sftp.stop();
+        return SSH_OK;
+    };
+
+    REPLACE(ssh_add_channel_callbacks, capture_channel_callbacks());
+    REPLACE(ssh_event_dopoll, make_channel_data([&num_arrived] { return num_arrived.load(); }));
+    REPLACE(ssh_channel_poll, [](auto...) { return 0; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, find_id);
+    REPLACE(sftp_reply_handle, reply_handle);
+    REPLACE(sftp_reply_status, reply_status);
+
+    sftp.run();
+
+    EXPECT_THAT(replied_ids, ElementsAre(AnyOf(1u, 2u), AnyOf(1u, 2u), 4u, 3u));
+    EXPECT_TRUE(content_match(first_name, "first"));
+    EXPECT_TRUE(content_match(second_name, "second"));
+}
+
+TEST_F(SftpServer, worker_threads_route_extended_requests_by_their_handle)
+{
+    mp::SftpServerOptions options;
+    options.worker_threads = 2;
+
+    mp::SSHSession session{"a", 42};
+    mp::SftpServer sftp{std::move(session), "", "", {}, {}, default_id, default_id, "sshfs", options};
+
+    // libssh leaves the handle out of these, so they only stay in order with the writes on it if routed by the one
+    // in their payload
+    const std::string handle{"a"};
+    StringUPtr handle_string{ssh_string_from_char(handle.c_str()), ssh_string_free};
+    auto data = make_data("data");
+    auto fsync_submessage = name_as_char_array("fsync@openssh.com");
+    auto fsync_payload = ExtendedPayload{"fsync@openssh.com"}.string(handle).buffer();
+    auto fstatvfs_submessage = name_as_char_array("fstatvfs@openssh.com");
+    auto fstatvfs_payload = ExtendedPayload{"fstatvfs@openssh.com"}.string(handle).buffer();
+
+    std::vector<std::unique_ptr<sftp_client_message_struct>> msgs;
+    for (auto i = 0; i < 3; ++i)
+    {
+        msgs.push_back(make_msg(SFTP_WRITE));
+        msgs.back()->handle = handle_string.get();
+        msgs.back()->data = data.get();
+
+        msgs.push_back(make_msg(SFTP_EXTENDED));
+        msgs.back()->submessage = fsync_submessage.data();
+        msgs.back()->complete_message = fsync_payload.get();
+
+        msgs.push_back(make_msg(SFTP_EXTENDED));
+        msgs.back()->submessage = fstatvfs_submessage.data();
+        msgs.back()->complete_message = fstatvfs_payload.get();
+    }
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    int num_replies{0};
+    auto find_id = [&mutex, &threads](auto...) -> void* {
+        std::lock_guard<std::mutex> lock{mutex};
+        threads.insert(std::this_thread::get_id());
+        return nullptr;
+    };
+    auto reply_status = [&sftp, &mutex, &num_replies, &msgs](sftp_client_message, uint32_t, const char*) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (++num_replies == static_cast<int>(msgs.size()))
+            sftp.stop();
+        return SSH_OK;
+    };
+
+    REPLACE(ssh_add_channel_callbacks, capture_channel_callbacks());
+    REPLACE(ssh_event_dopoll, make_channel_data([&msgs] { return msgs.size(); }));
+    REPLACE(ssh_channel_poll, [](auto...) { return 0; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_handle, find_id);
+    REPLACE(sftp_reply_status, reply_status);
+
+    sftp.run();
+
+    EXPECT_THAT(num_replies, Eq(9));
+    EXPECT_THAT(threads.size(), Eq(1u));
+}
+
 TEST_F(SftpServer, handles_realpath)
 {
     mpt::TempFile file;
@@ -1242,6 +1569,59 @@ TEST_F(SftpServer, handles_readdir)
     EXPECT_THAT(entries, ContainerEq(expected_entries));
 }
 
+TEST_F(SftpServer, readdir_packs_entries_up_to_configured_count)
+{
+    mpt::TempDir temp_dir;
+    for (auto i = 0; i < 120; ++i)
+        mpt::make_file_with_content(temp_dir.path() + QString("/file-%1").arg(i));
+
+    mp::SftpServerOptions options;
+    options.readdir_max_entries = 100;
+
+    mp::SSHSession session{"a", 42};
+    const auto path = temp_dir.path().toStdString();
+    mp::SftpServer sftp{std::move(session), path, path, {}, {}, default_id, default_id, "sshfs", options};
+
+    auto open_dir_msg = make_msg(SFTP_OPENDIR);
+    auto dir_name = name_as_char_array(path);
+    open_dir_msg->filename = dir_name.data();
+
+    std::vector<std::unique_ptr<sftp_client_message_struct>> readdir_msgs;
+    for (auto i = 0; i < 3; ++i)
+        readdir_msgs.push_back(make_msg(SFTP_READDIR));
+
+    void* id{nullptr};
+    auto handle_alloc = [&id](sftp_session, void* info) {
+        id = info;
+        return ssh_string_new(4);
+    };
+
+    int eof_num_calls{0};
+    auto reply_status = make_reply_status(readdir_msgs.back().get(), SSH_FX_EOF, eof_num_calls);
+
+    int entries_in_reply{0};
+    std::vector<int> reply_sizes;
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, [&id](auto...) { return id; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_status, reply_status);
+    REPLACE(sftp_reply_names_add, [&entries_in_reply](auto...) {
+        ++entries_in_reply;
+        return SSH_OK;
+    });
+    REPLACE(sftp_reply_names, [&entries_in_reply, &reply_sizes](auto...) {
+        reply_sizes.push_back(entries_in_reply);
+        entries_in_reply = 0;
+        return SSH_OK;
+    });
+
+    sftp.run();
+
+    EXPECT_THAT(eof_num_calls, Eq(1));
+    EXPECT_THAT(reply_sizes, ElementsAre(100, 22)); // including "." and ".."
+}
+
 TEST_F(SftpServer, handles_readdir_attributes_preserved)
 {
     mpt::TempDir temp_dir;
@@ -1701,6 +2081,120 @@ TEST_F(SftpServer, handles_writes)
     EXPECT_TRUE(content_match(file_name, "The answer is always 42"));
 }
 
+TEST_F(SftpServer, write_behind_buffers_adjacent_writes_until_close)
+{
+    mpt::TempDir temp_dir;
+    auto file_name = temp_dir.path() + "/test-file";
+
+    mp::SftpServerOptions options;
+    options.write_behind_bytes = 4096;
+
+    mp::SSHSession session{"a", 42};
+    const auto path = temp_dir.path().toStdString();
+    mp::SftpServer sftp{std::move(session), path, path, {}, {}, default_id, default_id, "sshfs", options};
+
+    auto open_msg = make_msg(SFTP_OPEN);
+    auto name = name_as_char_array(file_name.toStdString());
+    sftp_attributes_struct attr{};
+    attr.permissions = 0777;
+
+    open_msg->filename = name.data();
+    open_msg->attr = &attr;
+    open_msg->flags |= SSH_FXF_WRITE | SSH_FXF_TRUNC;
+
+    auto write_msg1 = make_msg(SFTP_WRITE);
+    auto data1 = make_data("The answer is ");
+    write_msg1->data = data1.get();
+    write_msg1->offset = 0;
+
+    auto write_msg2 = make_msg(SFTP_WRITE);
+    auto data2 = make_data("always 42");
+    write_msg2->data = data2.get();
+    write_msg2->offset = ssh_string_len(data1.get());
+
+    auto close_msg = make_msg(SFTP_CLOSE);
+
+    void* id{nullptr};
+    auto handle_alloc = [&id](sftp_session, void* info) {
+        id = info;
+        return ssh_string_new(4);
+    };
+
+    int num_calls{0};
+    auto reply_status = [&num_calls, &close_msg, &file_name](sftp_client_message msg, uint32_t status, const char*) {
+        EXPECT_TRUE(status == SSH_FX_OK);
+        if (msg != close_msg.get())
+            EXPECT_TRUE(content_match(file_name, ""));
+        ++num_calls;
+        return SSH_OK;
+    };
+
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, [&id](auto...) { return id; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_status, reply_status);
+
+    sftp.run();
+
+    ASSERT_THAT(num_calls, Eq(3));
+    EXPECT_TRUE(content_match(file_name, "The answer is always 42"));
+}
+
+TEST_F(SftpServer, write_behind_writes_out_buffered_data_before_path_stat)
+{
+    mpt::TempDir temp_dir;
+    auto file_name = temp_dir.path() + "/test-file";
+
+    mp::SftpServerOptions options;
+    options.write_behind_bytes = 4096;
+
+    mp::SSHSession session{"a", 42};
+    const auto path = temp_dir.path().toStdString();
+    mp::SftpServer sftp{std::move(session), path, path, {}, {}, default_id, default_id, "sshfs", options};
+
+    auto open_msg = make_msg(SFTP_OPEN);
+    auto name = name_as_char_array(file_name.toStdString());
+    sftp_attributes_struct attr{};
+    attr.permissions = 0777;
+
+    open_msg->filename = name.data();
+    open_msg->attr = &attr;
+    open_msg->flags |= SSH_FXF_WRITE | SSH_FXF_TRUNC;
+
+    const std::string content{"The answer is always 42"};
+    auto write_msg = make_msg(SFTP_WRITE);
+    auto data = make_data(content);
+    write_msg->data = data.get();
+    write_msg->offset = 0;
+
+    auto stat_msg = make_msg(SFTP_STAT);
+    stat_msg->filename = name.data();
+
+    void* id{nullptr};
+    auto handle_alloc = [&id](sftp_session, void* info) {
+        id = info;
+        return ssh_string_new(4);
+    };
+
+    uint64_t stat_size{0};
+    auto reply_attr = [&stat_size](sftp_client_message, sftp_attributes attr) {
+        stat_size = attr->size;
+        return SSH_OK;
+    };
+
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, [&id](auto...) { return id; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_attr, reply_attr);
+
+    sftp.run();
+
+    EXPECT_THAT(stat_size, Eq(content.size()));
+    EXPECT_TRUE(content_match(file_name, content));
+}
+
 TEST_F(SftpServer, write_cannot_seek_fails)
 {
     const int seek_pos{10};
@@ -1855,6 +2349,48 @@ TEST_F(SftpServer, handles_reads)
     ASSERT_THAT(num_calls, Eq(1));
 }
 
+TEST_F(SftpServer, handles_reads_larger_than_64k)
+{
+    mpt::TempDir temp_dir;
+    auto file_name = temp_dir.path() + "/test-file";
+    const std::string content(200000, 'x');
+    mpt::make_file_with_content(file_name, content);
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    auto open_msg = make_msg(SFTP_OPEN);
+    auto name = name_as_char_array(file_name.toStdString());
+    open_msg->filename = name.data();
+    open_msg->flags |= SSH_FXF_READ;
+
+    auto read_msg = make_msg(SFTP_READ);
+    read_msg->offset = 0;
+    read_msg->len = content.size();
+
+    void* id{nullptr};
+    auto handle_alloc = [&id](sftp_session, void* info) {
+        id = info;
+        return ssh_string_new(4);
+    };
+
+    int num_calls{0};
+    auto reply_data = [&num_calls, &content](sftp_client_message, const void* data, int len) {
+        EXPECT_THAT(len, Eq(static_cast<int>(content.size())));
+        EXPECT_TRUE(std::equal(content.begin(), content.end(), reinterpret_cast<const char*>(data)));
+        ++num_calls;
+        return SSH_OK;
+    };
+
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, [&id](auto...) { return id; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_data, reply_data);
+
+    sftp.run();
+
+    ASSERT_THAT(num_calls, Eq(1));
+}
+
 TEST_F(SftpServer, read_cannot_seek_fails)
 {
     const int seek_pos{10};
@@ -2160,6 +2696,132 @@ TEST_F(SftpServer, invalid_extended_fails)
     EXPECT_THAT(num_calls, Eq(1));
 }
 
+TEST_F(SftpServer, handles_statvfs)
+{
+    mpt::TempDir temp_dir;
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    auto msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("statvfs@openssh.com");
+    msg->submessage = submessage.data();
+    auto payload = ExtendedPayload{"statvfs@openssh.com"}.string(temp_dir.path().toStdString()).buffer();
+    msg->complete_message = payload.get();
+    sftp_session_struct session{};
+    msg->sftp = &session;
+
+    int num_calls{0};
+    auto channel_write = [&num_calls](ssh_channel, const void* data, uint32_t len) {
+        // length, type and request id, followed by eleven 64-bit fields
+        EXPECT_THAT(len, Eq(4u + 1u + 4u + 11u * 8u));
+        EXPECT_THAT(static_cast<const uint8_t*>(data)[4], Eq(SSH_FXP_EXTENDED_REPLY));
+        ++num_calls;
+        return static_cast<int>(len);
+    };
+
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(ssh_channel_write, channel_write);
+
+    sftp.run();
+
+    EXPECT_THAT(num_calls, Eq(1));
+}
+
+TEST_F(SftpServer, handles_fsync)
+{
+    mpt::TempDir temp_dir;
+    auto file_name = temp_dir.path() + "/test-file";
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    auto open_msg = make_msg(SFTP_OPEN);
+    auto name = name_as_char_array(file_name.toStdString());
+    sftp_attributes_struct attr{};
+    attr.permissions = 0777;
+    open_msg->filename = name.data();
+    open_msg->attr = &attr;
+    open_msg->flags |= SSH_FXF_WRITE | SSH_FXF_CREAT;
+
+    auto fsync_msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("fsync@openssh.com");
+    fsync_msg->submessage = submessage.data();
+    auto payload = ExtendedPayload{"fsync@openssh.com"}.string("1234").buffer();
+    fsync_msg->complete_message = payload.get();
+
+    void* id{nullptr};
+    auto handle_alloc = [&id](sftp_session, void* info) {
+        id = info;
+        return ssh_string_new(4);
+    };
+
+    int num_calls{0};
+    auto reply_status = make_reply_status(fsync_msg.get(), SSH_FX_OK, num_calls);
+
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, [&id](auto...) { return id; });
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_status, reply_status);
+
+    sftp.run();
+
+    EXPECT_THAT(num_calls, Eq(1));
+}
+
+TEST_F(SftpServer, handles_copy_data)
+{
+    mpt::TempDir temp_dir;
+    auto source_name = temp_dir.path() + "/source-file";
+    auto target_name = temp_dir.path() + "/target-file";
+    mpt::make_file_with_content(source_name, "The answer is always 42");
+
+    auto sftp = make_sftpserver(temp_dir.path().toStdString());
+    sftp_attributes_struct attr{};
+    attr.permissions = 0777;
+
+    auto open_source_msg = make_msg(SFTP_OPEN);
+    auto source = name_as_char_array(source_name.toStdString());
+    open_source_msg->filename = source.data();
+    open_source_msg->attr = &attr;
+    open_source_msg->flags |= SSH_FXF_READ;
+
+    auto open_target_msg = make_msg(SFTP_OPEN);
+    auto target = name_as_char_array(target_name.toStdString());
+    open_target_msg->filename = target.data();
+    open_target_msg->attr = &attr;
+    open_target_msg->flags |= SSH_FXF_WRITE | SSH_FXF_CREAT | SSH_FXF_TRUNC;
+
+    auto copy_msg = make_msg(SFTP_EXTENDED);
+    auto submessage = name_as_char_array("copy-data");
+    copy_msg->submessage = submessage.data();
+    auto payload = ExtendedPayload{"copy-data"}.string("0").u64(14).u64(0).string("1").u64(0).buffer();
+    copy_msg->complete_message = payload.get();
+
+    // Handles are the index of the file they were allocated for
+    std::vector<void*> ids;
+    auto handle_alloc = [&ids](sftp_session, void* info) {
+        const auto handle = std::to_string(ids.size());
+        ids.push_back(info);
+        return make_data(handle).release();
+    };
+    auto get_handle = [&ids](sftp_session, ssh_string handle) -> void* {
+        const auto index = std::stoul(std::string{ssh_string_get_char(handle), ssh_string_len(handle)});
+        return index < ids.size() ? ids[index] : nullptr;
+    };
+
+    int num_calls{0};
+    auto reply_status = make_reply_status(copy_msg.get(), SSH_FX_OK, num_calls);
+
+    REPLACE(sftp_reply_handle, [](auto...) { return SSH_OK; });
+    REPLACE(sftp_handle_alloc, handle_alloc);
+    REPLACE(sftp_handle, get_handle);
+    REPLACE(sftp_get_client_message, make_msg_handler());
+    REPLACE(sftp_reply_status, reply_status);
+
+    sftp.run();
+
+    EXPECT_THAT(num_calls, Eq(1));
+    EXPECT_TRUE(content_match(target_name, "always 42"));
+}
+
 TEST_P(Stat, handles)
 {
     mpt::TempDir temp_dir;
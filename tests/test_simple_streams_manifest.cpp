@@ -134,6 +134,63 @@ TEST_F(TestSimpleStreamsManifest, can_query_all_versions)
     }
 }
 
+TEST_F(TestSimpleStreamsManifest, indexes_all_products_by_id)
+{
+    auto json = mpt::load_test_file("releases/multiple_versions_manifest.json");
+    auto manifest = mp::SimpleStreamsManifest::fromJson(json, std::nullopt, "");
+
+    const auto& index = manifest->products_by_id;
+    ASSERT_EQ(index.size(), manifest->products.size());
+    EXPECT_TRUE(
+        std::is_sorted(index.cbegin(), index.cend(), [](const auto* a, const auto* b) { return a->id < b->id; }));
+
+    for (const auto& product : manifest->products)
+        EXPECT_THAT(index, Contains(&product));
+}
+
+TEST_F(TestSimpleStreamsManifest, binary_form_round_trips)
+{
+    auto json = mpt::load_test_file("releases/multiple_versions_manifest.json");
+    auto manifest = mp::SimpleStreamsManifest::fromJson(json, std::nullopt, "");
+
+    auto loaded = mp::SimpleStreamsManifest::fromBinary(manifest->toBinary());
+
+    EXPECT_EQ(loaded->updated_at, manifest->updated_at);
+    ASSERT_EQ(loaded->products.size(), manifest->products.size());
+    for (size_t i = 0; i < manifest->products.size(); ++i)
+    {
+        const auto& expected = manifest->products[i];
+        const auto& actual = loaded->products[i];
+        EXPECT_EQ(actual.aliases, expected.aliases);
+        EXPECT_EQ(actual.release_title, expected.release_title);
+        EXPECT_EQ(actual.image_location, expected.image_location);
+        EXPECT_EQ(actual.id, expected.id);
+        EXPECT_EQ(actual.version, expected.version);
+        EXPECT_EQ(actual.supported, expected.supported);
+        EXPECT_EQ(actual.size, expected.size);
+    }
+
+    EXPECT_EQ(loaded->image_records.keys().size(), manifest->image_records.keys().size());
+}
+
+TEST_F(TestSimpleStreamsManifest, binary_form_is_rejected_for_another_driver)
+{
+    auto json = mpt::load_test_file("good_manifest.json");
+    const auto data = mp::SimpleStreamsManifest::fromJson(json, std::nullopt, "")->toBinary();
+
+    EXPECT_CALL(mock_settings, get(Eq(mp::driver_key))).WillRepeatedly(Return("lxd"));
+    EXPECT_THROW(mp::SimpleStreamsManifest::fromBinary(data), mp::GenericManifestException);
+}
+
+TEST_F(TestSimpleStreamsManifest, corrupt_binary_form_throws)
+{
+    auto json = mpt::load_test_file("good_manifest.json");
+    const auto data = mp::SimpleStreamsManifest::fromJson(json, std::nullopt, "")->toBinary();
+
+    EXPECT_THROW(mp::SimpleStreamsManifest::fromBinary(data.left(data.size() / 2)), mp::GenericManifestException);
+    EXPECT_THROW(mp::SimpleStreamsManifest::fromBinary("garbage"), mp::GenericManifestException);
+}
+
 TEST_F(TestSimpleStreamsManifest, info_has_kernel_and_initrd_paths)
 {
     auto json = mpt::load_test_file("good_manifest.json");
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+#include "mock_ssh_test_fixture.h"
+#include "stub_ssh_key_provider.h"
+
+#include <multipass/exceptions/ssh_exception.h>
+#include <multipass/ssh/ssh_session_pool.h>
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+using namespace testing;
+
+namespace
+{
+struct SSHSessionPool : public Test
+{
+    mpt::MockSSHTestFixture mock_ssh_test_fixture;
+    mpt::StubSSHKeyProvider key_provider;
+    int connections{0};
+    std::function<int(ssh_session)> count_connections = [this](ssh_session) {
+        ++connections;
+        return SSH_OK;
+    };
+};
+} // namespace
+
+TEST_F(SSHSessionPool, reuses_released_session)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider};
+
+    {
+        auto lease = pool.acquire("host", 22, "ubuntu");
+        EXPECT_FALSE(lease.reused());
+    }
+
+    auto lease = pool.acquire("host", 22, "ubuntu");
+    EXPECT_TRUE(lease.reused());
+    EXPECT_EQ(connections, 1);
+}
+
+TEST_F(SSHSessionPool, does_not_share_leased_sessions)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider};
+
+    auto lease = pool.acquire("host", 22, "ubuntu");
+    auto other_lease = pool.acquire("host", 22, "ubuntu");
+
+    EXPECT_NE(&*lease, &*other_lease);
+    EXPECT_EQ(connections, 2);
+}
+
+TEST_F(SSHSessionPool, does_not_reuse_disconnected_session)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider};
+
+    pool.acquire("host", 22, "ubuntu");
+    REPLACE(ssh_is_connected, [](auto...) { return false; });
+    auto lease = pool.acquire("host", 22, "ubuntu");
+
+    EXPECT_FALSE(lease.reused());
+    EXPECT_EQ(connections, 2);
+}
+
+TEST_F(SSHSessionPool, drops_sessions_idle_for_too_long)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider, std::chrono::milliseconds::zero()};
+
+    pool.acquire("host", 22, "ubuntu");
+    auto lease = pool.acquire("host", 22, "ubuntu");
+
+    EXPECT_FALSE(lease.reused());
+    EXPECT_EQ(connections, 2);
+}
+
+TEST_F(SSHSessionPool, run_retries_failed_reused_session_over_new_connection)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider};
+    pool.run("host", 22, "ubuntu", [](mp::SSHSession&) {});
+
+    auto attempts = 0;
+    auto result = pool.run("host", 22, "ubuntu", [&attempts](mp::SSHSession&) {
+        if (++attempts == 1)
+            throw mp::SSHException("stale");
+        return 42;
+    });
+
+    EXPECT_EQ(result, 42);
+    EXPECT_EQ(attempts, 2);
+    EXPECT_EQ(connections, 2);
+}
+
+TEST_F(SSHSessionPool, run_does_not_retry_failed_new_session)
+{
+    REPLACE(ssh_connect, count_connections);
+    mp::SSHSessionPool pool{key_provider};
+
+    auto attempts = 0;
+    EXPECT_THROW(pool.run("host", 22, "ubuntu",
+                          [&attempts](mp::SSHSession&) {
+                              ++attempts;
+                              throw mp::SSHException("broken");
+                          }),
+                 mp::SSHException);
+
+    EXPECT_EQ(attempts, 1);
+}
@@ -22,6 +22,7 @@
 #include "mock_settings.h"
 #include "path.h"
 #include "stub_url_downloader.h"
+#include "temp_dir.h"
 
 #include <src/daemon/ubuntu_image_host.h>
 
@@ -361,7 +362,7 @@ TEST_F(UbuntuImageHost, handles_and_recovers_from_initial_network_failure)
     EXPECT_TRUE(host.info_for(query));
 }
 
-TEST_F(UbuntuImageHost, handles_and_recovers_from_later_network_failure)
+TEST_F(UbuntuImageHost, keeps_serving_cached_manifests_through_later_network_failure)
 {
     const auto ttl = 0s; // to ensure updates are always retried
     mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, ttl};
@@ -370,7 +371,8 @@ TEST_F(UbuntuImageHost, handles_and_recovers_from_later_network_failure)
     EXPECT_TRUE(host.info_for(query));
 
     url_downloader.mischiefs = 1000;
-    EXPECT_THROW(host.info_for(query), std::runtime_error);
+    EXPECT_TRUE(host.info_for(query));
+    EXPECT_TRUE(host.info_for(query));
 
     url_downloader.mischiefs = 0;
     EXPECT_TRUE(host.info_for(query));
@@ -378,19 +380,56 @@ TEST_F(UbuntuImageHost, handles_and_recovers_from_later_network_failure)
 
 TEST_F(UbuntuImageHost, handles_and_recovers_from_independent_server_failures)
 {
-    const auto ttl = 0h;
-    mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, ttl};
-
-    const auto num_remotes = mpt::count_remotes(host);
+    const auto num_remotes = [this] {
+        mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl};
+        return mpt::count_remotes(host);
+    }();
     EXPECT_GT(num_remotes, 0u);
 
     for (size_t i = 0; i < num_remotes; ++i)
     {
         url_downloader.mischiefs = i;
+        mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl};
         EXPECT_EQ(mpt::count_remotes(host), num_remotes - i);
     }
 }
 
+TEST_F(UbuntuImageHost, serves_cached_manifests_without_network_after_restart)
+{
+    mpt::TempDir cache_dir;
+    const auto query = make_query("xenial", release_remote_spec.first);
+
+    {
+        mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl, cache_dir.path()};
+        EXPECT_TRUE(host.info_for(query));
+    }
+
+    url_downloader.mischiefs = 1000;
+    mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl, cache_dir.path()};
+
+    auto info = host.info_for(query);
+    ASSERT_TRUE(info);
+    EXPECT_THAT(info->image_location, Eq(expected_location));
+    EXPECT_THAT(info->id, Eq(expected_id));
+}
+
+TEST_F(UbuntuImageHost, ignores_cached_manifests_older_than_time_to_live)
+{
+    mpt::TempDir cache_dir;
+    const auto query = make_query("xenial", release_remote_spec.first);
+
+    {
+        mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl, cache_dir.path()};
+        EXPECT_TRUE(host.info_for(query));
+    }
+
+    const auto ttl = 0s; // so that any cached manifest is too old
+    url_downloader.mischiefs = 1000;
+    mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, ttl, cache_dir.path()};
+
+    EXPECT_THROW(host.info_for(query), std::runtime_error);
+}
+
 TEST_F(UbuntuImageHost, throws_unsupported_image_when_image_not_supported)
 {
     mp::UbuntuVMImageHost host{all_remote_specs, &url_downloader, default_ttl};
@@ -23,6 +23,7 @@
 #include "mock_ssh.h"
 #include "mock_ssh_process_exit_status.h"
 #include "mock_ssh_test_fixture.h"
+#include "mock_utils.h"
 #include "mock_virtual_machine.h"
 #include "stub_ssh_key_provider.h"
 #include "temp_dir.h"
@@ -32,6 +33,7 @@
 #include <multipass/utils.h>
 #include <multipass/vm_image_vault.h>
 
+#include <QFile>
 #include <QRegExp>
 
 #include <gtest/gtest-death-test.h>
@@ -735,6 +737,33 @@ TEST(Utils, wait_for_cloud_init_cannot_connect_times_out)
                          mpt::match_what(StrEq("timed out waiting for initialization to complete")));
 }
 
+TEST(Utils, wait_until_ssh_up_retries_until_ssh_answers)
+{
+    auto [mock_utils, guard] = mpt::MockUtils::inject();
+    EXPECT_CALL(*mock_utils, is_ssh_answering(StrEq("localhost"), 42, _))
+        .WillOnce(Return(false))
+        .WillOnce(Return(true));
+
+    NiceMock<mpt::MockVirtualMachine> vm{"my_instance"};
+    EXPECT_CALL(vm, update_state());
+
+    mp::utils::wait_until_ssh_up(&vm, std::chrono::seconds(5));
+
+    EXPECT_EQ(vm.state, mp::VirtualMachine::State::running);
+}
+
+TEST(Utils, wait_until_ssh_up_times_out_if_ssh_does_not_answer)
+{
+    auto [mock_utils, guard] = mpt::MockUtils::inject();
+    EXPECT_CALL(*mock_utils, is_ssh_answering).WillRepeatedly(Return(false));
+
+    NiceMock<mpt::MockVirtualMachine> vm{"my_instance"};
+
+    MP_EXPECT_THROW_THAT(mp::utils::wait_until_ssh_up(&vm, std::chrono::milliseconds(1)), std::runtime_error,
+                         mpt::match_what(StrEq("my_instance: timed out waiting for response")));
+    EXPECT_EQ(vm.state, mp::VirtualMachine::State::unknown);
+}
+
 TEST(VaultUtils, copy_creates_new_file_and_returned_path_exists)
 {
     mpt::TempDir temp_dir1, temp_dir2;
@@ -747,6 +776,66 @@ TEST(VaultUtils, copy_creates_new_file_and_returned_path_exists)
     EXPECT_TRUE(QFile::exists(new_file_path));
 }
 
+// Whether the copy is a reflink clone depends on the filesystem the tests run on; either way it must behave as a copy
+TEST(VaultUtils, copy_keeps_contents)
+{
+    mpt::TempDir temp_dir1, temp_dir2;
+    auto orig_file_path = QDir(temp_dir1.path()).filePath("test_file");
+
+    mpt::make_file_with_content(orig_file_path, "some image data");
+
+    auto new_file_path = mp::vault::copy(orig_file_path, temp_dir2.path());
+
+    EXPECT_EQ(mpt::load(new_file_path), "some image data");
+}
+
+TEST(VaultUtils, copy_is_independent_of_source)
+{
+    mpt::TempDir temp_dir1, temp_dir2;
+    auto orig_file_path = QDir(temp_dir1.path()).filePath("test_file");
+
+    mpt::make_file_with_content(orig_file_path, "some image data");
+
+    auto new_file_path = mp::vault::copy(orig_file_path, temp_dir2.path());
+    QFile new_file{new_file_path};
+    ASSERT_TRUE(new_file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    new_file.write("changed by the instance");
+    new_file.close();
+
+    EXPECT_EQ(mpt::load(orig_file_path), "some image data");
+}
+
+TEST(VaultUtils, copy_leaves_existing_target_alone)
+{
+    mpt::TempDir temp_dir1, temp_dir2;
+    auto orig_file_path = QDir(temp_dir1.path()).filePath("test_file");
+    auto existing_file_path = QDir(temp_dir2.path()).filePath("test_file");
+
+    mpt::make_file_with_content(orig_file_path, "some image data");
+    mpt::make_file_with_content(existing_file_path, "already there");
+
+    EXPECT_EQ(mp::vault::copy(orig_file_path, temp_dir2.path()), existing_file_path);
+    EXPECT_EQ(mpt::load(existing_file_path), "already there");
+}
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+TEST(VaultUtils, copy_keeps_permissions)
+{
+    mpt::TempDir temp_dir1, temp_dir2;
+    auto orig_file_path = QDir(temp_dir1.path()).filePath("test_file");
+
+    mpt::make_file_with_content(orig_file_path);
+    const auto permissions = QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ReadGroup;
+    ASSERT_TRUE(QFile::setPermissions(orig_file_path, permissions));
+
+    auto new_file_path = mp::vault::copy(orig_file_path, temp_dir2.path());
+
+    // The user bits describe whoever runs the tests, not the file
+    const auto user_bits = QFileDevice::ReadUser | QFileDevice::WriteUser | QFileDevice::ExeUser;
+    EXPECT_EQ(QFile::permissions(new_file_path) & ~user_bits, permissions);
+}
+#endif
+
 TEST(VaultUtils, copy_returns_empty_path_when_file_name_is_empty)
 {
     mpt::TempDir temp_dir;
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2022 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common.h"
+#include "path.h"
+#include "temp_dir.h"
+
+#include <multipass/xz_image_decoder.h>
+
+#include <QFile>
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+#include <sys/stat.h>
+#endif
+
+namespace mp = multipass;
+namespace mpt = multipass::test;
+
+using namespace testing;
+
+namespace
+{
+// Both test files hold 12MiB, in three 4MiB stretches that start with 1MiB of data and end in zeros. The multi block
+// one was made with `xz --block-size=4MiB --check=crc64`, so each of its blocks fills the decoding buffer exactly
+constexpr qint64 mib = 1024 * 1024;
+constexpr qint64 expected_size = 12 * mib;
+
+char expected_byte_at(qint64 pos)
+{
+    const auto stretch = pos / (4 * mib);
+    return pos % (4 * mib) < mib ? static_cast<char>((pos * 7 + stretch) % 251 + 1) : 0;
+}
+
+struct XzImageDecoder : public Test
+{
+    QByteArray decode(const QString& xz_path)
+    {
+        const auto decoded_path = temp_dir.filePath("decoded.img");
+        mp::XzImageDecoder decoder{xz_path};
+        decoder.decode_to(decoded_path, [](int, int) { return true; });
+
+        QFile decoded{decoded_path};
+        EXPECT_TRUE(decoded.open(QIODevice::ReadOnly));
+        return decoded.readAll();
+    }
+
+    QString copy_of(const char* test_file)
+    {
+        const auto path = temp_dir.filePath(test_file);
+        EXPECT_TRUE(QFile::copy(mpt::test_data_path_for(test_file), path));
+        return path;
+    }
+
+    void flip_byte_at(const QString& path, qint64 pos)
+    {
+        QFile file{path};
+        ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+        ASSERT_TRUE(file.seek(pos));
+        auto byte = file.read(1);
+        byte[0] = static_cast<char>(byte[0] ^ 0x01);
+        ASSERT_TRUE(file.seek(pos));
+        ASSERT_EQ(file.write(byte), 1);
+    }
+
+    void expect_expected_content(const QByteArray& decoded)
+    {
+        ASSERT_EQ(decoded.size(), expected_size);
+        for (qint64 pos = 0; pos < expected_size; ++pos)
+            if (decoded[static_cast<int>(pos)] != expected_byte_at(pos))
+                FAIL() << "Unexpected byte at " << pos;
+    }
+
+    mpt::TempDir temp_dir;
+};
+} // namespace
+
+TEST_F(XzImageDecoder, finds_blocks_in_index)
+{
+    mp::XzImageDecoder decoder{mpt::test_data_path_for("multi_block_image.img.xz")};
+    const auto blocks = decoder.blocks();
+
+    ASSERT_EQ(blocks.size(), 3u);
+
+    qint64 offset = 12, decoded_offset = 0;
+    for (const auto& block : blocks)
+    {
+        EXPECT_EQ(block.offset, offset);
+        EXPECT_EQ(block.size % 4, 0);
+        EXPECT_GE(block.size, block.unpadded_size);
+        EXPECT_LT(block.size - block.unpadded_size, 4);
+        EXPECT_EQ(block.decoded_offset, decoded_offset);
+        EXPECT_EQ(block.decoded_size, 4 * mib);
+
+        offset += block.size;
+        decoded_offset += block.decoded_size;
+    }
+}
+
+TEST_F(XzImageDecoder, finds_no_blocks_without_usable_index)
+{
+    const auto path = copy_of("multi_block_image.img.xz");
+    QFile file{path};
+    ASSERT_TRUE(file.resize(file.size() - 2)); // drop the footer magic
+
+    mp::XzImageDecoder decoder{path};
+    EXPECT_THAT(decoder.blocks(), IsEmpty());
+}
+
+TEST_F(XzImageDecoder, parallel_decoding_matches_serial_decoding)
+{
+    const auto parallel = decode(mpt::test_data_path_for("multi_block_image.img.xz"));
+    expect_expected_content(parallel);
+
+    const auto serial_path = temp_dir.filePath("serial.img");
+    {
+        QFile xz_file{mpt::test_data_path_for("multi_block_image.img.xz")};
+        ASSERT_TRUE(xz_file.open(QIODevice::ReadOnly));
+        const auto data = xz_file.readAll();
+
+        mp::XzStreamDecoder decoder{serial_path};
+        EXPECT_TRUE(decoder.decode(data.constData(), data.size()));
+        decoder.finish();
+    }
+
+    QFile serial{serial_path};
+    ASSERT_TRUE(serial.open(QIODevice::ReadOnly));
+    EXPECT_EQ(parallel, serial.readAll());
+}
+
+TEST_F(XzImageDecoder, decodes_single_block_stream)
+{
+    expect_expected_content(decode(mpt::test_data_path_for("single_block_image.img.xz")));
+}
+
+TEST_F(XzImageDecoder, verifies_block_checks_in_parallel_decoding)
+{
+    const auto path = copy_of("multi_block_image.img.xz");
+
+    mp::XzImageDecoder decoder{path};
+    const auto block = decoder.blocks().front();
+    flip_byte_at(path, block.offset + block.unpadded_size - 1); // last byte of the CRC64 check
+
+    EXPECT_THROW(decode(path), std::runtime_error);
+}
+
+#ifndef MULTIPASS_PLATFORM_WINDOWS
+TEST_F(XzImageDecoder, leaves_holes_for_zeros)
+{
+    decode(mpt::test_data_path_for("multi_block_image.img.xz"));
+
+    struct stat decoded_stat;
+    ASSERT_EQ(stat(temp_dir.filePath("decoded.img").toStdString().c_str(), &decoded_stat), 0);
+
+    EXPECT_EQ(decoded_stat.st_size, expected_size);
+    EXPECT_LT(decoded_stat.st_blocks * 512, expected_size);
+}
+#endif
@@ -44,6 +44,13 @@ struct TrackingURLDownloader : public URLDownloader
         downloaded_files << file_name;
     }
 
+    void stream_to(const QUrl& url, const DataSink& sink, int64_t size, const int download_type,
+                   const ProgressMonitor&) override
+    {
+        sink(QByteArray::fromStdString(content));
+        downloaded_urls << url.toString();
+    }
+
     QByteArray download(const QUrl& url) override
     {
         return {};